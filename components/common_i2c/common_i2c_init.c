@@ -6,12 +6,25 @@
  * This module initializes a shared I2C bus and attaches two devices:
  *   - SSD1306 OLED display
  *   - BME280 environmental sensor
+ * Further BME280s (e.g. the second address, 0x77) can be attached with i2c_add_bme280().
  *
  * It exposes accessors for the bus handle and the two device handles
  * so they can be used in other modules without re-initializing the bus.
+ *
+ * Each device is attached at its Kconfig clock. With CONFIG_COMMON_I2C_SPEED_PROBE
+ * the clock is instead probed downwards from that value until the device passes
+ * a burst of test transactions, and the result is logged.
+ *
+ * Once the bus is up, the bus scheduler (i2c_sched.h) is started and the
+ * BME280 register callbacks are routed through it at high priority, so
+ * sensor reads are never stuck behind a display flush. Every attached device
+ * is registered with the scheduler's fault recovery.
  */
 
+#include <string.h>
+
 #include "common_i2c_init.h"
+#include "i2c_sched.h"
 #include "bme280_defs.h"
 #include "bme280_config.h"
 #include "ssd1306.h"
@@ -28,25 +41,163 @@ static const char* TAG = "COMMON_I2C";
 static i2c_master_bus_handle_t i2c_bus;
 static i2c_master_dev_handle_t sensor_i2c_dev;
 static i2c_master_dev_handle_t screen_i2c_dev;
+static uint32_t sensor_speed_hz;
+static uint32_t screen_speed_hz;
 
 const measurement_choice_t bme280_measurement_choice = FORCED_PERIODIC_ONE_TIME;
 
+#define BME280_SCHED_WRITE_MAX  20      /**< Largest interleaved reg/value burst the Bosch API writes */
+
+#define BME280_REG_CHIP_ID      0xD0
+#define BME280_CHIP_ID          0x60
+#define SSD1306_CMD_NOP         0xE3
+
+/** Clocks tried by the speed probe, fastest first */
+static const uint32_t speed_ladder[] = { CLK_SPEED_1MHZ, CLK_SPEED_800KHZ, CLK_SPEED_400KHZ, CLK_SPEED_100KHZ };
+
+typedef bool (*speed_check_t)(i2c_master_dev_handle_t dev);
+
+/**
+ * @brief Speed probe check for the BME280: the chip ID must read back intact every time.
+ */
+static bool bme280_speed_check(i2c_master_dev_handle_t dev)
+{
+    const uint8_t reg = BME280_REG_CHIP_ID;
+    for (int round = 0; round < CONFIG_COMMON_I2C_SPEED_PROBE_ROUNDS; ++round) {
+        uint8_t id = 0;
+        if (i2c_master_transmit_receive(dev, &reg, 1, &id, 1, I2C_TIMEOUT_MS) != ESP_OK || id != BME280_CHIP_ID) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Speed probe check for the SSD1306: every NOP command must be ACKed.
+ *
+ * The SSD1306 cannot be read over I2C, so ACKs are the only signal available:
+ * a clock that corrupts data bits but not the ACKs still passes.
+ */
+static bool ssd1306_speed_check(i2c_master_dev_handle_t dev)
+{
+    const uint8_t nop[] = { 0x00, SSD1306_CMD_NOP };
+    for (int round = 0; round < CONFIG_COMMON_I2C_SPEED_PROBE_ROUNDS; ++round) {
+        if (i2c_master_transmit(dev, nop, sizeof(nop), I2C_TIMEOUT_MS) != ESP_OK) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Attach a device to the shared bus at the fastest clock it handles.
+ *
+ * Without CONFIG_COMMON_I2C_SPEED_PROBE the device is attached at @p max_hz.
+ * Otherwise @p max_hz is tried first, then every lower clock in @ref speed_ladder,
+ * until @p check passes. If none passes, the device stays at the slowest clock
+ * and the driver init reports the actual failure.
+ *
+ * @param[in]  addr     7-bit device address.
+ * @param[in]  max_hz   Configured clock, upper bound of the probe.
+ * @param[in]  check    Test run at each candidate clock.
+ * @param[in]  name     Device name for the log.
+ * @param[out] dev      Attached device handle.
+ * @param[out] speed_hz Clock the device was attached with.
+ */
+static esp_err_t add_device_at_best_speed(uint16_t addr, uint32_t max_hz, speed_check_t check, const char *name,
+                                          i2c_master_dev_handle_t *dev, uint32_t *speed_hz)
+{
+    i2c_device_config_t cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = addr,
+        .scl_speed_hz = max_hz,
+    };
+
+#if CONFIG_COMMON_I2C_SPEED_PROBE
+    size_t next = 0;
+    while (1) {
+        ESP_RETURN_ON_ERROR(i2c_master_bus_add_device(i2c_bus, &cfg, dev), TAG, "%s add fail", name);
+        if (check(*dev)) {
+            break;
+        }
+
+        while (next < sizeof(speed_ladder) / sizeof(speed_ladder[0]) && speed_ladder[next] >= cfg.scl_speed_hz) {
+            ++next;
+        }
+        if (next == sizeof(speed_ladder) / sizeof(speed_ladder[0])) {
+            ESP_LOGW(TAG, "%s unstable at every clock, keeping %lu Hz", name, (unsigned long)cfg.scl_speed_hz);
+            break;
+        }
+
+        ESP_LOGW(TAG, "%s unstable at %lu Hz, falling back", name, (unsigned long)cfg.scl_speed_hz);
+        ESP_RETURN_ON_ERROR(i2c_master_bus_rm_device(*dev), TAG, "%s rm fail", name);
+        cfg.scl_speed_hz = speed_ladder[next];
+    }
+#else
+    (void)check;
+    ESP_RETURN_ON_ERROR(i2c_master_bus_add_device(i2c_bus, &cfg, dev), TAG, "%s add fail", name);
+#endif
+
+    *speed_hz = cfg.scl_speed_hz;
+    ESP_LOGI(TAG, "%s at 0x%02X: %lu Hz", name, addr, (unsigned long)cfg.scl_speed_hz);
+    return i2c_sched_add_device(*dev, addr, name);
+}
+
+/**
+ * @brief Bosch read callback: register address write + data read as one high-priority batch.
+ */
+static BME280_INTF_RET_TYPE bme280_sched_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    const i2c_sched_op_t op = {
+        .dev = (i2c_master_dev_handle_t)intf_ptr,
+        .tx = &reg_addr,
+        .tx_len = 1,
+        .rx = reg_data,
+        .rx_len = len,
+    };
+    return (i2c_sched_submit(&op, 1, I2C_SCHED_PRIO_HIGH) == ESP_OK) ? BME280_INTF_RET_SUCCESS : BME280_E_COMM_FAIL;
+}
+
+/**
+ * @brief Bosch write callback: address byte followed by the (interleaved) register data.
+ */
+static BME280_INTF_RET_TYPE bme280_sched_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    if (len > BME280_SCHED_WRITE_MAX) {
+        return BME280_E_COMM_FAIL;
+    }
+
+    uint8_t buf[BME280_SCHED_WRITE_MAX + 1];
+    buf[0] = reg_addr;
+    memcpy(&buf[1], reg_data, len);
+
+    const i2c_sched_op_t op = {
+        .dev = (i2c_master_dev_handle_t)intf_ptr,
+        .tx = buf,
+        .tx_len = len + 1,
+    };
+    return (i2c_sched_submit(&op, 1, I2C_SCHED_PRIO_HIGH) == ESP_OK) ? BME280_INTF_RET_SUCCESS : BME280_E_COMM_FAIL;
+}
+
 /**
- * @brief Initialize the BME280 sensor on the shared I2C bus.
+ * @brief Initialize a BME280 sensor on the shared I2C bus.
  *
  * @param bme280_device_handle Pointer to a BME280 device structure to initialize.
+ * @param sensor_i2c_dev       Device handle the sensor is attached with.
  *
  * @note This function:
- *   - Gets the I2C device handle from the shared bus.
  *   - Calls the low-level initialization routine.
+ *   - Routes register access through the bus scheduler at high priority.
  *   - Configures sensor settings according to the selected measurement mode.
  *
  * @warning Logs an error if sensor configuration fails.
  */
-static void init_sensor(struct bme280_dev *bme280_device_handle)
+static void init_sensor(struct bme280_dev *bme280_device_handle, i2c_master_dev_handle_t sensor_i2c_dev)
 {
-    i2c_master_dev_handle_t sensor_i2c_dev = i2c_get_bme280();
     bme280_device_init(bme280_device_handle, sensor_i2c_dev);
+    bme280_device_handle->intf_ptr = sensor_i2c_dev;
+    bme280_device_handle->read = bme280_sched_read;
+    bme280_device_handle->write = bme280_sched_write;
     int8_t rslt = configure_sensor_settings(bme280_measurement_choice, bme280_device_handle);
     if (rslt != BME280_OK){ ESP_LOGE("BME280", "configure_sensor_settings failed: %d", rslt);}
 }
@@ -73,7 +224,7 @@ static void init_screen(ssd1306_t *ssd1306_device_handle)
 
     i2c_device_t screen_dev = {
         .dev = i2c_get_ssd1306(),
-        .scl_speed_hz = CLK_SPEED_400KHZ,
+        .scl_speed_hz = screen_speed_hz,
         .addr7 = SSD1306_I2C_ADDR_DEFAULT
     };
 
@@ -83,17 +234,18 @@ static void init_screen(ssd1306_t *ssd1306_device_handle)
     ssd1306_link_t link = (ssd1306_link_t){0};
     ssd1306_link_from_device(&link, &screen_dev);
 
-    ESP_ERROR_CHECK(ssd1306_init(ssd1306_device_handle, &link, WIDTH, HEIGHT, /*external_vcc=*/false));    
+    ESP_ERROR_CHECK(ssd1306_init(ssd1306_device_handle, &link, SSD1306_PANEL_WIDTH, SSD1306_PANEL_HEIGHT, /*external_vcc=*/false));    
 
     char init_message[] = "Getting Data";
-    uint16_t horisontal_cursor = (WIDTH / 2) - ((sizeof(init_message) / 2) * 8);
-    uint16_t vertical_cursor = ((HEIGHT / 8) * 2);
+    uint16_t horisontal_cursor = (SSD1306_PANEL_WIDTH / 2) - ((sizeof(init_message) / 2) * 8);
+    uint16_t vertical_cursor = ((SSD1306_PANEL_HEIGHT / 8) * 2);
     ssd1306_set_cursor(ssd1306_device_handle, horisontal_cursor, vertical_cursor);
     ssd1306_draw_string(ssd1306_device_handle, init_message, &FONT_8x8, true);
     ESP_ERROR_CHECK(ssd1306_update(ssd1306_device_handle));
 }
 
-esp_err_t i2c_shared_init(struct bme280_dev *bme280_device_handle, ssd1306_t *ssd1306_device_handle) {
+esp_err_t i2c_shared_start(void)
+{
     if (i2c_bus) return ESP_OK;
 
     i2c_master_bus_config_t bus_cfg = {
@@ -106,26 +258,64 @@ esp_err_t i2c_shared_init(struct bme280_dev *bme280_device_handle, ssd1306_t *ss
     };
     ESP_RETURN_ON_ERROR(i2c_new_master_bus(&bus_cfg, &i2c_bus), TAG, "bus fail");
 
-    i2c_device_config_t ssd_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = SSD1306_I2C_ADDR_DEFAULT,
-        .scl_speed_hz = CLK_SPEED_400KHZ,
-    };
-    ESP_RETURN_ON_ERROR(i2c_master_bus_add_device(i2c_bus, &ssd_cfg, &screen_i2c_dev), TAG, "ssd fail");
+    ESP_RETURN_ON_ERROR(add_device_at_best_speed(SSD1306_I2C_ADDR_DEFAULT, SSD1306_SCL_SPEED_HZ,
+                                                 ssd1306_speed_check, "SSD1306",
+                                                 &screen_i2c_dev, &screen_speed_hz), TAG, "ssd fail");
 
-    i2c_device_config_t bme_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = BME280_I2C_ADDR_PRIM, /**< or 0x77 */
-        .scl_speed_hz = CLK_SPEED_400KHZ,
-    };
-    ESP_RETURN_ON_ERROR(i2c_master_bus_add_device(i2c_bus, &bme_cfg, &sensor_i2c_dev), TAG, "bme fail");
+    ESP_RETURN_ON_ERROR(add_device_at_best_speed(BME280_I2C_ADDR_PRIM, /**< or 0x77 */ BME280_SCL_SPEED_HZ,
+                                                 bme280_speed_check, "BME280",
+                                                 &sensor_i2c_dev, &sensor_speed_hz), TAG, "bme fail");
+
+    ESP_RETURN_ON_ERROR(i2c_sched_init(), TAG, "sched fail");
+    return ESP_OK;
+}
 
-    init_sensor(bme280_device_handle);
+esp_err_t i2c_shared_init_bme280(struct bme280_dev *bme280_device_handle)
+{
+    ESP_RETURN_ON_FALSE(sensor_i2c_dev, ESP_ERR_INVALID_STATE, TAG, "bus not initialized");
+    ESP_RETURN_ON_FALSE(bme280_device_handle, ESP_ERR_INVALID_ARG, TAG, "no device");
+    init_sensor(bme280_device_handle, sensor_i2c_dev);
+    return ESP_OK;
+}
+
+esp_err_t i2c_shared_init_ssd1306(ssd1306_t *ssd1306_device_handle)
+{
+    ESP_RETURN_ON_FALSE(screen_i2c_dev, ESP_ERR_INVALID_STATE, TAG, "bus not initialized");
+    ESP_RETURN_ON_FALSE(ssd1306_device_handle, ESP_ERR_INVALID_ARG, TAG, "no device");
     init_screen(ssd1306_device_handle);
+    return ESP_OK;
+}
+
+esp_err_t i2c_shared_init(struct bme280_dev *bme280_device_handle, ssd1306_t *ssd1306_device_handle) {
+    if (i2c_bus) return ESP_OK;
+
+    ESP_RETURN_ON_ERROR(i2c_shared_start(), TAG, "bus start fail");
+    ESP_RETURN_ON_ERROR(i2c_shared_init_bme280(bme280_device_handle), TAG, "bme init fail");
+    return i2c_shared_init_ssd1306(ssd1306_device_handle);
+}
+
+esp_err_t i2c_reconfigure_bme280(struct bme280_dev *bme280_device_handle)
+{
+    ESP_RETURN_ON_FALSE(bme280_device_handle && bme280_device_handle->intf_ptr, ESP_ERR_INVALID_ARG, TAG, "no device");
+    init_sensor(bme280_device_handle, (i2c_master_dev_handle_t)bme280_device_handle->intf_ptr);
+    return ESP_OK;
+}
+
+esp_err_t i2c_add_bme280(uint16_t addr, struct bme280_dev *bme280_device_handle)
+{
+    ESP_RETURN_ON_FALSE(i2c_bus, ESP_ERR_INVALID_STATE, TAG, "bus not initialized");
+    ESP_RETURN_ON_FALSE(bme280_device_handle, ESP_ERR_INVALID_ARG, TAG, "no device");
 
+    i2c_master_dev_handle_t dev;
+    uint32_t speed_hz;
+    ESP_RETURN_ON_ERROR(add_device_at_best_speed(addr, BME280_SCL_SPEED_HZ, bme280_speed_check, "BME280",
+                                                 &dev, &speed_hz), TAG, "bme fail");
+    init_sensor(bme280_device_handle, dev);
     return ESP_OK;
 }
 
 i2c_master_bus_handle_t i2c_get_bus(void) { return i2c_bus; }
 i2c_master_dev_handle_t i2c_get_bme280(void) { return sensor_i2c_dev; }
 i2c_master_dev_handle_t i2c_get_ssd1306(void) { return screen_i2c_dev; }
+uint32_t i2c_get_bme280_speed_hz(void) { return sensor_speed_hz; }
+uint32_t i2c_get_ssd1306_speed_hz(void) { return screen_speed_hz; }
@@ -0,0 +1,364 @@
+/**
+ * @file i2c_sched.c
+ * @brief Prioritized, batched transaction scheduler for the shared I2C bus.
+ *
+ * @details
+ * The SSD1306 and the BME280 share one i2c_master bus. The i2c_master driver
+ * serializes transactions but has no notion of priority, so a BME280 read
+ * issued while a frame is being flushed waits for the entire flush.
+ *
+ * Here every bus client hands its transactions to a single worker task as a
+ * batch. The worker keeps one FIFO per priority and checks the high FIFO
+ * before every op of a normal batch, so short sensor reads slip in between
+ * the page writes of a long display flush. Small command writes that share
+ * a control byte are merged into one transaction on the way out.
+ *
+ * Since every transaction passes through here, the worker also keeps the bus
+ * traffic counters reported by i2c_sched_get_stats(), and recovers from bus
+ * faults: retry, SCL clock-out, re-probe (see i2c_sched_add_device()). Owners
+ * learn about a recovered device from its epoch; the re-initialization itself
+ * runs in the owner's task, which is allowed to submit batches.
+ *
+ * A blocking submit keeps its job on the caller's stack and sleeps on
+ * @ref I2C_SCHED_NOTIFY_INDEX. An async submit uses caller-owned job storage
+ * and returns at once; completion is reported as event bits on index 0, so the
+ * caller can fold it into the same wait as its other events.
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "config.h"
+#include "common_i2c_init.h"
+#include "i2c_bus.h"
+#include "i2c_sched.h"
+
+static const char *TAG_SCHED = "I2C_SCHED";
+
+static TaskHandle_t s_worker;
+static QueueHandle_t s_queues[I2C_SCHED_PRIO_COUNT];
+
+static uint8_t s_merge_buf[I2C_SCHED_MERGE_MAX];
+
+/**
+ * @brief Recovery state of one registered device; only the worker writes it after bring-up.
+ */
+typedef struct {
+    i2c_master_dev_handle_t dev;
+    uint16_t addr;
+    const char *name;
+    volatile uint32_t epoch;    /**< Successful recoveries */
+    TickType_t offline_until;   /**< Fail fast until this tick after a failed re-probe */
+    bool offline;
+} sched_device_t;
+
+static sched_device_t s_devices[I2C_SCHED_MAX_DEVICES];
+static size_t s_device_count;
+
+/** Traffic counters; only the worker (or the inline boot path before it exists) writes them */
+static i2c_sched_stats_t s_stats;
+
+static void count_transaction(size_t tx_len, size_t rx_len, esp_err_t err)
+{
+    s_stats.transactions++;
+    s_stats.tx_bytes += tx_len;
+    s_stats.rx_bytes += rx_len;
+    if (err != ESP_OK) {
+        s_stats.errors++;
+    }
+}
+
+static bool op_can_merge(const i2c_sched_op_t *a, const i2c_sched_op_t *b)
+{
+    return (a->flags & I2C_SCHED_OP_MERGEABLE) && (b->flags & I2C_SCHED_OP_MERGEABLE) &&
+           a->dev == b->dev && a->rx_len == 0 && b->rx_len == 0 &&
+           a->tx_len > 0 && b->tx_len > 0 && a->tx[0] == b->tx[0];
+}
+
+static sched_device_t *find_device(i2c_master_dev_handle_t dev)
+{
+    for (size_t i = 0; i < s_device_count; ++i) {
+        if (s_devices[i].dev == dev) return &s_devices[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Clock out a stuck bus and check that @p d answers again.
+ *
+ * @return true if the device acknowledged its address.
+ */
+static bool recover_device(sched_device_t *d)
+{
+    s_stats.bus_resets++;
+    esp_err_t err = i2c_master_bus_reset(i2c_get_bus());
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG_SCHED, "bus reset fail: %s", esp_err_to_name(err));
+    }
+
+    const i2c_bus_t bus = { .bus = i2c_get_bus() };
+    if (i2c_device_probe(&bus, (uint8_t)d->addr, I2C_TIMEOUT_MS) != ESP_OK) {
+        s_stats.probe_failures++;
+        d->offline = true;
+        d->offline_until = xTaskGetTickCount() + pdMS_TO_TICKS(I2C_SCHED_OFFLINE_MS);
+        ESP_LOGE(TAG_SCHED, "%s (0x%02X) not answering, offline for %d ms", d->name, d->addr, I2C_SCHED_OFFLINE_MS);
+        return false;
+    }
+
+    s_stats.recoveries++;
+    d->offline = false;
+    d->epoch++;
+    ESP_LOGW(TAG_SCHED, "%s (0x%02X) recovered after bus reset", d->name, d->addr);
+    return true;
+}
+
+static esp_err_t transfer_once(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t tx_len,
+                               uint8_t *rx, size_t rx_len)
+{
+    esp_err_t err;
+    if (rx_len == 0) {
+        err = i2c_master_transmit(dev, tx, tx_len, I2C_TIMEOUT_MS);
+    } else if (tx_len == 0) {
+        err = i2c_master_receive(dev, rx, rx_len, I2C_TIMEOUT_MS);
+    } else {
+        err = i2c_master_transmit_receive(dev, tx, tx_len, rx, rx_len, I2C_TIMEOUT_MS);
+    }
+    count_transaction(tx_len, rx_len, err);
+    return err;
+}
+
+/**
+ * @brief One transaction with the fault handling described at i2c_sched_add_device().
+ */
+static esp_err_t transfer(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t tx_len,
+                          uint8_t *rx, size_t rx_len)
+{
+    sched_device_t *d = find_device(dev);
+    if (d && d->offline) {
+        if ((int32_t)(xTaskGetTickCount() - d->offline_until) < 0) {
+            s_stats.offline_skips++;
+            return ESP_ERR_NOT_FOUND;
+        }
+        if (!recover_device(d)) {
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
+
+    esp_err_t err = transfer_once(dev, tx, tx_len, rx, rx_len);
+    for (int attempt = 1; err != ESP_OK && attempt <= I2C_SCHED_RETRIES; ++attempt) {
+        s_stats.retries++;
+        if (d && attempt == I2C_SCHED_RETRIES && !recover_device(d)) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        err = transfer_once(dev, tx, tx_len, rx, rx_len);
+    }
+    return err;
+}
+
+static esp_err_t run_op(const i2c_sched_op_t *op)
+{
+    return transfer(op->dev, op->tx, op->tx_len, op->rx, op->rx_len);
+}
+
+/**
+ * @brief Run the next op of @p job, merging it with the following mergeable ops.
+ *
+ * Advances job->next past every op that went out in this transaction.
+ */
+static esp_err_t run_next(i2c_sched_job_t *job)
+{
+    const i2c_sched_op_t *first = &job->ops[job->next];
+
+    size_t last = job->next;
+    size_t merged_len = first->tx_len;
+    while (last + 1 < job->count && op_can_merge(first, &job->ops[last + 1]) &&
+           merged_len + job->ops[last + 1].tx_len - 1 <= sizeof(s_merge_buf)) {
+        merged_len += job->ops[++last].tx_len - 1;
+    }
+
+    if (last == job->next) {
+        job->next++;
+        return run_op(first);
+    }
+
+    // Control byte once, then each op's payload
+    size_t len = 0;
+    s_merge_buf[len++] = first->tx[0];
+    for (size_t i = job->next; i <= last; ++i) {
+        memcpy(&s_merge_buf[len], job->ops[i].tx + 1, job->ops[i].tx_len - 1);
+        len += job->ops[i].tx_len - 1;
+    }
+    s_stats.merged_ops += last - job->next;
+    job->next = last + 1;
+    return transfer(first->dev, s_merge_buf, len, NULL, 0);
+}
+
+static void complete(i2c_sched_job_t *job)
+{
+    // Copy first: once busy clears, the owner may resubmit the job
+    TaskHandle_t waiter = job->waiter;
+    uint32_t bits = job->notify_bits;
+    atomic_store(&job->busy, false);
+
+    if (!waiter) return;
+    if (bits) {
+        xTaskNotify(waiter, bits, eSetBits);
+    } else {
+        xTaskNotifyGiveIndexed(waiter, I2C_SCHED_NOTIFY_INDEX);
+    }
+}
+
+/**
+ * @brief Run a whole batch, stopping at the first error.
+ *
+ * For normal batches, pending high batches run before each op.
+ */
+static void run_job(i2c_sched_job_t *job, i2c_sched_prio_t prio)
+{
+    job->result = ESP_OK;
+    while (job->next < job->count) {
+        if (prio != I2C_SCHED_PRIO_HIGH) {
+            i2c_sched_job_t *urgent;
+            while (xQueueReceive(s_queues[I2C_SCHED_PRIO_HIGH], &urgent, 0) == pdTRUE) {
+                run_job(urgent, I2C_SCHED_PRIO_HIGH);
+                complete(urgent);
+            }
+        }
+
+        job->result = run_next(job);
+        if (job->result != ESP_OK) {
+            ESP_LOGW(TAG_SCHED, "op %u/%u failed: %s", (unsigned)job->next, (unsigned)job->count,
+                     esp_err_to_name(job->result));
+            break;
+        }
+    }
+}
+
+static void i2c_sched_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Drain everything queued, highest priority first
+        bool ran;
+        do {
+            ran = false;
+            for (int prio = 0; prio < I2C_SCHED_PRIO_COUNT; ++prio) {
+                i2c_sched_job_t *job;
+                if (xQueueReceive(s_queues[prio], &job, 0) == pdTRUE) {
+                    run_job(job, (i2c_sched_prio_t)prio);
+                    complete(job);
+                    ran = true;
+                    break;
+                }
+            }
+        } while (ran);
+    }
+}
+
+esp_err_t i2c_sched_init(void)
+{
+    if (s_worker) return ESP_OK;
+
+    for (int prio = 0; prio < I2C_SCHED_PRIO_COUNT; ++prio) {
+        s_queues[prio] = xQueueCreate(I2C_SCHED_QUEUE_LEN, sizeof(i2c_sched_job_t *));
+        ESP_RETURN_ON_FALSE(s_queues[prio], ESP_ERR_NO_MEM, TAG_SCHED, "queue fail");
+    }
+
+    BaseType_t ok = xTaskCreatePinnedToCore(i2c_sched_task, "i2c_sched", I2C_SCHED_TASK_STACK, NULL,
+                                            I2C_SCHED_TASK_PRIO, &s_worker, I2C_SCHED_TASK_CORE);
+    ESP_RETURN_ON_FALSE(ok == pdPASS, ESP_ERR_NO_MEM, TAG_SCHED, "task fail");
+    return ESP_OK;
+}
+
+esp_err_t i2c_sched_submit(const i2c_sched_op_t *ops, size_t count, i2c_sched_prio_t prio)
+{
+    ESP_RETURN_ON_FALSE(ops && count && prio < I2C_SCHED_PRIO_COUNT, ESP_ERR_INVALID_ARG, TAG_SCHED, "invalid args");
+
+    i2c_sched_job_t job = {
+        .ops = ops,
+        .count = count,
+        .waiter = xTaskGetCurrentTaskHandle(),
+    };
+
+    if (!s_worker) {
+        // Boot-time bring-up, before the worker exists: run inline
+        job.waiter = NULL;
+        run_job(&job, I2C_SCHED_PRIO_HIGH);
+        return job.result;
+    }
+
+    i2c_sched_job_t *job_ptr = &job;
+    xQueueSend(s_queues[prio], &job_ptr, portMAX_DELAY);
+    xTaskNotifyGive(s_worker);
+    ulTaskNotifyTakeIndexed(I2C_SCHED_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+    return job.result;
+}
+
+esp_err_t i2c_sched_submit_async(i2c_sched_job_t *job, const i2c_sched_op_t *ops, size_t count,
+                                 i2c_sched_prio_t prio, uint32_t notify_bits)
+{
+    ESP_RETURN_ON_FALSE(job && ops && count && notify_bits && prio < I2C_SCHED_PRIO_COUNT, ESP_ERR_INVALID_ARG,
+                        TAG_SCHED, "invalid args");
+    ESP_RETURN_ON_FALSE(!atomic_load(&job->busy), ESP_ERR_INVALID_STATE, TAG_SCHED, "job in flight");
+
+    job->ops = ops;
+    job->count = count;
+    job->next = 0;
+    job->result = ESP_OK;
+    job->waiter = xTaskGetCurrentTaskHandle();
+    job->notify_bits = notify_bits;
+    atomic_store(&job->busy, true);
+
+    if (!s_worker) {
+        run_job(job, I2C_SCHED_PRIO_HIGH);
+        complete(job);
+        return ESP_OK;
+    }
+
+    xQueueSend(s_queues[prio], &job, portMAX_DELAY);
+    xTaskNotifyGive(s_worker);
+    return ESP_OK;
+}
+
+esp_err_t i2c_sched_job_result(const i2c_sched_job_t *job)
+{
+    if (atomic_load(&job->busy)) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    return job->result;
+}
+
+esp_err_t i2c_sched_add_device(i2c_master_dev_handle_t dev, uint16_t addr, const char *name)
+{
+    ESP_RETURN_ON_FALSE(dev && name, ESP_ERR_INVALID_ARG, TAG_SCHED, "invalid args");
+    ESP_RETURN_ON_FALSE(s_device_count < I2C_SCHED_MAX_DEVICES, ESP_ERR_NO_MEM, TAG_SCHED, "device table full");
+
+    s_devices[s_device_count++] = (sched_device_t){ .dev = dev, .addr = addr, .name = name };
+    return ESP_OK;
+}
+
+uint32_t i2c_sched_device_epoch(i2c_master_dev_handle_t dev)
+{
+    const sched_device_t *d = find_device(dev);
+    return d ? d->epoch : 0;
+}
+
+void i2c_sched_get_stats(i2c_sched_stats_t *out)
+{
+    if (!out) return;
+    *out = s_stats;
+}
+
+void i2c_sched_reset_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+}
@@ -1,6 +1,7 @@
 #ifndef COMMON_i2C_INIT_H
 #define COMMON_i2C_INIT_H
 
+#include "sdkconfig.h"
 #include "driver/i2c_master.h"
 #include "esp_err.h"
 
@@ -14,12 +15,53 @@
 
 #define CLK_SPEED_100KHZ        100 * 1000
 #define CLK_SPEED_400KHZ        400 * 1000
+#define CLK_SPEED_800KHZ        800 * 1000
+#define CLK_SPEED_1MHZ          1000 * 1000
+
+#define SSD1306_SCL_SPEED_HZ    CONFIG_COMMON_I2C_SSD1306_SCL_HZ   /**< Configured (maximum) SSD1306 clock */
+#define BME280_SCL_SPEED_HZ     CONFIG_COMMON_I2C_BME280_SCL_HZ    /**< Configured (maximum) BME280 clock */
+
+#define SSD1306_PANEL_WIDTH     WIDTH                               /**< Panel columns */
+#define SSD1306_PANEL_HEIGHT    CONFIG_COMMON_I2C_SSD1306_HEIGHT    /**< Panel rows, from the configured panel */
 
 extern const measurement_choice_t bme280_measurement_choice;
 
+/**
+ * @brief Bring up the shared bus: create it, attach both devices at their best clock, start the scheduler.
+ *
+ * @details
+ * The first half of i2c_shared_init(). Afterwards i2c_shared_init_bme280()
+ * and i2c_shared_init_ssd1306() may run in parallel from two tasks: the
+ * BME280 bring-up goes through the bus scheduler and the SSD1306 driver's
+ * writes take the bus lock, so their transactions interleave safely and the
+ * sensor's reset and configuration waits overlap the panel init.
+ *
+ * @return
+ *   - ESP_OK on success, or if the bus is already up
+ *   - Error code from the I2C driver otherwise
+ */
+esp_err_t i2c_shared_start(void);
+
+/**
+ * @brief Configure the primary BME280 (0x76) on the bus started by i2c_shared_start().
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE before i2c_shared_start(), or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t i2c_shared_init_bme280(struct bme280_dev *bme280_device_handle);
+
+/**
+ * @brief Initialize the SSD1306 on the bus started by i2c_shared_start() and show "Getting Data".
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE before i2c_shared_start(), or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t i2c_shared_init_ssd1306(ssd1306_t *ssd1306_device_handle);
+
 /**
  * @brief Initialize the shared I2C bus and both devices (SSD1306 and BME280).
  *
+ * i2c_shared_start(), then i2c_shared_init_bme280() and
+ * i2c_shared_init_ssd1306(), one after the other.
+ *
  * @param[in,out] bme280_device_handle Pointer to a BME280 device structure
  *                                     to be initialized.
  * @param[in,out] ssd1306_device_handle Pointer to an SSD1306 device structure
@@ -34,6 +76,38 @@ extern const measurement_choice_t bme280_measurement_choice;
  */
 esp_err_t i2c_shared_init(struct bme280_dev *bme280_device_handle, ssd1306_t *ssd1306_device_handle);
 
+/**
+ * @brief Attach and configure one more BME280 on the shared bus.
+ *
+ * The sensor gets the same clock probe, scheduler-routed register access and
+ * measurement settings as the one set up by i2c_shared_init(); its device
+ * handle ends up in @p bme280_device_handle->intf_ptr.
+ *
+ * @param[in]     addr                 7-bit address, e.g. BME280_I2C_ADDR_SEC (0x77).
+ * @param[in,out] bme280_device_handle BME280 device structure to initialize.
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_INVALID_STATE if i2c_shared_init() has not run
+ *   - ESP_ERR_INVALID_ARG if @p bme280_device_handle is NULL
+ *   - Error code from the I2C driver otherwise
+ */
+esp_err_t i2c_add_bme280(uint16_t addr, struct bme280_dev *bme280_device_handle);
+
+/**
+ * @brief Run the BME280 bring-up again on an attached sensor: calibration read and measurement settings.
+ *
+ * Used after the bus scheduler recovered the device (i2c_sched_device_epoch()),
+ * since a sensor that browned out comes back in sleep mode with default settings.
+ *
+ * @param[in,out] bme280_device_handle Sensor set up by i2c_shared_init() or i2c_add_bme280().
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG if the sensor was never attached.
+ *
+ * @note Must be called from a task other than the bus worker.
+ */
+esp_err_t i2c_reconfigure_bme280(struct bme280_dev *bme280_device_handle);
+
 /**
  * @brief Get the shared I2C bus handle.
  * @return I2C bus handle.
@@ -49,5 +123,15 @@ i2c_master_dev_handle_t i2c_get_bme280(void);
  * @return I2C device handle for SSD1306.
  */
 i2c_master_dev_handle_t i2c_get_ssd1306(void);
+/**
+ * @brief Get the SCL clock the BME280 device was attached with.
+ * @return Clock in Hz (the probed value with CONFIG_COMMON_I2C_SPEED_PROBE).
+ */
+uint32_t i2c_get_bme280_speed_hz(void);
+/**
+ * @brief Get the SCL clock the SSD1306 device was attached with.
+ * @return Clock in Hz (the probed value with CONFIG_COMMON_I2C_SPEED_PROBE).
+ */
+uint32_t i2c_get_ssd1306_speed_hz(void);
 
 #endif // COMMON_i2C_INIT_H
\ No newline at end of file
@@ -0,0 +1,222 @@
+#ifndef I2C_SCHED_H
+#define I2C_SCHED_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+
+#include "sdkconfig.h"
+
+#define I2C_SCHED_TASK_STACK        3072
+#define I2C_SCHED_TASK_PRIO         CONFIG_COMMON_I2C_SCHED_TASK_PRIO   /**< Above every bus client so queued work starts at once */
+#define I2C_SCHED_TASK_CORE         ((CONFIG_COMMON_I2C_SCHED_TASK_CORE < 0) ? tskNO_AFFINITY : CONFIG_COMMON_I2C_SCHED_TASK_CORE)
+#define I2C_SCHED_QUEUE_LEN         8       /**< Pending batches per priority */
+#define I2C_SCHED_MERGE_MAX         32      /**< Largest merged command write, control byte included */
+#define I2C_SCHED_MAX_DEVICES       4       /**< Devices with fault recovery (i2c_sched_add_device()) */
+#define I2C_SCHED_RETRIES           CONFIG_COMMON_I2C_RETRIES           /**< Extra attempts per failed transaction */
+#define I2C_SCHED_OFFLINE_MS        CONFIG_COMMON_I2C_OFFLINE_BACKOFF_MS /**< Fail-fast window after a failed re-probe */
+
+/**
+ * @brief Task notification index used to wake a caller blocked in i2c_sched_submit().
+ *
+ * Index 0 stays free for the application's own event bits.
+ * Requires CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES >= 2.
+ */
+#define I2C_SCHED_NOTIFY_INDEX      1
+
+/**
+ * @brief Batch priority. High batches run between the operations of a normal batch.
+ */
+typedef enum {
+    I2C_SCHED_PRIO_HIGH = 0,        /**< Sensor reads: timing-critical, short */
+    I2C_SCHED_PRIO_NORMAL,          /**< Display flushes: long, can be split */
+    I2C_SCHED_PRIO_COUNT,
+} i2c_sched_prio_t;
+
+#define I2C_SCHED_OP_MERGEABLE      (1u << 0)   /**< tx[0] is a control byte; see @ref i2c_sched_op_t */
+
+/**
+ * @brief One I2C transaction inside a batch.
+ *
+ * @details
+ * - rx_len == 0: i2c_master_transmit(tx)
+ * - rx_len  > 0: i2c_master_transmit_receive(tx, rx), or i2c_master_receive(rx) if tx_len == 0
+ *
+ * Consecutive write-only ops to the same device that all carry
+ * @ref I2C_SCHED_OP_MERGEABLE and the same tx[0] are sent as one transaction:
+ * tx[0] once, followed by every op's payload. This fits streams where the
+ * first byte selects the meaning of the rest, e.g. the SSD1306 command stream (0x00).
+ *
+ * Buffers must stay valid until i2c_sched_submit() returns, or until an
+ * i2c_sched_submit_async() batch has completed.
+ */
+typedef struct {
+    i2c_master_dev_handle_t dev;
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+    uint32_t flags;
+} i2c_sched_op_t;
+
+/**
+ * @brief A submitted batch. Caller-owned storage for i2c_sched_submit_async().
+ *
+ * Zero-initialize before first use; the fields belong to the scheduler.
+ */
+typedef struct {
+    const i2c_sched_op_t *ops;
+    size_t count;
+    size_t next;                /**< Index of the next op to run */
+    esp_err_t result;
+    TaskHandle_t waiter;        /**< Task woken on completion; NULL for the inline boot path */
+    uint32_t notify_bits;       /**< Async: bits set in the waiter's notification index 0; 0 = blocking submit */
+    atomic_bool busy;           /**< Queued or running */
+} i2c_sched_job_t;
+
+/**
+ * @brief Bus traffic counters since boot (or the last i2c_sched_reset_stats()).
+ *
+ * Byte counts are payload bytes handed to the driver, address bytes excluded.
+ */
+typedef struct {
+    uint32_t transactions;      /**< I2C transactions issued (a merged write counts once) */
+    uint32_t tx_bytes;          /**< Bytes written */
+    uint32_t rx_bytes;          /**< Bytes read */
+    uint32_t merged_ops;        /**< Ops folded into a preceding transaction */
+    uint32_t errors;            /**< Transactions the driver reported as failed */
+    uint32_t retries;           /**< Transactions re-sent after a failure */
+    uint32_t bus_resets;        /**< SCL clock-out recoveries (i2c_master_bus_reset()) */
+    uint32_t recoveries;        /**< Devices that answered the re-probe after a bus reset */
+    uint32_t probe_failures;    /**< Devices that did not; they fail fast for @ref I2C_SCHED_OFFLINE_MS */
+    uint32_t offline_skips;     /**< Ops failed without touching the bus because their device was offline */
+} i2c_sched_stats_t;
+
+/**
+ * @brief Start the bus worker task.
+ *
+ * @return
+ *   - ESP_OK on success (or if already running)
+ *   - ESP_ERR_NO_MEM if the queues or the task could not be created
+ *
+ * @note Until this is called, i2c_sched_submit() executes the batch directly
+ *       in the caller's context.
+ */
+esp_err_t i2c_sched_init(void);
+
+/**
+ * @brief Enable fault recovery for a device on the shared bus.
+ *
+ * @details
+ * A failed transaction is always retried up to @ref I2C_SCHED_RETRIES times.
+ * For a device registered here, the last retry is preceded by a bus recovery:
+ * i2c_master_bus_reset() clocks SCL until a slave stuck mid-byte releases SDA,
+ * then i2c_device_probe() checks that the device answers again. If it does,
+ * the device's recovery epoch (i2c_sched_device_epoch()) advances so its owner
+ * re-initializes it, since a glitch that hung the bus may also have reset it.
+ * If it does not, ops for it fail with ESP_ERR_NOT_FOUND for
+ * @ref I2C_SCHED_OFFLINE_MS before the bus is tried again, so a missing device
+ * cannot stall every batch with resets.
+ *
+ * @param[in] dev  Device handle.
+ * @param[in] addr 7-bit address, for the re-probe.
+ * @param[in] name Name for the log; must stay valid.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_NO_MEM if @ref I2C_SCHED_MAX_DEVICES are registered.
+ *
+ * @note Call during bring-up, before the device has traffic.
+ */
+esp_err_t i2c_sched_add_device(i2c_master_dev_handle_t dev, uint16_t addr, const char *name);
+
+/**
+ * @brief Number of successful recoveries of @p dev since boot (0 for unregistered devices).
+ *
+ * Owners keep the value they last saw and re-initialize the device when it changes.
+ */
+uint32_t i2c_sched_device_epoch(i2c_master_dev_handle_t dev);
+
+/**
+ * @brief Queue a batch, wait for the worker to run it and return its result.
+ *
+ * @details
+ * The ops of one batch run back to back, in order. Batches of the same
+ * priority run in FIFO order. Before each op of a normal batch the worker
+ * first runs every pending high batch, so a sensor read waits for at most
+ * one op of a display flush, not the whole frame.
+ *
+ * @param[in] ops   Operations to run.
+ * @param[in] count Number of operations.
+ * @param[in] prio  Batch priority.
+ *
+ * @return
+ *   - ESP_OK if every op succeeded
+ *   - ESP_ERR_INVALID_ARG on bad arguments
+ *   - ESP_ERR_NOT_FOUND if an op's device is offline (see i2c_sched_add_device())
+ *   - First error returned by the I2C driver once the retries are used up;
+ *     the remaining ops are skipped
+ *
+ * @note Must not be called from the worker itself (e.g. from a driver callback it runs).
+ */
+esp_err_t i2c_sched_submit(const i2c_sched_op_t *ops, size_t count, i2c_sched_prio_t prio);
+
+/**
+ * @brief Queue a batch and return at once; the worker notifies the caller when it is done.
+ *
+ * @details
+ * Scheduling is the same as for i2c_sched_submit(). When the last op has run
+ * (or one failed), the worker sets @p notify_bits in the calling task's
+ * notification value (index 0, eSetBits), like any other application event.
+ * i2c_sched_job_result() then returns the outcome. @p job, @p ops and every
+ * buffer they reference must stay untouched until then.
+ *
+ * Before i2c_sched_init() the batch runs inline and the bits are set before
+ * this returns.
+ *
+ * @param[in,out] job         Batch storage, idle (never submitted, or completed).
+ * @param[in]     ops         Operations to run.
+ * @param[in]     count       Number of operations.
+ * @param[in]     prio        Batch priority.
+ * @param[in]     notify_bits Completion bits, non-zero.
+ *
+ * @return
+ *   - ESP_OK if the batch was queued
+ *   - ESP_ERR_INVALID_ARG on bad arguments
+ *   - ESP_ERR_INVALID_STATE if @p job is still in flight
+ */
+esp_err_t i2c_sched_submit_async(i2c_sched_job_t *job, const i2c_sched_op_t *ops, size_t count,
+                                 i2c_sched_prio_t prio, uint32_t notify_bits);
+
+/**
+ * @brief Outcome of an i2c_sched_submit_async() batch.
+ *
+ * @return
+ *   - ESP_ERR_NOT_FINISHED while the batch is queued or running
+ *   - Otherwise the result i2c_sched_submit() would have returned
+ *     (ESP_OK for a job that was never submitted)
+ */
+esp_err_t i2c_sched_job_result(const i2c_sched_job_t *job);
+
+/**
+ * @brief Copy the current traffic counters.
+ *
+ * @param[out] out Destination; ignored if NULL.
+ *
+ * @note Counters are updated by the worker without locking; each field is a
+ *       single 32-bit word, so a copy may mix two adjacent transactions but
+ *       never tears a value.
+ */
+void i2c_sched_get_stats(i2c_sched_stats_t *out);
+
+/**
+ * @brief Zero the traffic counters.
+ */
+void i2c_sched_reset_stats(void);
+
+#endif // I2C_SCHED_H
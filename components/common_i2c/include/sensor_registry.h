@@ -0,0 +1,137 @@
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "i2c_sched.h"
+
+#define SENSOR_REGISTRY_MAX         4       /**< Sensors one acquisition task can drive */
+#define SENSOR_OPS_MAX              2       /**< Ops one sensor may add to a trigger or collect batch */
+#define SENSOR_REGISTRY_MAX_POLLS   5       /**< Extra 1-tick collect retries if a conversion overruns */
+
+/**
+ * @brief Driver vtable for one kind of I2C sensor.
+ *
+ * @details
+ * A sample round is split so that the registry can run every sensor side by
+ * side: the drivers describe their bus traffic as i2c_sched ops instead of
+ * issuing it, the registry sends the trigger ops of all sensors as one batch,
+ * sleeps once for the longest conversion, sends all collect ops as a second
+ * batch and only then lets each driver decode its bytes.
+ *
+ * Each callback gets the @p ctx passed to sensor_registry_add(). Op buffers
+ * must live in @p ctx, since the ops are sent after the callback returns.
+ */
+typedef struct {
+    /**
+     * @brief One-time setup, run by sensor_registry_add(); may talk to the device directly.
+     */
+    esp_err_t (*init)(void *ctx);
+
+    /**
+     * @brief Describe the writes that start one conversion.
+     *
+     * @param[out] ops     At most @p max ops; may add none (free-running sensors).
+     * @param[out] wait_us Time from the trigger until the result can be collected.
+     *
+     * @return Number of ops added.
+     */
+    size_t (*trigger)(void *ctx, i2c_sched_op_t *ops, size_t max, uint32_t *wait_us);
+
+    /**
+     * @brief Describe the reads that fetch the result; at least one op.
+     *
+     * @return Number of ops added.
+     */
+    size_t (*collect_ops)(void *ctx, i2c_sched_op_t *ops, size_t max);
+
+    /**
+     * @brief Decode the bytes read by the collect ops into the driver's result.
+     *
+     * @return ESP_OK, ESP_ERR_NOT_FINISHED if the conversion was still running
+     *         (the registry reads again a tick later), or a decode error.
+     */
+    esp_err_t (*collect)(void *ctx);
+
+    /**
+     * @brief Bring the sensor back after the bus scheduler recovered its device; NULL = run init() again.
+     */
+    esp_err_t (*recover)(void *ctx);
+} sensor_driver_t;
+
+/**
+ * @brief Acquisition counters since boot.
+ */
+typedef struct {
+    uint32_t rounds;        /**< sensor_registry_sample() calls */
+    uint32_t batch_retries; /**< Batches that failed as a whole and were re-run sensor by sensor */
+    uint32_t misses;        /**< Sensor samples that produced no result */
+    uint32_t reinits;       /**< Sensors re-initialized after a bus recovery */
+} sensor_registry_stats_t;
+
+/**
+ * @brief Register a sensor and run its init().
+ *
+ * @param[in]  driver Driver vtable; must stay valid.
+ * @param[in]  ctx    Driver instance; must stay valid.
+ * @param[in]  dev    Device the sensor sits on; its recovery epoch (i2c_sched_device_epoch()) triggers recover().
+ * @param[in]  name   Label for logs and sensor_registry_name(), e.g. "bme280@0x76"; must stay valid.
+ * @param[out] index  Position of the sensor, the bit it owns in sensor_registry_sample()'s mask; may be NULL.
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_INVALID_ARG on NULL arguments or an incomplete vtable
+ *   - ESP_ERR_NO_MEM if @ref SENSOR_REGISTRY_MAX sensors are registered
+ *   - The error returned by init() (the sensor is then not registered)
+ *
+ * @note Register every sensor before the first sensor_registry_sample(), from the same task.
+ */
+esp_err_t sensor_registry_add(const sensor_driver_t *driver, void *ctx, i2c_master_dev_handle_t dev,
+                              const char *name, size_t *index);
+
+/**
+ * @brief Number of registered sensors.
+ */
+size_t sensor_registry_count(void);
+
+/**
+ * @brief Name of sensor @p index, or NULL if there is none.
+ */
+const char *sensor_registry_name(size_t index);
+
+/**
+ * @brief Take one sample from every registered sensor, all conversions in parallel.
+ *
+ * @details
+ * 1. The trigger ops of all sensors go out as one high-priority batch.
+ * 2. The calling task sleeps once, for the longest wait_us reported.
+ * 3. The collect ops of all sensors go out as one high-priority batch, and
+ *    each driver decodes its result. Sensors that report
+ *    ESP_ERR_NOT_FINISHED are read again, every tick, up to
+ *    @ref SENSOR_REGISTRY_MAX_POLLS times.
+ *
+ * If a shared batch fails, it is re-run one sensor at a time, so a sensor
+ * that has dropped off the bus only costs its own sample. A sensor whose
+ * device was recovered since the last round is re-initialized first.
+ *
+ * Adding a sensor therefore adds a few bytes to each batch, not a task or a
+ * second conversion wait.
+ *
+ * @param[out] fresh Bit i set if sensor i produced a new result this round; may be NULL.
+ *
+ * @return
+ *   - ESP_OK if at least one sensor produced a result
+ *   - ESP_ERR_INVALID_STATE if no sensor is registered
+ *   - ESP_FAIL if every sensor failed
+ */
+esp_err_t sensor_registry_sample(uint32_t *fresh);
+
+/**
+ * @brief Copy the acquisition counters.
+ */
+void sensor_registry_get_stats(sensor_registry_stats_t *out);
+
+#endif // SENSOR_REGISTRY_H
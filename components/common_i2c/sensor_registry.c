@@ -0,0 +1,227 @@
+/**
+ * @file sensor_registry.c
+ * @brief Registry of I2C sensors sampled together by one acquisition task.
+ *
+ * @details
+ * Sampling each sensor on its own costs a task (or a serial loop) per sensor
+ * and one full conversion wait each. Here the drivers only describe their
+ * transactions (sensor_driver_t), and every round is two bus batches with a
+ * single sleep in between: all triggers, the longest conversion time, then
+ * all result reads. The conversions of all sensors run at the same time.
+ *
+ * Only the task that calls sensor_registry_sample() touches the op buffers,
+ * so no locking is needed.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "sensor_registry.h"
+
+static const char *TAG_SENSORS = "SENSORS";
+
+typedef struct {
+    const sensor_driver_t *driver;
+    void *ctx;
+    i2c_master_dev_handle_t dev;
+    const char *name;
+    uint32_t epoch;             /**< i2c_sched_device_epoch() the sensor was last initialized at */
+    size_t first_op;            /**< Start of this sensor's ops in @ref s_ops for the current phase */
+    size_t op_count;
+} sensor_entry_t;
+
+_Static_assert(SENSOR_REGISTRY_MAX <= 32, "sensor masks are 32 bits wide");
+
+static sensor_entry_t s_sensors[SENSOR_REGISTRY_MAX];
+static size_t s_count;
+
+/** Ops of the batch being built: the trigger phase, then the collect phase */
+static i2c_sched_op_t s_ops[SENSOR_REGISTRY_MAX * SENSOR_OPS_MAX];
+
+/** Only the acquisition task writes them */
+static sensor_registry_stats_t s_stats;
+
+/**
+ * @brief Ticks that cover @p wait_us, rounded up, plus one for the partial first tick.
+ */
+static inline TickType_t wait_ticks(uint32_t wait_us)
+{
+    return (TickType_t)(((uint64_t)wait_us * configTICK_RATE_HZ + 999999) / 1000000) + 1;
+}
+
+/**
+ * @brief Send the ops that the sensors in @p mask added to @ref s_ops, as one batch if possible.
+ *
+ * @return Mask of the sensors whose ops all succeeded.
+ */
+static uint32_t run_batch(uint32_t mask, size_t total)
+{
+    if (total == 0 || i2c_sched_submit(s_ops, total, I2C_SCHED_PRIO_HIGH) == ESP_OK) {
+        return mask;
+    }
+
+    // The scheduler stops at the first failed op: find out whose it was
+    s_stats.batch_retries++;
+    uint32_t ok = 0;
+    for (size_t i = 0; i < s_count && i < SENSOR_REGISTRY_MAX; ++i) {
+        if (!(mask & (1u << i))) continue;
+        const sensor_entry_t *e = &s_sensors[i];
+        if (e->op_count == 0 ||
+            i2c_sched_submit(&s_ops[e->first_op], e->op_count, I2C_SCHED_PRIO_HIGH) == ESP_OK) {
+            ok |= 1u << i;
+        } else {
+            ESP_LOGW(TAG_SENSORS, "%s: bus error", e->name);
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Queue every sensor's trigger ops.
+ *
+ * @param[out] wait_us Longest time until a result is ready.
+ *
+ * @return Number of ops in @ref s_ops.
+ */
+static size_t build_triggers(uint32_t *wait_us)
+{
+    size_t total = 0;
+    *wait_us = 0;
+    for (size_t i = 0; i < s_count; ++i) {
+        sensor_entry_t *e = &s_sensors[i];
+        uint32_t wait = 0;
+        e->first_op = total;
+        e->op_count = e->driver->trigger(e->ctx, &s_ops[total], SENSOR_OPS_MAX, &wait);
+        total += e->op_count;
+        if (wait > *wait_us) {
+            *wait_us = wait;
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Queue the collect ops of the sensors in @p mask.
+ *
+ * @return Number of ops in @ref s_ops.
+ */
+static size_t build_collects(uint32_t mask)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < s_count; ++i) {
+        sensor_entry_t *e = &s_sensors[i];
+        e->first_op = total;
+        e->op_count = (mask & (1u << i)) ? e->driver->collect_ops(e->ctx, &s_ops[total], SENSOR_OPS_MAX) : 0;
+        total += e->op_count;
+    }
+    return total;
+}
+
+/**
+ * @brief Re-initialize every sensor whose device the bus scheduler recovered since the last round.
+ */
+static void reinit_recovered(void)
+{
+    for (size_t i = 0; i < s_count; ++i) {
+        sensor_entry_t *e = &s_sensors[i];
+        uint32_t epoch = i2c_sched_device_epoch(e->dev);
+        if (epoch == e->epoch) continue;
+
+        e->epoch = epoch;
+        s_stats.reinits++;
+        esp_err_t err = e->driver->recover ? e->driver->recover(e->ctx) : e->driver->init(e->ctx);
+        if (err == ESP_OK) {
+            ESP_LOGW(TAG_SENSORS, "%s re-initialized after bus recovery", e->name);
+        } else {
+            ESP_LOGE(TAG_SENSORS, "%s re-init fail: %s", e->name, esp_err_to_name(err));
+        }
+    }
+}
+
+esp_err_t sensor_registry_add(const sensor_driver_t *driver, void *ctx, i2c_master_dev_handle_t dev,
+                              const char *name, size_t *index)
+{
+    ESP_RETURN_ON_FALSE(driver && ctx && dev && name && driver->init && driver->trigger && driver->collect_ops && driver->collect,
+                        ESP_ERR_INVALID_ARG, TAG_SENSORS, "invalid driver");
+    ESP_RETURN_ON_FALSE(s_count < SENSOR_REGISTRY_MAX, ESP_ERR_NO_MEM, TAG_SENSORS, "registry full");
+
+    ESP_RETURN_ON_ERROR(driver->init(ctx), TAG_SENSORS, "%s init fail", name);
+
+    s_sensors[s_count] = (sensor_entry_t){
+        .driver = driver, .ctx = ctx, .dev = dev, .name = name, .epoch = i2c_sched_device_epoch(dev),
+    };
+    if (index) {
+        *index = s_count;
+    }
+    ESP_LOGI(TAG_SENSORS, "Sensor %u: %s", (unsigned)s_count, name);
+    s_count++;
+    return ESP_OK;
+}
+
+size_t sensor_registry_count(void)
+{
+    return s_count;
+}
+
+const char *sensor_registry_name(size_t index)
+{
+    return (index < s_count) ? s_sensors[index].name : NULL;
+}
+
+esp_err_t sensor_registry_sample(uint32_t *fresh)
+{
+    if (fresh) {
+        *fresh = 0;
+    }
+    ESP_RETURN_ON_FALSE(s_count > 0, ESP_ERR_INVALID_STATE, TAG_SENSORS, "no sensors");
+    s_stats.rounds++;
+    reinit_recovered();
+
+    const uint32_t all = (1u << s_count) - 1;
+
+    // ---- All conversions start together
+    uint32_t wait_us = 0;
+    size_t total = build_triggers(&wait_us);
+    uint32_t pending = run_batch(all, total);
+    if (pending && wait_us) {
+        vTaskDelay(wait_ticks(wait_us));
+    }
+
+    // ---- One read batch; stragglers are polled on the following ticks
+    uint32_t done = 0;
+    for (int poll = 0; pending && poll <= SENSOR_REGISTRY_MAX_POLLS; ++poll) {
+        if (poll > 0) {
+            vTaskDelay(1);
+        }
+        uint32_t read = run_batch(pending, build_collects(pending));
+
+        uint32_t again = 0;
+        for (size_t i = 0; i < s_count; ++i) {
+            if (!(read & (1u << i))) continue;
+            esp_err_t err = s_sensors[i].driver->collect(s_sensors[i].ctx);
+            if (err == ESP_OK) {
+                done |= 1u << i;
+            } else if (err == ESP_ERR_NOT_FINISHED) {
+                again |= 1u << i;
+            } else {
+                ESP_LOGW(TAG_SENSORS, "%s: %s", s_sensors[i].name, esp_err_to_name(err));
+            }
+        }
+        pending = again;
+    }
+
+    s_stats.misses += (uint32_t)__builtin_popcount(all & ~done);
+    if (fresh) {
+        *fresh = done;
+    }
+    return done ? ESP_OK : ESP_FAIL;
+}
+
+void sensor_registry_get_stats(sensor_registry_stats_t *out)
+{
+    if (!out) return;
+    *out = s_stats;
+}
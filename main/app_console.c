@@ -0,0 +1,69 @@
+/**
+ * @file app_console.c
+ * @brief UART console REPL with the `tz` command (see app_console.h).
+ *
+ * @details
+ * Built in every configuration, so the runtime time zone setting does not
+ * depend on the instrumentation; perf_stats.c registers its own commands
+ * when CONFIG_APP_PERF_STATS is on.
+ */
+
+#include <stdio.h>
+
+#include "esp_check.h"
+#include "esp_console.h"
+#include "esp_log.h"
+
+#include "app_console.h"
+#include "local_time.h"
+
+static const char *TAG_CONSOLE = "CONSOLE";
+
+static esp_console_repl_t *s_repl;
+
+static int tz_cmd(int argc, char **argv)
+{
+    if (argc == 2) {
+        if (local_time_set_tz(argv[1]) == ESP_ERR_INVALID_ARG) {
+            printf("not a time zone: %s\n", argv[1]);
+            return 1;
+        }
+    } else if (argc != 1) {
+        printf("usage: tz [POSIX-TZ | name]\n");
+        return 1;
+    }
+
+    char tz[LOCAL_TIME_TZ_MAX];
+    local_time_get_tz(tz, sizeof(tz));
+    printf("%s\nnames:", tz);
+    const char *name;
+    for (size_t i = 0; (name = local_time_zone_name(i)) != NULL; ++i) {
+        printf(" %s", name);
+    }
+    printf("\n");
+    return 0;
+}
+
+esp_err_t app_console_init(void)
+{
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = "tw>";
+    esp_console_dev_uart_config_t uart_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    ESP_RETURN_ON_ERROR(esp_console_new_repl_uart(&uart_config, &repl_config, &s_repl), TAG_CONSOLE, "repl");
+
+    const esp_console_cmd_t tz = {
+        .command = "tz",
+        .help = "Show the time zone, or set and store it (POSIX TZ string or a listed name)",
+        .hint = "[POSIX-TZ | name]",
+        .func = tz_cmd,
+    };
+    ESP_RETURN_ON_ERROR(esp_console_cmd_register(&tz), TAG_CONSOLE, "register tz");
+    ESP_RETURN_ON_ERROR(esp_console_register_help_command(), TAG_CONSOLE, "help");
+    return ESP_OK;
+}
+
+esp_err_t app_console_start(void)
+{
+    ESP_RETURN_ON_FALSE(s_repl, ESP_ERR_INVALID_STATE, TAG_CONSOLE, "not initialized");
+    return esp_console_start_repl(s_repl);
+}
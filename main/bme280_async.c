@@ -0,0 +1,124 @@
+/**
+ * @file bme280_async.c
+ * @brief Non-blocking forced-mode acquisition for the BME280.
+ *
+ * @details
+ * bme_forced_read_once() triggers a conversion and waits for it inside the
+ * call, so the calling task is stuck for the whole conversion time. This module
+ * splits the sample into:
+ *   - bme280_async_trigger(): one ctrl_meas write that starts the conversion
+ *   - bme280_async_collect(): status check + one burst read of the data registers
+ *
+ * Between the two the caller sleeps (or does other bus work, e.g. flushing the
+ * display) for the conversion time computed from the oversampling settings.
+ *
+ * bme280_async_start_normal() switches the chip to normal mode instead: it
+ * then converts on its own, every measurement time plus standby time, and runs
+ * each result through its IIR filter. A sample is then a single burst read,
+ * with no trigger write and no status poll.
+ */
+
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "bme280.h"
+
+#include "bme280_async.h"
+
+static const char *TAG_BME_ASYNC = "BME280_ASYNC";
+
+#define BME280_STATUS_REG           0xF3
+#define BME280_STATUS_MEASURING     0x08    /**< Set while a conversion is running */
+
+/**
+ * @brief Standby settings, shortest first, as t_sb in microseconds.
+ */
+static const struct {
+    uint8_t setting;
+    uint32_t us;
+} standby_times[] = {
+    { BME280_STANDBY_TIME_0_5_MS,  500 },
+    { BME280_STANDBY_TIME_10_MS,   10000 },
+    { BME280_STANDBY_TIME_20_MS,   20000 },
+    { BME280_STANDBY_TIME_62_5_MS, 62500 },
+    { BME280_STANDBY_TIME_125_MS,  125000 },
+    { BME280_STANDBY_TIME_250_MS,  250000 },
+    { BME280_STANDBY_TIME_500_MS,  500000 },
+    { BME280_STANDBY_TIME_1000_MS, 1000000 },
+};
+
+esp_err_t bme280_async_init(bme280_async_t *ctx, struct bme280_dev *dev)
+{
+    ESP_RETURN_ON_FALSE(ctx && dev, ESP_ERR_INVALID_ARG, TAG_BME_ASYNC, "invalid args");
+
+    struct bme280_settings settings = {0};
+    int8_t rslt = bme280_get_sensor_settings(&settings, dev);
+    ESP_RETURN_ON_FALSE(rslt == BME280_OK, ESP_FAIL, TAG_BME_ASYNC, "get settings failed: %d", rslt);
+
+    uint32_t delay_us = 0;
+    rslt = bme280_cal_meas_delay(&delay_us, &settings);
+    ESP_RETURN_ON_FALSE(rslt == BME280_OK, ESP_FAIL, TAG_BME_ASYNC, "meas delay failed: %d", rslt);
+
+    ctx->dev = dev;
+    ctx->meas_delay_us = delay_us;
+    ctx->normal = false;
+    ESP_LOGI(TAG_BME_ASYNC, "Forced conversion takes up to %lu us", (unsigned long)delay_us);
+    return ESP_OK;
+}
+
+esp_err_t bme280_async_trigger(bme280_async_t *ctx, uint32_t *wait_us)
+{
+    int8_t rslt = bme280_set_sensor_mode(BME280_POWERMODE_FORCED, ctx->dev);
+    ESP_RETURN_ON_FALSE(rslt == BME280_OK, ESP_FAIL, TAG_BME_ASYNC, "trigger failed: %d", rslt);
+
+    *wait_us = ctx->meas_delay_us;
+    return ESP_OK;
+}
+
+esp_err_t bme280_async_start_normal(bme280_async_t *ctx, uint8_t filter, uint32_t period_us)
+{
+    ESP_RETURN_ON_FALSE(ctx && ctx->dev, ESP_ERR_INVALID_ARG, TAG_BME_ASYNC, "not initialized");
+
+    // Longest standby that still completes a conversion within every read period
+    size_t pick = 0;
+    for (size_t i = 1; i < sizeof(standby_times) / sizeof(standby_times[0]); ++i) {
+        if (ctx->meas_delay_us + standby_times[i].us <= period_us) {
+            pick = i;
+        }
+    }
+
+    struct bme280_settings settings = {0};
+    int8_t rslt = bme280_get_sensor_settings(&settings, ctx->dev);
+    ESP_RETURN_ON_FALSE(rslt == BME280_OK, ESP_FAIL, TAG_BME_ASYNC, "get settings failed: %d", rslt);
+
+    settings.filter = filter;
+    settings.standby_time = standby_times[pick].setting;
+    rslt = bme280_set_sensor_settings(BME280_SEL_FILTER | BME280_SEL_STANDBY, &settings, ctx->dev);
+    ESP_RETURN_ON_FALSE(rslt == BME280_OK, ESP_FAIL, TAG_BME_ASYNC, "set settings failed: %d", rslt);
+
+    rslt = bme280_set_sensor_mode(BME280_POWERMODE_NORMAL, ctx->dev);
+    ESP_RETURN_ON_FALSE(rslt == BME280_OK, ESP_FAIL, TAG_BME_ASYNC, "normal mode failed: %d", rslt);
+
+    ctx->normal = true;
+    ESP_LOGI(TAG_BME_ASYNC, "Normal mode: conversion every %lu us, IIR setting %u",
+             (unsigned long)(ctx->meas_delay_us + standby_times[pick].us), (unsigned)filter);
+    return ESP_OK;
+}
+
+esp_err_t bme280_async_collect(bme280_async_t *ctx, struct bme280_data *out)
+{
+    int8_t rslt;
+    if (!ctx->normal) {
+        uint8_t status = 0;
+        rslt = bme280_get_regs(BME280_STATUS_REG, &status, 1, ctx->dev);
+        ESP_RETURN_ON_FALSE(rslt == BME280_OK, ESP_FAIL, TAG_BME_ASYNC, "status read failed: %d", rslt);
+        if (status & BME280_STATUS_MEASURING) {
+            return ESP_ERR_NOT_FINISHED;
+        }
+    }
+
+    // Normal mode: the data registers are shadowed during a burst read, so any moment is consistent
+    rslt = bme280_get_sensor_data(BME280_ALL, out, ctx->dev);
+    ESP_RETURN_ON_FALSE(rslt == BME280_OK, ESP_FAIL, TAG_BME_ASYNC, "data read failed: %d", rslt);
+    return ESP_OK;
+}
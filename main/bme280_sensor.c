@@ -0,0 +1,145 @@
+/**
+ * @file bme280_sensor.c
+ * @brief BME280 driver for the sensor registry (sensor_registry.h).
+ *
+ * @details
+ * The Bosch API issues its own transactions, one callback per register
+ * access, which cannot be batched with other sensors. This driver therefore
+ * uses the Bosch API only for setup and for the compensation math, and hands
+ * the registry plain i2c_sched ops for the per-sample traffic:
+ *   - trigger: ctrl_meas = osr_t | osr_p | forced mode, one write
+ *   - collect: one burst read from the status register through the humidity
+ *     bytes, so the "measuring" check costs no extra transaction
+ *   - recover: after a bus recovery, the whole bring-up again, since a sensor
+ *     that browned out restarts in sleep mode with its settings cleared
+ */
+
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "bme280.h"
+
+#include "common_i2c_init.h"
+
+#include "sdkconfig.h"
+
+#include "bme280_sensor.h"
+
+static const char *TAG_BME_SENSOR = "BME280_SENSOR";
+
+#define BME280_REG_STATUS           0xF3
+#define BME280_REG_CTRL_MEAS        0xF4
+#define BME280_REG_DATA             0xF7    /**< press_msb; 8 data bytes follow through hum_lsb */
+#define BME280_STATUS_MEASURING     0x08
+#define BME280_DATA_OFFSET          (BME280_REG_DATA - BME280_REG_STATUS)
+#define BME280_DATA_LEN             8
+#define BME280_RAW_RESET_VALUE      0x80000 /**< Data registers before the first conversion */
+
+#if CONFIG_APP_BME280_IIR_16
+#define SENSOR_IIR_FILTER           BME280_FILTER_COEFF_16
+#elif CONFIG_APP_BME280_IIR_8
+#define SENSOR_IIR_FILTER           BME280_FILTER_COEFF_8
+#elif CONFIG_APP_BME280_IIR_4
+#define SENSOR_IIR_FILTER           BME280_FILTER_COEFF_4
+#elif CONFIG_APP_BME280_IIR_2
+#define SENSOR_IIR_FILTER           BME280_FILTER_COEFF_2
+#else
+#define SENSOR_IIR_FILTER           BME280_FILTER_COEFF_OFF
+#endif
+
+static esp_err_t bme280_sensor_init(void *ctx)
+{
+    bme280_sensor_t *s = ctx;
+    ESP_RETURN_ON_ERROR(bme280_async_init(&s->async, s->async.dev), TAG_BME_SENSOR, "init");
+
+    struct bme280_settings settings = {0};
+    int8_t rslt = bme280_get_sensor_settings(&settings, s->async.dev);
+    ESP_RETURN_ON_FALSE(rslt == BME280_OK, ESP_FAIL, TAG_BME_SENSOR, "get settings failed: %d", rslt);
+
+    // ctrl_hum was written during configuration and stays latched; only ctrl_meas restarts a conversion
+    s->trigger_cmd[0] = BME280_REG_CTRL_MEAS;
+    s->trigger_cmd[1] = (uint8_t)((settings.osr_t << 5) | (settings.osr_p << 2) | BME280_POWERMODE_FORCED);
+
+#if CONFIG_APP_BME280_NORMAL
+    ESP_RETURN_ON_ERROR(bme280_async_start_normal(&s->async, SENSOR_IIR_FILTER, CONFIG_APP_SENSOR_PERIOD_MS * 1000u),
+                        TAG_BME_SENSOR, "normal mode");
+#endif
+    s->read_reg = s->async.normal ? BME280_REG_DATA : BME280_REG_STATUS;
+    return ESP_OK;
+}
+
+static size_t bme280_sensor_trigger(void *ctx, i2c_sched_op_t *ops, size_t max, uint32_t *wait_us)
+{
+    bme280_sensor_t *s = ctx;
+    if (s->async.normal || max < 1) {
+        *wait_us = 0;   // free-running: the newest conversion is always there
+        return 0;
+    }
+
+    ops[0] = (i2c_sched_op_t){
+        .dev = (i2c_master_dev_handle_t)s->async.dev->intf_ptr,
+        .tx = s->trigger_cmd,
+        .tx_len = sizeof(s->trigger_cmd),
+    };
+    *wait_us = s->async.meas_delay_us;
+    return 1;
+}
+
+static size_t bme280_sensor_collect_ops(void *ctx, i2c_sched_op_t *ops, size_t max)
+{
+    bme280_sensor_t *s = ctx;
+    if (max < 1) return 0;
+
+    ops[0] = (i2c_sched_op_t){
+        .dev = (i2c_master_dev_handle_t)s->async.dev->intf_ptr,
+        .tx = &s->read_reg,
+        .tx_len = 1,
+        .rx = s->raw,
+        .rx_len = s->async.normal ? BME280_DATA_LEN : BME280_SENSOR_BURST_LEN,
+    };
+    return 1;
+}
+
+static esp_err_t bme280_sensor_collect(void *ctx)
+{
+    bme280_sensor_t *s = ctx;
+
+    const uint8_t *d = s->raw;
+    if (!s->async.normal) {
+        if (s->raw[0] & BME280_STATUS_MEASURING) {
+            return ESP_ERR_NOT_FINISHED;
+        }
+        d += BME280_DATA_OFFSET;
+    }
+
+    struct bme280_uncomp_data uncomp = {
+        .pressure    = ((uint32_t)d[0] << 12) | ((uint32_t)d[1] << 4) | (d[2] >> 4),
+        .temperature = ((uint32_t)d[3] << 12) | ((uint32_t)d[4] << 4) | (d[5] >> 4),
+        .humidity    = ((uint32_t)d[6] << 8) | d[7],
+    };
+    if (uncomp.temperature == BME280_RAW_RESET_VALUE) {
+        return ESP_ERR_NOT_FINISHED;    // normal mode right after start: no conversion yet
+    }
+
+    int8_t rslt = bme280_compensate_data(BME280_ALL, &uncomp, &s->data, &s->async.dev->calib_data);
+    ESP_RETURN_ON_FALSE(rslt == BME280_OK, ESP_FAIL, TAG_BME_SENSOR, "compensate failed: %d", rslt);
+    return ESP_OK;
+}
+
+/**
+ * @brief After a bus recovery: full Bosch bring-up (calibration, settings), then the registry setup again.
+ */
+static esp_err_t bme280_sensor_recover(void *ctx)
+{
+    bme280_sensor_t *s = ctx;
+    ESP_RETURN_ON_ERROR(i2c_reconfigure_bme280(s->async.dev), TAG_BME_SENSOR, "reconfigure");
+    return bme280_sensor_init(ctx);
+}
+
+const sensor_driver_t bme280_sensor_driver = {
+    .init = bme280_sensor_init,
+    .trigger = bme280_sensor_trigger,
+    .collect_ops = bme280_sensor_collect_ops,
+    .collect = bme280_sensor_collect,
+    .recover = bme280_sensor_recover,
+};
@@ -0,0 +1,165 @@
+/**
+ * @file boot_graph.c
+ * @brief Dependency-ordered, concurrent boot sequence with a timeline.
+ *
+ * @details
+ * Run serially, the boot stages add up: NVS and the Wi-Fi driver, the I2C
+ * speed probe, the BME280 reset and calibration read and the SSD1306 init
+ * all wait on flash, the radio or the bus. Most of them do not depend on
+ * each other, so each stage gets its own task that blocks on the event group
+ * bits of its dependencies and sets its own bit when done. The stage tasks
+ * are unpinned, so two stages really run at once on the two cores.
+ *
+ * Only boot_graph_run() and the stage tasks touch @ref s_records; the event
+ * group orders a stage's writes before its dependents' reads.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+
+#include "sdkconfig.h"
+
+#include "boot_graph.h"
+
+static const char *TAG_BOOT = "BOOT";
+
+/**
+ * @brief Outcome of one stage.
+ */
+typedef struct {
+    int64_t start_us;
+    int64_t end_us;
+    esp_err_t err;
+} stage_record_t;
+
+static const boot_stage_t *s_stages;
+static stage_record_t s_records[BOOT_GRAPH_MAX_STAGES];
+static EventGroupHandle_t s_done;
+
+static int64_t s_done_us;
+static int64_t s_milestones[BOOT_MILESTONE_COUNT];
+static portMUX_TYPE s_milestone_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const s_milestone_names[BOOT_MILESTONE_COUNT] = {
+    [BOOT_MILESTONE_FIRST_SAMPLE] = "first sample",
+    [BOOT_MILESTONE_FIRST_FRAME] = "first frame",
+};
+
+/** Prints @p us as "ms.t" */
+#define US_MS(us)       (unsigned long)((us) / 1000), (unsigned)(((us) % 1000) / 100)
+
+static void stage_task(void *arg)
+{
+    size_t i = (size_t)arg;
+    const boot_stage_t *stage = &s_stages[i];
+
+    if (stage->deps) {
+        xEventGroupWaitBits(s_done, stage->deps, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    esp_err_t err = ESP_OK;
+    for (size_t d = 0; d < i; ++d) {
+        if ((stage->deps & (1u << d)) && s_records[d].err != ESP_OK) {
+            err = ESP_ERR_INVALID_STATE;    // a dependency failed: skip
+        }
+    }
+
+    s_records[i].start_us = esp_timer_get_time();
+    if (err == ESP_OK) {
+        err = stage->run();
+    }
+    s_records[i].end_us = esp_timer_get_time();
+    s_records[i].err = err;
+
+    xEventGroupSetBits(s_done, 1u << i);
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_graph_run(const boot_stage_t *stages, size_t count)
+{
+    ESP_RETURN_ON_FALSE(stages && count > 0 && count <= BOOT_GRAPH_MAX_STAGES, ESP_ERR_INVALID_ARG, TAG_BOOT,
+                        "bad table");
+    for (size_t i = 0; i < count; ++i) {
+        // Dependencies on earlier stages only: no cycles possible
+        ESP_RETURN_ON_FALSE((stages[i].deps >> i) == 0, ESP_ERR_INVALID_ARG, TAG_BOOT,
+                            "%s depends on a later stage", stages[i].name);
+    }
+
+    if (!s_done) {
+        s_done = xEventGroupCreate();
+        ESP_RETURN_ON_FALSE(s_done, ESP_ERR_NO_MEM, TAG_BOOT, "event group");
+    }
+    xEventGroupClearBits(s_done, (1u << BOOT_GRAPH_MAX_STAGES) - 1);
+    s_stages = stages;
+
+    const UBaseType_t prio = uxTaskPriorityGet(NULL);
+    const uint32_t all = (1u << count) - 1;
+    for (size_t i = 0; i < count; ++i) {
+        s_records[i] = (stage_record_t){0};
+        if (!stages[i].run) {
+            xEventGroupSetBits(s_done, 1u << i);
+            continue;
+        }
+        if (xTaskCreatePinnedToCore(stage_task, stages[i].name, CONFIG_APP_BOOT_STAGE_STACK, (void *)i,
+                                    prio, NULL, tskNO_AFFINITY) != pdPASS) {
+            // Stages already started may depend on this one: let them see the failure and finish
+            s_records[i].err = ESP_ERR_NO_MEM;
+            xEventGroupSetBits(s_done, 1u << i);
+        }
+    }
+    xEventGroupWaitBits(s_done, all, pdFALSE, pdTRUE, portMAX_DELAY);
+    s_done_us = esp_timer_get_time();
+
+    // ---- Timeline
+    esp_err_t first_err = ESP_OK;
+    ESP_LOGI(TAG_BOOT, "Boot timeline (ms since boot):");
+    for (size_t i = 0; i < count; ++i) {
+        const stage_record_t *r = &s_records[i];
+        if (!stages[i].run) continue;
+        ESP_LOGI(TAG_BOOT, "  %-10s %5lu.%u .. %5lu.%u  %s", stages[i].name, US_MS(r->start_us), US_MS(r->end_us),
+                 (r->err == ESP_OK) ? "" : esp_err_to_name(r->err));
+        if (r->err != ESP_OK && first_err == ESP_OK) {
+            first_err = r->err;
+        }
+    }
+    ESP_LOGI(TAG_BOOT, "  all stages done at %lu.%u", US_MS(s_done_us));
+    return first_err;
+}
+
+void boot_graph_mark(boot_milestone_t milestone)
+{
+    if (milestone >= BOOT_MILESTONE_COUNT) return;
+
+    int64_t now = esp_timer_get_time();
+    bool first = false;
+    portENTER_CRITICAL(&s_milestone_lock);
+    if (s_milestones[milestone] == 0) {
+        s_milestones[milestone] = now;
+        first = true;
+    }
+    portEXIT_CRITICAL(&s_milestone_lock);
+
+    if (first) {
+        ESP_LOGI(TAG_BOOT, "Boot to %s: %lu.%u ms", s_milestone_names[milestone], US_MS(now));
+    }
+}
+
+int64_t boot_graph_milestone_us(boot_milestone_t milestone)
+{
+    if (milestone >= BOOT_MILESTONE_COUNT) return 0;
+
+    portENTER_CRITICAL(&s_milestone_lock);
+    int64_t us = s_milestones[milestone];
+    portEXIT_CRITICAL(&s_milestone_lock);
+    return us;
+}
+
+int64_t boot_graph_done_us(void)
+{
+    return s_done_us;
+}
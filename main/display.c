@@ -0,0 +1,525 @@
+/**
+ * @file display.c
+ * @brief Dirty-region tracking framebuffer for the SSD1306.
+ *
+ * @details
+ * The ssd1306 driver only offers a full-frame ssd1306_update(), which pushes
+ * DISPLAY_WIDTH * DISPLAY_HEIGHT / 8 bytes on every call. This module keeps its
+ * own copy of the GDDRAM contents and records, per page, the column span that actually changed.
+ * display_flush() then programs a column/page window and streams just those bytes,
+ * as one normal-priority batch on the bus scheduler (i2c_sched.h).
+ *
+ * display_flush_async() queues that batch and returns at once. The window
+ * bytes are copied out of the framebuffer into a transmit buffer when the
+ * batch is built, so the two form a double buffer: the next frame is
+ * composed in @ref s_fb while the scheduler is still sending the previous
+ * one from @ref s_tx. Changes made meanwhile only widen the dirty spans and
+ * go out with the next flush.
+ *
+ * Drawing compares every byte against the framebuffer before storing it, so
+ * redrawing an unchanged string costs nothing on the bus.
+ *
+ * Glyphs come from a cell cache built once at init (font columns pre-padded to
+ * the 8 px advance). Fixed-layout text uses display_field_t: the static prefix
+ * and suffix are drawn once, and display_field_set() only blits the value
+ * characters that differ from what is already on screen.
+ */
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "i2c_bus.h"
+#include "i2c_sched.h"
+
+#include "display.h"
+#include "display_font.h"
+
+static const char *TAG_DISPLAY = "DISPLAY";
+
+#define SSD1306_CTRL_CMD            0x00    /**< Control byte: command stream */
+#define SSD1306_CTRL_DATA           0x40    /**< Control byte: GDDRAM data stream */
+#define SSD1306_SET_MEMORY_MODE     0x20
+#define SSD1306_MEMORY_MODE_HORIZ   0x00
+#define SSD1306_SET_COLUMN_ADDR     0x21
+#define SSD1306_SET_PAGE_ADDR       0x22
+#define SSD1306_CHARGE_PUMP         0x8D
+#define SSD1306_CHARGE_PUMP_ON      0x14
+#define SSD1306_DISPLAY_ON          0xAF
+#define SSD1306_SET_CONTRAST        0x81
+#define SSD1306_SET_START_LINE      0x40    /**< | start line 0..63 */
+#define SSD1306_GDDRAM_ROWS         64      /**< GDDRAM height, whatever the panel shows */
+#define SSD1306_GDDRAM_PAGES        (SSD1306_GDDRAM_ROWS / PIXELS_PER_PAGE)
+
+/** Bus bytes to address one window: command write (addr + ctrl + 6) plus data write header (addr + ctrl) */
+#define WINDOW_OVERHEAD_BYTES       10
+
+static i2c_master_dev_handle_t s_dev;
+static uint32_t s_bus_epoch;    /**< i2c_sched_device_epoch() the panel state was last set up at */
+static int16_t s_contrast = -1;     /**< Last contrast sent; -1 = not set by this module */
+static int16_t s_start_line = -1;   /**< Last start line sent; -1 = not set by this module */
+
+static uint8_t s_fb[DISPLAY_PAGES][DISPLAY_WIDTH];
+static uint16_t s_dirty_first[DISPLAY_PAGES];   /**< First dirty column; > s_dirty_last means clean */
+static uint16_t s_dirty_last[DISPLAY_PAGES];
+
+#define WINDOW_CMD_LEN              7       /**< Control byte + column range + page range */
+
+/** Flush batch: at most one window command and one data op per page */
+static i2c_sched_op_t s_batch[2 * DISPLAY_PAGES];
+static size_t s_batch_len;
+static uint8_t s_window_cmds[DISPLAY_PAGES][WINDOW_CMD_LEN];
+static size_t s_window_count;
+static uint8_t s_tx[DISPLAY_PAGES * (DISPLAY_WIDTH + 1)];   /**< Control byte + page bytes, per page */
+static i2c_sched_job_t s_flush_job;                  /**< Owns s_batch, s_window_cmds and s_tx while in flight */
+
+#define DISPLAY_FONT_GLYPHS         (DISPLAY_FONT_LAST_CHAR - DISPLAY_FONT_FIRST_CHAR + 1)
+
+/** Font expanded to padded column-major cells (1 px left, 2 px right), built by display_init() */
+static uint8_t s_cells[DISPLAY_FONT_GLYPHS][DISPLAY_FONT_CELL_WIDTH];
+
+static inline bool page_is_dirty(uint16_t page)
+{
+    return s_dirty_first[page] <= s_dirty_last[page];
+}
+
+static inline void page_mark_clean(uint16_t page)
+{
+    s_dirty_first[page] = DISPLAY_WIDTH;
+    s_dirty_last[page] = 0;
+}
+
+static void mark_all_dirty(void)
+{
+    for (uint16_t page = 0; page < DISPLAY_PAGES; ++page) {
+        s_dirty_first[page] = 0;
+        s_dirty_last[page] = DISPLAY_WIDTH - 1;
+    }
+}
+
+/**
+ * @brief Store the masked bits of one framebuffer byte and widen the dirty span if it changed.
+ */
+static void fb_write(uint16_t page, uint16_t col, uint8_t bits, uint8_t mask)
+{
+    if (page >= DISPLAY_PAGES || col >= DISPLAY_WIDTH) {
+        return;
+    }
+
+    uint8_t old = s_fb[page][col];
+    uint8_t val = (uint8_t)((old & ~mask) | (bits & mask));
+    if (val == old) {
+        return;
+    }
+
+    s_fb[page][col] = val;
+    if (col < s_dirty_first[page]) s_dirty_first[page] = col;
+    if (col > s_dirty_last[page])  s_dirty_last[page] = col;
+}
+
+/**
+ * @brief Write an 8 px tall pixel column whose top edge is at @p y.
+ *
+ * A column that is not page aligned is split across two pages.
+ */
+static void fb_write_column(uint16_t x, uint16_t y, uint8_t bits)
+{
+    uint16_t page = y / PIXELS_PER_PAGE;
+    uint8_t shift = y % PIXELS_PER_PAGE;
+
+    fb_write(page, x, (uint8_t)(bits << shift), (uint8_t)(0xFF << shift));
+    if (shift) {
+        fb_write(page + 1, x, (uint8_t)(bits >> (8 - shift)), (uint8_t)(0xFF >> (8 - shift)));
+    }
+}
+
+/**
+ * @brief Return the padded 8 px cell for character @p c from @ref s_cells.
+ */
+static inline const uint8_t *glyph_cell(char c)
+{
+    if (c < DISPLAY_FONT_FIRST_CHAR || c > DISPLAY_FONT_LAST_CHAR) {
+        c = '?';
+    }
+    return s_cells[c - DISPLAY_FONT_FIRST_CHAR];
+}
+
+/**
+ * @brief Expand the 5-column font into padded 8-column cells once.
+ *
+ * Drawing a character is then a straight copy of 8 column bytes.
+ */
+static void build_cell_cache(void)
+{
+    memset(s_cells, 0, sizeof(s_cells));
+    for (size_t glyph = 0; glyph < DISPLAY_FONT_GLYPHS; ++glyph) {
+        memcpy(&s_cells[glyph][1], display_font_5x7[glyph], DISPLAY_FONT_GLYPH_COLUMNS);
+    }
+}
+
+/**
+ * @brief Blit one 8x8 cell with its top edge at @p y.
+ */
+static void draw_cell(uint16_t x, uint16_t y, const uint8_t *cell)
+{
+    for (uint8_t col = 0; col < DISPLAY_FONT_CELL_WIDTH; ++col) {
+        fb_write_column(x + col, y, cell[col]);
+    }
+}
+
+static esp_err_t send_commands(const uint8_t *cmds, size_t len)
+{
+    uint8_t buf[12];
+    if (len >= sizeof(buf)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    buf[0] = SSD1306_CTRL_CMD;
+    memcpy(&buf[1], cmds, len);
+
+    const i2c_sched_op_t op = {
+        .dev = s_dev,
+        .tx = buf,
+        .tx_len = len + 1,
+        .flags = I2C_SCHED_OP_MERGEABLE,
+    };
+    return i2c_sched_submit(&op, 1, I2C_SCHED_PRIO_NORMAL);
+}
+
+/**
+ * @brief Append the ops for one page/column window to the flush batch.
+ *
+ * One command op programs the window, then one data op per page streams its
+ * bytes; the GDDRAM pointer carries over between data transactions. Splitting
+ * per page lets the bus scheduler run sensor reads between pages.
+ */
+static void queue_window(uint16_t first_page, uint16_t last_page,
+                         uint16_t first_col, uint16_t last_col)
+{
+    uint8_t *cmd = s_window_cmds[s_window_count++];
+    cmd[0] = SSD1306_CTRL_CMD;
+    cmd[1] = SSD1306_SET_COLUMN_ADDR;
+    cmd[2] = (uint8_t)first_col;
+    cmd[3] = (uint8_t)last_col;
+    cmd[4] = SSD1306_SET_PAGE_ADDR;
+    cmd[5] = (uint8_t)first_page;
+    cmd[6] = (uint8_t)last_page;
+    s_batch[s_batch_len++] = (i2c_sched_op_t){
+        .dev = s_dev, .tx = cmd, .tx_len = WINDOW_CMD_LEN, .flags = I2C_SCHED_OP_MERGEABLE,
+    };
+
+    size_t span = last_col - first_col + 1;
+    for (uint16_t page = first_page; page <= last_page; ++page) {
+        uint8_t *data = &s_tx[page * (DISPLAY_WIDTH + 1)];
+        data[0] = SSD1306_CTRL_DATA;
+        memcpy(&data[1], &s_fb[page][first_col], span);
+        s_batch[s_batch_len++] = (i2c_sched_op_t){
+            .dev = s_dev, .tx = data, .tx_len = span + 1,
+        };
+    }
+}
+
+/**
+ * @brief Zero the GDDRAM pages below the panel (128x32), at init and after a recovery.
+ *
+ * display_set_row_shift() moves the start line into them, so they must be
+ * blank. One window and one data write; callers make sure no flush owns @ref s_tx.
+ */
+static esp_err_t clear_hidden_pages(void)
+{
+    const size_t hidden = SSD1306_GDDRAM_PAGES - DISPLAY_PAGES;
+    if (hidden == 0) {
+        return ESP_OK;
+    }
+    _Static_assert(sizeof(s_tx) >= (SSD1306_GDDRAM_PAGES - DISPLAY_PAGES) * DISPLAY_WIDTH + 1,
+                   "s_tx too small for the hidden pages");
+
+    const uint8_t window[] = {
+        SSD1306_SET_COLUMN_ADDR, 0, DISPLAY_WIDTH - 1,
+        SSD1306_SET_PAGE_ADDR, DISPLAY_PAGES, SSD1306_GDDRAM_PAGES - 1,
+    };
+    ESP_RETURN_ON_ERROR(send_commands(window, sizeof(window)), TAG_DISPLAY, "window");
+
+    memset(s_tx, 0, hidden * DISPLAY_WIDTH + 1);
+    s_tx[0] = SSD1306_CTRL_DATA;
+    const i2c_sched_op_t op = { .dev = s_dev, .tx = s_tx, .tx_len = hidden * DISPLAY_WIDTH + 1 };
+    return i2c_sched_submit(&op, 1, I2C_SCHED_PRIO_NORMAL);
+}
+
+esp_err_t display_init(i2c_master_dev_handle_t dev)
+{
+    ESP_RETURN_ON_FALSE(dev, ESP_ERR_INVALID_ARG, TAG_DISPLAY, "no device");
+    s_dev = dev;
+    s_bus_epoch = i2c_sched_device_epoch(dev);
+
+    const uint8_t mode[] = { SSD1306_SET_MEMORY_MODE, SSD1306_MEMORY_MODE_HORIZ };
+    ESP_RETURN_ON_ERROR(send_commands(mode, sizeof(mode)), TAG_DISPLAY, "memory mode fail");
+    ESP_RETURN_ON_ERROR(clear_hidden_pages(), TAG_DISPLAY, "hidden pages clear fail");
+
+    build_cell_cache();
+    memset(s_fb, 0, sizeof(s_fb));
+    mark_all_dirty();
+    return ESP_OK;
+}
+
+void display_clear(void)
+{
+    for (uint16_t page = 0; page < DISPLAY_PAGES; ++page) {
+        for (uint16_t col = 0; col < DISPLAY_WIDTH; ++col) {
+            fb_write(page, col, 0x00, 0xFF);
+        }
+    }
+}
+
+void display_draw_string(uint16_t x, uint16_t y, const char *str)
+{
+    for (; *str; ++str, x += DISPLAY_FONT_CELL_WIDTH) {
+        draw_cell(x, y, glyph_cell(*str));
+    }
+}
+
+void display_draw_column(uint16_t x, uint16_t y, uint8_t height, uint32_t bits)
+{
+    if (height > 32) {
+        height = 32;
+    }
+
+    // At most 32 + 7 bits after the page shift, so one 64-bit word holds the whole run
+    uint8_t shift = y % PIXELS_PER_PAGE;
+    uint64_t mask = (((uint64_t)1 << height) - 1) << shift;
+    uint64_t value = ((uint64_t)bits << shift) & mask;
+    for (uint16_t page = y / PIXELS_PER_PAGE; mask; ++page, mask >>= 8, value >>= 8) {
+        fb_write(page, x, (uint8_t)value, (uint8_t)mask);
+    }
+}
+
+void display_draw_line_centered(uint16_t y, const char *str)
+{
+    size_t text_width = strlen(str) * DISPLAY_FONT_CELL_WIDTH;
+    uint16_t x0 = (text_width < DISPLAY_WIDTH) ? (uint16_t)((DISPLAY_WIDTH - text_width) / 2) : 0;
+
+    for (uint16_t x = 0; x < DISPLAY_WIDTH; ++x) {
+        uint8_t bits = 0x00;
+        if (x >= x0 && (size_t)(x - x0) < text_width) {
+            uint16_t offset = x - x0;
+            bits = glyph_cell(str[offset / DISPLAY_FONT_CELL_WIDTH])[offset % DISPLAY_FONT_CELL_WIDTH];
+        }
+        fb_write_column(x, y, bits);
+    }
+}
+
+void display_field_init(display_field_t *field, const display_field_layout_t *layout)
+{
+    uint8_t value_chars = layout->value_chars;
+    if (value_chars > DISPLAY_FIELD_MAX_CHARS) {
+        value_chars = DISPLAY_FIELD_MAX_CHARS;
+    }
+
+    field->y = layout->y;
+    field->value_x = layout->x + layout->prefix_chars * DISPLAY_FONT_CELL_WIDTH;
+    field->value_chars = value_chars;
+    field->align = layout->align;
+    memset(field->shown, 0, sizeof(field->shown));  // NUL never matches, so the first set draws everything
+
+    if (value_chars == 0) {
+        return;     // not on this panel
+    }
+
+    // Static parts are rasterized exactly once
+    display_draw_string(layout->x, layout->y, layout->prefix);
+    display_draw_string(field->value_x + value_chars * DISPLAY_FONT_CELL_WIDTH, layout->y, layout->suffix);
+}
+
+void display_field_set(display_field_t *field, const char *value)
+{
+    size_t len = strlen(value);
+    if (len > field->value_chars) {
+        len = field->value_chars;
+    }
+
+    size_t pad = field->value_chars - len;
+    size_t lead = (field->align == DISPLAY_ALIGN_RIGHT)  ? pad :
+                  (field->align == DISPLAY_ALIGN_CENTER) ? pad / 2 : 0;
+
+    for (size_t i = 0; i < field->value_chars; ++i) {
+        char c = (i >= lead && i - lead < len) ? value[i - lead] : ' ';
+        if (c == field->shown[i]) {
+            continue;
+        }
+        field->shown[i] = c;
+        draw_cell(field->value_x + i * DISPLAY_FONT_CELL_WIDTH, field->y, glyph_cell(c));
+    }
+}
+
+/**
+ * @brief Set the panel up again if the bus scheduler recovered it since the last flush.
+ *
+ * The fault may have cut a window short or reset the controller, so the
+ * addressing mode, charge pump and display-on state are sent again, with the
+ * contrast and start line if this module set them, the pages below a 128x32
+ * panel are cleared again, and the whole frame is redrawn.
+ */
+static esp_err_t resync_after_recovery(void)
+{
+    uint32_t epoch = i2c_sched_device_epoch(s_dev);
+    if (epoch == s_bus_epoch) {
+        return ESP_OK;
+    }
+
+    uint8_t setup[8] = {
+        SSD1306_SET_MEMORY_MODE, SSD1306_MEMORY_MODE_HORIZ,
+        SSD1306_CHARGE_PUMP, SSD1306_CHARGE_PUMP_ON,
+        SSD1306_DISPLAY_ON,
+    };
+    size_t len = 5;
+    if (s_contrast >= 0) {
+        setup[len++] = SSD1306_SET_CONTRAST;
+        setup[len++] = (uint8_t)s_contrast;
+    }
+    if (s_start_line >= 0) {
+        setup[len++] = (uint8_t)(SSD1306_SET_START_LINE | s_start_line);
+    }
+    ESP_RETURN_ON_ERROR(send_commands(setup, len), TAG_DISPLAY, "panel re-init fail");
+    ESP_RETURN_ON_ERROR(clear_hidden_pages(), TAG_DISPLAY, "hidden pages clear fail");
+    s_bus_epoch = epoch;
+    mark_all_dirty();
+    ESP_LOGW(TAG_DISPLAY, "Panel re-initialized after bus recovery, redrawing");
+    return ESP_OK;
+}
+
+/**
+ * @brief Collect the outcome of the previous async flush.
+ *
+ * A failed batch may have left any of its windows unsent, so the whole frame
+ * is marked dirty again.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FINISHED while the batch is in flight, or its error.
+ */
+static esp_err_t reap_flush(void)
+{
+    esp_err_t err = i2c_sched_job_result(&s_flush_job);
+    if (err != ESP_OK && err != ESP_ERR_NOT_FINISHED) {
+        mark_all_dirty();
+        s_flush_job.result = ESP_OK;    // report each failure once
+    }
+    return err;
+}
+
+/**
+ * @brief Build the flush batch from the dirty spans and mark those pages clean.
+ *
+ * The data is copied into @ref s_tx, so the framebuffer is free again as soon as this returns.
+ *
+ * @return Number of ops in @ref s_batch, 0 if nothing changed.
+ */
+static size_t build_flush_batch(void)
+{
+    s_batch_len = 0;
+    s_window_count = 0;
+
+    uint16_t page = 0;
+    while (page < DISPLAY_PAGES) {
+        if (!page_is_dirty(page)) {
+            ++page;
+            continue;
+        }
+
+        // Grow the window downwards while one taller window is cheaper than two
+        uint16_t first_page = page;
+        uint16_t last_page = page;
+        uint16_t first_col = s_dirty_first[page];
+        uint16_t last_col = s_dirty_last[page];
+
+        while (last_page + 1 < DISPLAY_PAGES && page_is_dirty(last_page + 1)) {
+            uint16_t next = last_page + 1;
+            uint16_t merged_first = (s_dirty_first[next] < first_col) ? s_dirty_first[next] : first_col;
+            uint16_t merged_last  = (s_dirty_last[next] > last_col) ? s_dirty_last[next] : last_col;
+
+            size_t cost_now    = (size_t)(last_page - first_page + 1) * (last_col - first_col + 1);
+            size_t cost_split  = cost_now + (s_dirty_last[next] - s_dirty_first[next] + 1) + WINDOW_OVERHEAD_BYTES;
+            size_t cost_merged = (size_t)(next - first_page + 1) * (merged_last - merged_first + 1);
+            if (cost_merged > cost_split) {
+                break;
+            }
+
+            last_page = next;
+            first_col = merged_first;
+            last_col = merged_last;
+        }
+
+        queue_window(first_page, last_page, first_col, last_col);
+        page = last_page + 1;
+    }
+
+    for (uint16_t p = 0; p < DISPLAY_PAGES; ++p) {
+        page_mark_clean(p);
+    }
+    return s_batch_len;
+}
+
+esp_err_t display_set_contrast(uint8_t level)
+{
+    if (s_contrast == level) {
+        return ESP_OK;
+    }
+    const uint8_t cmd[] = { SSD1306_SET_CONTRAST, level };
+    ESP_RETURN_ON_ERROR(send_commands(cmd, sizeof(cmd)), TAG_DISPLAY, "contrast fail");
+    s_contrast = level;
+    return ESP_OK;
+}
+
+esp_err_t display_set_row_shift(uint8_t rows)
+{
+    ESP_RETURN_ON_FALSE(rows < SSD1306_GDDRAM_ROWS, ESP_ERR_INVALID_ARG, TAG_DISPLAY, "shift %u", rows);
+
+    // Showing from row 64 - n moves the image down by n; the top n rows show GDDRAM rows 64 - n..63, which
+    // are the hidden pages on 128x32 but the bottom of the frame on 128x64, so the layout must leave them blank
+    int16_t line = (int16_t)((SSD1306_GDDRAM_ROWS - rows) % SSD1306_GDDRAM_ROWS);
+    if (s_start_line == line) {
+        return ESP_OK;
+    }
+    const uint8_t cmd[] = { (uint8_t)(SSD1306_SET_START_LINE | line) };
+    ESP_RETURN_ON_ERROR(send_commands(cmd, sizeof(cmd)), TAG_DISPLAY, "start line fail");
+    s_start_line = line;
+    return ESP_OK;
+}
+
+esp_err_t display_flush(void)
+{
+    esp_err_t err = reap_flush();
+    ESP_RETURN_ON_FALSE(err != ESP_ERR_NOT_FINISHED, ESP_ERR_INVALID_STATE, TAG_DISPLAY, "async flush in flight");
+    ESP_RETURN_ON_ERROR(err, TAG_DISPLAY, "previous flush fail");
+    ESP_RETURN_ON_ERROR(resync_after_recovery(), TAG_DISPLAY, "resync");
+
+    if (build_flush_batch() == 0) {
+        return ESP_OK;
+    }
+
+    err = i2c_sched_submit(s_batch, s_batch_len, I2C_SCHED_PRIO_NORMAL);
+    if (err != ESP_OK) {
+        mark_all_dirty();
+    }
+    ESP_RETURN_ON_ERROR(err, TAG_DISPLAY, "flush fail");
+    return ESP_OK;
+}
+
+esp_err_t display_flush_async(uint32_t notify_bits)
+{
+    esp_err_t err = reap_flush();
+    if (err == ESP_ERR_NOT_FINISHED) {
+        return ESP_OK;  // changes wait in s_fb; the caller retries on notify_bits
+    }
+    ESP_RETURN_ON_ERROR(err, TAG_DISPLAY, "flush fail");
+    ESP_RETURN_ON_ERROR(resync_after_recovery(), TAG_DISPLAY, "resync");
+
+    if (build_flush_batch() == 0) {
+        return ESP_OK;
+    }
+
+    err = i2c_sched_submit_async(&s_flush_job, s_batch, s_batch_len, I2C_SCHED_PRIO_NORMAL, notify_bits);
+    if (err != ESP_OK) {
+        mark_all_dirty();
+    }
+    ESP_RETURN_ON_ERROR(err, TAG_DISPLAY, "flush submit fail");
+    return ESP_OK;
+}
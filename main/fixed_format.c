@@ -0,0 +1,100 @@
+/**
+ * @file fixed_format.c
+ * @brief Integer-only decimal formatting for the display path.
+ *
+ * @details
+ * Replaces snprintf("%.1f") in the render loop: no double arithmetic and no
+ * floating-point printf support pulled in for it.
+ */
+
+#include "fixed_format.h"
+
+static const uint32_t pow10_table[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+size_t fixed_format(char *out, size_t size, int32_t value, unsigned scale, unsigned decimals)
+{
+    if (!out || size == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+    if (scale >= sizeof(pow10_table) / sizeof(pow10_table[0]) || decimals > scale) {
+        return 0;
+    }
+
+    bool negative = value < 0;
+    uint32_t magnitude = negative ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+
+    // Drop the hidden digits, rounding half away from zero
+    uint32_t drop = pow10_table[scale - decimals];
+    if (drop > 1) {
+        magnitude = magnitude / drop + ((magnitude % drop) >= drop / 2 ? 1 : 0);
+    }
+
+    // Digits in reverse, then the sign
+    char tmp[16];
+    size_t n = 0;
+    for (unsigned digit = 0; digit < decimals; ++digit) {
+        tmp[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    }
+    if (decimals > 0) {
+        tmp[n++] = '.';
+    }
+    do {
+        tmp[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (negative) {
+        // "-0.0" reads oddly for values that round to zero
+        bool all_zero = true;
+        for (size_t i = 0; i < n; ++i) {
+            if (tmp[i] != '0' && tmp[i] != '.') all_zero = false;
+        }
+        if (!all_zero) tmp[n++] = '-';
+    }
+
+    if (n + 1 > size) {
+        return 0;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = tmp[n - 1 - i];
+    }
+    out[n] = '\0';
+    return n;
+}
+
+/**
+ * @brief Nearest multiple of @p step, half away from zero.
+ */
+static int32_t round_to_step(int32_t value, int32_t step)
+{
+    int64_t v = value;
+    int64_t half = step / 2;
+    int64_t q = (v < 0) ? -((-v + half) / step) : (v + half) / step;
+    return (int32_t)(q * step);
+}
+
+bool fixed_quantize(fixed_hold_t *hold, int32_t value, int32_t step, int32_t hysteresis)
+{
+    if (step <= 0) {
+        step = 1;
+    }
+    if (hold->valid) {
+        // Compared doubled, so odd steps keep their exact midpoint
+        int64_t distance = (int64_t)value - hold->shown;
+        if (distance < 0) {
+            distance = -distance;
+        }
+        if (2 * distance < (int64_t)step + 2 * (int64_t)hysteresis) {
+            return false;
+        }
+    }
+
+    int32_t shown = round_to_step(value, step);
+    bool changed = !hold->valid || shown != hold->shown;
+    hold->shown = shown;
+    hold->valid = true;
+    return changed;
+}
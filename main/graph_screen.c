@@ -0,0 +1,195 @@
+/**
+ * @file graph_screen.c
+ * @brief Sweep-updated sparklines of the sample history.
+ *
+ * @details
+ * The screen keeps one averaged sample per pixel column (@ref s_cols), rebuilt
+ * from sensor_history.h whenever the screen is entered. While it is shown,
+ * every CONFIG_APP_GRAPH_SAMPLES_PER_COLUMN new samples complete one column,
+ * which is drawn at the sweep cursor with display_draw_column(); untouched
+ * columns stay clean in the dirty-tracked framebuffer, so the graph costs
+ * about as much on the bus as the text screen.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_APP_GRAPH_SCREEN
+
+#include <string.h>
+
+#include "graph_screen.h"
+#include "sensor_history.h"
+
+#define GRAPH_SAMPLES_PER_COLUMN    CONFIG_APP_GRAPH_SAMPLES_PER_COLUMN
+#define GRAPH_STRIPS                3
+#define GRAPH_MAX_COLUMNS           (DISPLAY_WIDTH - 1) /**< One column is always the sweep gap */
+
+/**
+ * @brief Vertical placement and scale of one sparkline.
+ */
+typedef struct {
+    uint16_t y;             /**< Top edge in pixels */
+    int32_t min_span;       /**< Smallest range shown, so sensor noise is not blown up to full height */
+    int32_t lo, hi;         /**< Current scale, in sample units */
+} graph_strip_t;
+
+static graph_strip_t s_strips[GRAPH_STRIPS] = {
+    { .y = GRAPH_STRIP_PITCH * 0, .min_span = 100 },    // temperature: 1 °C
+    { .y = GRAPH_STRIP_PITCH * 1, .min_span = 200 },    // humidity: 2 %RH
+    { .y = GRAPH_STRIP_PITCH * 2, .min_span = 100 },    // pressure: 1 hPa
+};
+
+static sensor_sample_t s_cols[DISPLAY_WIDTH];   /**< Column means, indexed by x */
+static bool s_valid[DISPLAY_WIDTH];     /**< Column holds data (the gap never does) */
+static uint16_t s_cursor;               /**< Next column to write; blank while shown */
+static uint32_t s_end;                  /**< sensor_history_total() covered by the newest column */
+static bool s_scaled;                   /**< s_strips[].lo/hi are set */
+
+_Static_assert(GRAPH_STRIPS * GRAPH_STRIP_PITCH - (GRAPH_STRIP_PITCH - GRAPH_STRIP_HEIGHT) <= DISPLAY_HEIGHT - GRAPH_SHIFT_RESERVE,
+               "strips do not fit above the shift reserve");
+
+static int32_t strip_value(size_t strip, const sensor_sample_t *s)
+{
+    switch (strip) {
+    case 0:  return s->temperature_c100;
+    case 1:  return s->humidity_c100;
+    default: return (int32_t)s->pressure_pa;
+    }
+}
+
+/**
+ * @brief Fit every strip to the range of the valid columns, plus 1/8 headroom on each side.
+ *
+ * The headroom means a slowly drifting value only rescales every few columns.
+ */
+static void rescale(void)
+{
+    s_scaled = false;
+    for (size_t strip = 0; strip < GRAPH_STRIPS; ++strip) {
+        graph_strip_t *st = &s_strips[strip];
+        bool any = false;
+        int32_t lo = 0, hi = 0;
+        for (uint16_t x = 0; x < DISPLAY_WIDTH; ++x) {
+            if (!s_valid[x]) continue;
+            int32_t v = strip_value(strip, &s_cols[x]);
+            if (!any || v < lo) lo = v;
+            if (!any || v > hi) hi = v;
+            any = true;
+        }
+        if (!any) return;
+
+        int32_t span = hi - lo;
+        if (span < st->min_span) {
+            lo -= (st->min_span - span) / 2;
+            span = st->min_span;
+        }
+        st->lo = lo - span / 8;
+        st->hi = lo + span + span / 8;
+    }
+    s_scaled = true;
+}
+
+static bool in_scale(const sensor_sample_t *s)
+{
+    if (!s_scaled) return false;
+    for (size_t strip = 0; strip < GRAPH_STRIPS; ++strip) {
+        int32_t v = strip_value(strip, s);
+        if (v < s_strips[strip].lo || v > s_strips[strip].hi) return false;
+    }
+    return true;
+}
+
+/** Pixel row of @p v inside its strip, 0 = top */
+static inline uint8_t row_of(const graph_strip_t *st, int32_t v)
+{
+    int64_t span = st->hi - st->lo;
+    int64_t row = (GRAPH_STRIP_HEIGHT - 1) - ((int64_t)(v - st->lo) * (GRAPH_STRIP_HEIGHT - 1) + span / 2) / span;
+    return (uint8_t)((row < 0) ? 0 : (row > GRAPH_STRIP_HEIGHT - 1) ? GRAPH_STRIP_HEIGHT - 1 : row);
+}
+
+/**
+ * @brief Draw column @p x of every strip: a vertical run from the previous column's row to this one's.
+ *
+ * Joining neighbours keeps steep changes visible as a line rather than scattered dots.
+ */
+static void draw_column(uint16_t x)
+{
+    uint16_t prev = (x + DISPLAY_WIDTH - 1) % DISPLAY_WIDTH;
+
+    for (size_t strip = 0; strip < GRAPH_STRIPS; ++strip) {
+        const graph_strip_t *st = &s_strips[strip];
+        uint32_t bits = 0;
+        if (s_valid[x] && s_scaled) {
+            uint8_t top = row_of(st, strip_value(strip, &s_cols[x]));
+            uint8_t bottom = top;
+            if (s_valid[prev]) {
+                uint8_t joined = row_of(st, strip_value(strip, &s_cols[prev]));
+                if (joined < top) top = joined;
+                if (joined > bottom) bottom = joined;
+            }
+            bits = ((2u << bottom) - 1) & ~((1u << top) - 1);
+        }
+        display_draw_column(x, st->y, GRAPH_STRIP_HEIGHT, bits);
+    }
+}
+
+static void draw_all_columns(void)
+{
+    for (uint16_t x = 0; x < DISPLAY_WIDTH; ++x) {
+        draw_column(x);
+    }
+}
+
+void graph_screen_draw(void)
+{
+    memset(s_valid, 0, sizeof(s_valid));
+
+    s_end = sensor_history_total();
+    size_t columns = sensor_history_count() / GRAPH_SAMPLES_PER_COLUMN;
+    if (columns > GRAPH_MAX_COLUMNS) {
+        columns = GRAPH_MAX_COLUMNS;
+    }
+    for (size_t x = 0; x < columns; ++x) {
+        uint32_t end = s_end - (uint32_t)((columns - 1 - x) * GRAPH_SAMPLES_PER_COLUMN);
+        s_valid[x] = sensor_history_mean(end, GRAPH_SAMPLES_PER_COLUMN, &s_cols[x]);
+    }
+    s_cursor = (uint16_t)columns;
+
+    rescale();
+    draw_all_columns();
+    if (!s_scaled) {
+        // Overdrawn by the opaque columns once the first one is complete
+        display_draw_line_centered(GRAPH_STRIP_PITCH + (GRAPH_STRIP_HEIGHT - PIXELS_PER_PAGE) / 2, "collecting...");
+    }
+}
+
+void graph_screen_update(void)
+{
+    sensor_sample_t col;
+    while (sensor_history_total() - s_end >= GRAPH_SAMPLES_PER_COLUMN) {
+        s_end += GRAPH_SAMPLES_PER_COLUMN;
+        if (!sensor_history_mean(s_end, GRAPH_SAMPLES_PER_COLUMN, &col)) {
+            continue;   // fell out of the ring while the render loop was busy
+        }
+
+        uint16_t x = s_cursor;
+        uint16_t gap = (x + 1) % DISPLAY_WIDTH;
+        uint16_t after_gap = (x + 2) % DISPLAY_WIDTH;
+
+        s_cols[x] = col;
+        s_valid[x] = true;
+        s_valid[gap] = false;
+        s_cursor = gap;
+
+        if (!in_scale(&col)) {
+            rescale();
+            draw_all_columns();
+            continue;
+        }
+        draw_column(x);
+        draw_column(gap);
+        draw_column(after_gap);     // lost its left neighbour to the gap
+    }
+}
+
+#endif // CONFIG_APP_GRAPH_SCREEN
@@ -0,0 +1,190 @@
+/**
+ * @file history_log.c
+ * @brief Append-only, wear-levelled sample log in a raw flash partition.
+ *
+ * @details
+ * The partition is used as a circular sequence of 4 KB sectors. Each sector
+ * starts with a header carrying a magic and a sequence number that grows by
+ * one per sector written; fixed-size records follow. Records are only ever
+ * appended into erased flash, and a sector is erased only when the writer
+ * wraps around to it, so every sector sees the same number of erase cycles.
+ *
+ * Each record carries a CRC32 of its sample, so a record torn by a power cut
+ * is recognized and skipped. At boot the sector with the highest sequence
+ * number is the active one; its first erased record slot is the write position.
+ */
+
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#include "history_log.h"
+
+#define HISTORY_LOG_SECTOR_SIZE     4096
+#define HISTORY_LOG_HEADER_SIZE     HISTORY_LOG_RECORD_SIZE       /**< Header occupies the first record slot */
+#define HISTORY_LOG_RECORDS         ((HISTORY_LOG_SECTOR_SIZE - HISTORY_LOG_HEADER_SIZE) / HISTORY_LOG_RECORD_SIZE)
+
+static const char *TAG_HLOG = "HISTORY_LOG";
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t record_size;
+    uint32_t reserved;
+} history_log_header_t;
+
+typedef struct {
+    sensor_sample_t sample;
+    uint32_t crc;
+} history_log_record_t;
+
+_Static_assert(sizeof(history_log_header_t) == HISTORY_LOG_HEADER_SIZE, "header must fill one slot");
+_Static_assert(sizeof(history_log_record_t) == HISTORY_LOG_RECORD_SIZE, "record layout changed");
+
+static const esp_partition_t *s_part;
+static size_t s_sectors;
+static size_t s_active;             /**< Sector being appended to */
+static uint32_t s_active_seq;
+static size_t s_next_record;        /**< Next free slot in the active sector */
+
+static inline size_t record_offset(size_t sector, size_t record)
+{
+    return sector * HISTORY_LOG_SECTOR_SIZE + HISTORY_LOG_HEADER_SIZE + record * HISTORY_LOG_RECORD_SIZE;
+}
+
+static inline uint32_t record_crc(const sensor_sample_t *sample)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)sample, sizeof(*sample));
+}
+
+static bool is_erased(const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    for (size_t i = 0; i < len; ++i) {
+        if (p[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+static bool read_header(size_t sector, history_log_header_t *hdr)
+{
+    if (esp_partition_read(s_part, sector * HISTORY_LOG_SECTOR_SIZE, hdr, sizeof(*hdr)) != ESP_OK) {
+        return false;
+    }
+    return hdr->magic == HISTORY_LOG_MAGIC && hdr->record_size == HISTORY_LOG_RECORD_SIZE;
+}
+
+/**
+ * @brief Erase @p sector and stamp it with sequence number @p seq.
+ */
+static esp_err_t open_sector(size_t sector, uint32_t seq)
+{
+    ESP_RETURN_ON_ERROR(esp_partition_erase_range(s_part, sector * HISTORY_LOG_SECTOR_SIZE, HISTORY_LOG_SECTOR_SIZE),
+                        TAG_HLOG, "erase");
+    const history_log_header_t hdr = {
+        .magic = HISTORY_LOG_MAGIC,
+        .seq = seq,
+        .record_size = HISTORY_LOG_RECORD_SIZE,
+        .reserved = 0xFFFFFFFF,
+    };
+    ESP_RETURN_ON_ERROR(esp_partition_write(s_part, sector * HISTORY_LOG_SECTOR_SIZE, &hdr, sizeof(hdr)),
+                        TAG_HLOG, "header");
+
+    s_active = sector;
+    s_active_seq = seq;
+    s_next_record = 0;
+    return ESP_OK;
+}
+
+esp_err_t history_log_init(void)
+{
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, HISTORY_LOG_PARTITION_SUBTYPE,
+                                      HISTORY_LOG_PARTITION_LABEL);
+    if (!s_part) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_sectors = s_part->size / HISTORY_LOG_SECTOR_SIZE;
+    ESP_RETURN_ON_FALSE(s_sectors >= 2, ESP_ERR_INVALID_SIZE, TAG_HLOG, "partition too small");
+
+    // Newest sector = highest sequence number
+    bool found = false;
+    for (size_t sector = 0; sector < s_sectors; ++sector) {
+        history_log_header_t hdr;
+        if (read_header(sector, &hdr) && (!found || (int32_t)(hdr.seq - s_active_seq) > 0)) {
+            s_active = sector;
+            s_active_seq = hdr.seq;
+            found = true;
+        }
+    }
+    if (!found) {
+        ESP_LOGI(TAG_HLOG, "Empty log, formatting first sector");
+        return open_sector(0, 1);
+    }
+
+    // First erased slot of the active sector
+    s_next_record = HISTORY_LOG_RECORDS;
+    for (size_t record = 0; record < HISTORY_LOG_RECORDS; ++record) {
+        history_log_record_t rec;
+        ESP_RETURN_ON_ERROR(esp_partition_read(s_part, record_offset(s_active, record), &rec, sizeof(rec)),
+                            TAG_HLOG, "scan");
+        if (is_erased(&rec, sizeof(rec))) {
+            s_next_record = record;
+            break;
+        }
+    }
+    ESP_LOGI(TAG_HLOG, "Sector %u (seq %lu), record %u of %u", (unsigned)s_active, (unsigned long)s_active_seq,
+             (unsigned)s_next_record, (unsigned)HISTORY_LOG_RECORDS);
+    return ESP_OK;
+}
+
+esp_err_t history_log_append(const sensor_sample_t *sample)
+{
+    ESP_RETURN_ON_FALSE(s_part, ESP_ERR_INVALID_STATE, TAG_HLOG, "not initialized");
+
+    if (s_next_record >= HISTORY_LOG_RECORDS) {
+        ESP_RETURN_ON_ERROR(open_sector((s_active + 1) % s_sectors, s_active_seq + 1), TAG_HLOG, "next sector");
+    }
+
+    history_log_record_t rec = {
+        .sample = *sample,
+        .crc = record_crc(sample),
+    };
+    ESP_RETURN_ON_ERROR(esp_partition_write(s_part, record_offset(s_active, s_next_record), &rec, sizeof(rec)),
+                        TAG_HLOG, "write");
+    s_next_record++;
+    return ESP_OK;
+}
+
+size_t history_log_foreach(history_log_visit_t visit, void *ctx)
+{
+    if (!s_part || !visit) return 0;
+
+    size_t visited = 0;
+    // Oldest sector is the one after the active sector; walk the ring up to and including it
+    for (size_t step = 1; step <= s_sectors; ++step) {
+        size_t sector = (s_active + step) % s_sectors;
+        history_log_header_t hdr;
+        if (!read_header(sector, &hdr)) continue;
+
+        size_t records = (sector == s_active) ? s_next_record : HISTORY_LOG_RECORDS;
+        for (size_t record = 0; record < records; ++record) {
+            history_log_record_t rec;
+            if (esp_partition_read(s_part, record_offset(sector, record), &rec, sizeof(rec)) != ESP_OK) break;
+            if (is_erased(&rec, sizeof(rec))) break;
+            if (rec.crc != record_crc(&rec.sample)) continue;
+
+            visited++;
+            if (!visit(&rec.sample, ctx)) return visited;
+        }
+    }
+    return visited;
+}
+
+size_t history_log_capacity(void)
+{
+    // Wrapping erases one whole sector, so one sector's worth is always in flux
+    return s_part ? (s_sectors - 1) * HISTORY_LOG_RECORDS : 0;
+}
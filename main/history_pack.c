@@ -0,0 +1,227 @@
+/**
+ * @file history_pack.c
+ * @brief Streaming encoder for the history_pack.h format.
+ *
+ * @details
+ * The encoder holds one pending run (a count and the newest timestamp) and
+ * the values the decoder last saw; every byte it produces goes to the sink
+ * as soon as its record is complete, with the block CRC chained along, so
+ * a stream of any length needs a few dozen bytes of state and one record
+ * of stack.
+ */
+
+#include <string.h>
+
+#include "esp_rom_crc.h"
+
+#include "history_pack.h"
+
+static const uint8_t HISTORY_PACK_MAGIC[2] = { 'h', 'p' };
+
+#define HISTORY_PACK_HEADER_MAX     38      /**< magic, version, 3 steps, timestamp, 3 values */
+
+#define MASK_TEMPERATURE            (1u << 0)
+#define MASK_HUMIDITY               (1u << 1)
+#define MASK_PRESSURE               (1u << 2)
+#define TAG_COUNT_SHIFT             3
+
+_Static_assert(CONFIG_APP_HISTORY_PACK_TEMP_STEP_C100 > 0 && CONFIG_APP_HISTORY_PACK_HUM_STEP_C100 > 0 &&
+               CONFIG_APP_HISTORY_PACK_PRES_STEP_PA > 0, "pack steps must be positive");
+
+static size_t put_varint(uint8_t *out, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static inline uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+/**
+ * @brief Send @p len bytes to the sink and chain them into the block CRC.
+ */
+static esp_err_t emit(history_pack_t *pack, const uint8_t *data, size_t len, bool in_crc)
+{
+    if (pack->err != ESP_OK) {
+        return pack->err;
+    }
+    if (in_crc) {
+        pack->crc = esp_rom_crc32_le(pack->crc, data, len);
+    }
+    pack->err = pack->write(data, len, pack->ctx);
+    if (pack->err == ESP_OK) {
+        pack->bytes += len;
+    }
+    return pack->err;
+}
+
+/**
+ * @brief Quantize @p sample into the holds.
+ *
+ * @return Mask of the channels whose quantized value moved off what the decoder knows.
+ */
+static uint32_t quantize(history_pack_t *pack, const sensor_sample_t *sample)
+{
+    fixed_quantize(&pack->temperature, sample->temperature_c100, pack->step_t, pack->step_t / 2);
+    fixed_quantize(&pack->humidity, sample->humidity_c100, pack->step_h, pack->step_h / 2);
+    fixed_quantize(&pack->pressure, (int32_t)sample->pressure_pa, pack->step_p, pack->step_p / 2);
+
+    uint32_t mask = 0;
+    if (pack->temperature.shown / pack->step_t != pack->base_t) mask |= MASK_TEMPERATURE;
+    if (pack->humidity.shown / pack->step_h != pack->base_h)    mask |= MASK_HUMIDITY;
+    if (pack->pressure.shown / pack->step_p != pack->base_p)    mask |= MASK_PRESSURE;
+    return mask;
+}
+
+/**
+ * @brief Write one record covering the pending run and, if @p mask is set, the current sample.
+ */
+static esp_err_t put_record(history_pack_t *pack, uint32_t mask, uint32_t last_ts)
+{
+    uint8_t rec[HISTORY_PACK_RECORD_MAX];
+    size_t n = put_varint(rec, (pack->run_count << TAG_COUNT_SHIFT) | mask);
+    n += put_varint(&rec[n], zigzag((int32_t)(last_ts - pack->base_ts)));
+
+    if (mask & MASK_TEMPERATURE) {
+        int32_t v = pack->temperature.shown / pack->step_t;
+        n += put_varint(&rec[n], zigzag(v - pack->base_t));
+        pack->base_t = v;
+    }
+    if (mask & MASK_HUMIDITY) {
+        int32_t v = pack->humidity.shown / pack->step_h;
+        n += put_varint(&rec[n], zigzag(v - pack->base_h));
+        pack->base_h = v;
+    }
+    if (mask & MASK_PRESSURE) {
+        int32_t v = pack->pressure.shown / pack->step_p;
+        n += put_varint(&rec[n], zigzag(v - pack->base_p));
+        pack->base_p = v;
+    }
+
+    pack->base_ts = last_ts;
+    pack->run_count = 0;
+    return emit(pack, rec, n, true);
+}
+
+/**
+ * @brief Whether a sample at @p ts continues the pending run's cadence.
+ *
+ * The run's mean interval is span / count; the new interval may differ from
+ * it by @ref HISTORY_PACK_JITTER_S. Compared multiplied by count, in 64 bits.
+ */
+static bool cadence_fits(const history_pack_t *pack, uint32_t ts)
+{
+    if (pack->run_count == 0) {
+        return true;
+    }
+    int64_t interval = (int32_t)(ts - pack->run_last_ts);
+    int64_t span = (int32_t)(pack->run_last_ts - pack->base_ts);
+    int64_t n = pack->run_count;
+    int64_t deviation = interval * n - span;
+    return interval >= 0 && span >= 0 && deviation <= HISTORY_PACK_JITTER_S * n && deviation >= -HISTORY_PACK_JITTER_S * n;
+}
+
+/**
+ * @brief Open a block: header and keyframe with @p sample's quantized values.
+ */
+static esp_err_t open_block(history_pack_t *pack, const sensor_sample_t *sample)
+{
+    quantize(pack, sample);
+    pack->base_t = pack->temperature.shown / pack->step_t;
+    pack->base_h = pack->humidity.shown / pack->step_h;
+    pack->base_p = pack->pressure.shown / pack->step_p;
+    pack->base_ts = sample->timestamp;
+    pack->run_count = 0;
+    pack->crc = 0;
+    pack->in_block = true;
+    pack->block_samples = 1;
+
+    uint8_t hdr[HISTORY_PACK_HEADER_MAX];
+    size_t n = 0;
+    memcpy(hdr, HISTORY_PACK_MAGIC, sizeof(HISTORY_PACK_MAGIC));
+    n += sizeof(HISTORY_PACK_MAGIC);
+    hdr[n++] = HISTORY_PACK_VERSION;
+    n += put_varint(&hdr[n], (uint32_t)pack->step_t);
+    n += put_varint(&hdr[n], (uint32_t)pack->step_h);
+    n += put_varint(&hdr[n], (uint32_t)pack->step_p);
+    n += put_varint(&hdr[n], sample->timestamp);
+    n += put_varint(&hdr[n], zigzag(pack->base_t));
+    n += put_varint(&hdr[n], (uint32_t)pack->base_h);
+    n += put_varint(&hdr[n], (uint32_t)pack->base_p);
+    return emit(pack, hdr, n, true);
+}
+
+/**
+ * @brief Flush the pending run, then write the end marker and the CRC.
+ */
+static esp_err_t close_block(history_pack_t *pack)
+{
+    if (pack->run_count) {
+        put_record(pack, 0, pack->run_last_ts);
+    }
+
+    const uint8_t end = 0;
+    emit(pack, &end, 1, true);
+
+    const uint8_t crc[4] = {
+        (uint8_t)pack->crc, (uint8_t)(pack->crc >> 8), (uint8_t)(pack->crc >> 16), (uint8_t)(pack->crc >> 24),
+    };
+    pack->in_block = false;
+    return emit(pack, crc, sizeof(crc), false);
+}
+
+void history_pack_begin(history_pack_t *pack, history_pack_write_t write, void *ctx)
+{
+    *pack = (history_pack_t){
+        .write = write,
+        .ctx = ctx,
+        .err = ESP_OK,
+        .step_t = CONFIG_APP_HISTORY_PACK_TEMP_STEP_C100,
+        .step_h = CONFIG_APP_HISTORY_PACK_HUM_STEP_C100,
+        .step_p = CONFIG_APP_HISTORY_PACK_PRES_STEP_PA,
+    };
+}
+
+esp_err_t history_pack_add(history_pack_t *pack, const sensor_sample_t *sample)
+{
+    if (pack->err != ESP_OK) {
+        return pack->err;
+    }
+    pack->samples++;
+
+    if (!pack->in_block) {
+        return open_block(pack, sample);
+    }
+
+    uint32_t mask = quantize(pack, sample);
+    if (!cadence_fits(pack, sample->timestamp)) {
+        put_record(pack, 0, pack->run_last_ts);     // the run ends before this sample
+    }
+
+    if (mask) {
+        put_record(pack, mask, sample->timestamp);
+    } else {
+        pack->run_count++;
+        pack->run_last_ts = sample->timestamp;
+    }
+
+    if (++pack->block_samples >= HISTORY_PACK_BLOCK_SAMPLES) {
+        close_block(pack);
+    }
+    return pack->err;
+}
+
+esp_err_t history_pack_finish(history_pack_t *pack)
+{
+    if (pack->in_block) {
+        close_block(pack);
+    }
+    return pack->err;
+}
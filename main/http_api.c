@@ -0,0 +1,398 @@
+/**
+ * @file http_api.c
+ * @brief Read-only HTTP endpoints serving pre-serialized readings and metrics.
+ *
+ * @details
+ * Monitoring scrapes far more often than the sensor produces samples, so the
+ * response bodies are cached: each document remembers the sensor_snapshot_seq()
+ * it was built from and is only serialized again once a new sample has been
+ * published. Between samples a request costs one seqlock counter read and a
+ * socket write.
+ *
+ * esp_http_server runs every handler in its single server task, which is the
+ * only reader and writer of the caches and the history.bin staging buffers,
+ * so they need no lock. The sample data itself comes from the lock-free
+ * snapshot and the history ring, neither of which holds up the sensor task
+ * for more than one copy.
+ *
+ * history.bin is not cached: it is streamed through history_pack.c in
+ * chunks as the samples are read, so its size is bounded by the history,
+ * not by a buffer.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_APP_HTTP_SERVER
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_check.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "bme280_units.h"
+#include "fixed_format.h"
+#include "history_log.h"
+#include "history_pack.h"
+#include "http_api.h"
+#include "i2c_sched.h"
+#include "perf_stats.h"
+#include "sensor_history.h"
+#include "sensor_snapshot.h"
+#include "telemetry.h"
+
+static const char *TAG_HTTP = "HTTP_API";
+
+#define HTTP_JSON_MAX       2048
+#define HTTP_METRICS_MAX    4096
+#define HTTP_PACK_CHUNK     1024    /**< Bytes staged per history.bin chunk */
+#define HTTP_PACK_READ      64      /**< Samples read from the RAM ring per lock */
+
+/**
+ * @brief Bounded append-only text buffer; overflow is sticky.
+ */
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+} doc_writer_t;
+
+/**
+ * @brief One cached response body.
+ */
+typedef struct {
+    size_t len;
+    uint32_t seq;           /**< sensor_snapshot_seq() the body was built from */
+    bool valid;
+} doc_cache_t;
+
+static char s_json_buf[HTTP_JSON_MAX];
+static doc_cache_t s_json;
+static char s_metrics_buf[HTTP_METRICS_MAX];
+static doc_cache_t s_metrics;
+
+static sensor_sample_t s_recent[HTTP_API_HISTORY_SAMPLES];
+
+/**
+ * @brief history.bin sink: stages the encoder's small writes into socket-sized chunks.
+ */
+typedef struct {
+    httpd_req_t *req;
+    size_t len;
+} pack_sink_t;
+
+static uint8_t s_pack_buf[HTTP_PACK_CHUNK];
+static sensor_sample_t s_pack_samples[HTTP_PACK_READ];
+
+__attribute__((format(printf, 2, 3)))
+static void put(doc_writer_t *w, const char *fmt, ...)
+{
+    if (w->overflow) return;
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(w->buf + w->len, w->cap - w->len, fmt, args);
+    va_end(args);
+
+    if (n < 0 || (size_t)n >= w->cap - w->len) {
+        w->overflow = true;
+        return;
+    }
+    w->len += (size_t)n;
+}
+
+/** fixed_format() into @p buf, for use as a printf argument */
+static const char *fx(char *buf, size_t size, int32_t value, unsigned scale, unsigned decimals)
+{
+    fixed_format(buf, size, value, scale, decimals);
+    return buf;
+}
+
+/* ---- JSON ---------------------------------------------------------------- */
+
+static void put_json_range(doc_writer_t *w, const char *name, int32_t min, int32_t max, int32_t mean,
+                           unsigned decimals)
+{
+    char a[16], b[16], c[16];
+    put(w, "\"%s\":{\"min\":%s,\"max\":%s,\"mean\":%s}", name,
+        fx(a, sizeof(a), min, 2, decimals), fx(b, sizeof(b), max, 2, decimals), fx(c, sizeof(c), mean, 2, decimals));
+}
+
+static void build_json(doc_writer_t *w)
+{
+    char t[16], h[16], p[16];
+    sensor_snapshot_t snap;
+    bool have = sensor_snapshot_read(&snap);
+
+    put(w, "{\"seq\":%lu", (unsigned long)snap.seq);
+    if (have) {
+        put(w, ",\"captured_uptime_ms\":%lld,\"temperature_c\":%s,\"humidity_pct\":%s,\"pressure_hpa\":%s",
+            (long long)(snap.captured_us / 1000),
+            fx(t, sizeof(t), bme280_temperature_c100(&snap.data), 2, 2),
+            fx(h, sizeof(h), (int32_t)bme280_humidity_c100(&snap.data), 2, 2),
+            fx(p, sizeof(p), (int32_t)bme280_pressure_pa(&snap.data), 2, 2));
+    }
+
+    sensor_history_stats_t stats;
+    if (sensor_history_stats((uint32_t)time(NULL), HTTP_API_STATS_WINDOW_S, &stats)) {
+        put(w, ",\"window\":{\"seconds\":%d,\"count\":%lu,", HTTP_API_STATS_WINDOW_S, (unsigned long)stats.count);
+        put_json_range(w, "temperature_c", stats.temperature_min, stats.temperature_max, stats.temperature_mean, 2);
+        put(w, ",");
+        put_json_range(w, "humidity_pct", stats.humidity_min, stats.humidity_max, stats.humidity_mean, 2);
+        put(w, ",");
+        put_json_range(w, "pressure_hpa", (int32_t)stats.pressure_min, (int32_t)stats.pressure_max,
+                       (int32_t)stats.pressure_mean, 2);
+        put(w, "}");
+    }
+
+    // Raw fixed-point rows: compact, and the client does the scaling
+    size_t n = sensor_history_copy(s_recent, HTTP_API_HISTORY_SAMPLES, 0);
+    put(w, ",\"recent\":{\"fields\":[\"timestamp\",\"temperature_c100\",\"humidity_c100\",\"pressure_pa\"],"
+           "\"samples\":[");
+    for (size_t i = 0; i < n; ++i) {
+        put(w, "%s[%lu,%d,%u,%lu]", i ? "," : "", (unsigned long)s_recent[i].timestamp,
+            s_recent[i].temperature_c100, s_recent[i].humidity_c100, (unsigned long)s_recent[i].pressure_pa);
+    }
+    put(w, "]}");
+
+    i2c_sched_stats_t bus;
+    i2c_sched_get_stats(&bus);
+    put(w, ",\"i2c\":{\"transactions\":%lu,\"tx_bytes\":%lu,\"rx_bytes\":%lu,\"merged_ops\":%lu,\"errors\":%lu",
+        (unsigned long)bus.transactions, (unsigned long)bus.tx_bytes, (unsigned long)bus.rx_bytes,
+        (unsigned long)bus.merged_ops, (unsigned long)bus.errors);
+    put(w, ",\"retries\":%lu,\"bus_resets\":%lu,\"recoveries\":%lu,\"probe_failures\":%lu,\"offline_skips\":%lu}",
+        (unsigned long)bus.retries, (unsigned long)bus.bus_resets, (unsigned long)bus.recoveries,
+        (unsigned long)bus.probe_failures, (unsigned long)bus.offline_skips);
+
+#if CONFIG_APP_MQTT_TELEMETRY
+    telemetry_stats_t mqtt;
+    telemetry_get_stats(&mqtt);
+    put(w, ",\"mqtt\":{\"batches\":%lu,\"samples\":%lu,\"dropped\":%lu}",
+        (unsigned long)mqtt.batches, (unsigned long)mqtt.samples, (unsigned long)mqtt.dropped);
+#endif
+
+    put(w, "}\n");
+}
+
+/* ---- Prometheus ---------------------------------------------------------- */
+
+static void put_header(doc_writer_t *w, const char *name, const char *type, const char *help)
+{
+    put(w, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void put_counter(doc_writer_t *w, const char *name, const char *help, uint32_t value)
+{
+    put_header(w, name, "counter", help);
+    put(w, "%s %lu\n", name, (unsigned long)value);
+}
+
+static void build_metrics(doc_writer_t *w)
+{
+    char buf[16];
+    sensor_snapshot_t snap;
+    if (sensor_snapshot_read(&snap)) {
+        put_header(w, "tw_temperature_celsius", "gauge", "Latest BME280 temperature.");
+        put(w, "tw_temperature_celsius %s\n", fx(buf, sizeof(buf), bme280_temperature_c100(&snap.data), 2, 2));
+        put_header(w, "tw_humidity_percent", "gauge", "Latest BME280 relative humidity.");
+        put(w, "tw_humidity_percent %s\n", fx(buf, sizeof(buf), (int32_t)bme280_humidity_c100(&snap.data), 2, 2));
+        put_header(w, "tw_pressure_pascals", "gauge", "Latest BME280 pressure.");
+        put(w, "tw_pressure_pascals %lu\n", (unsigned long)bme280_pressure_pa(&snap.data));
+    }
+    put_counter(w, "tw_samples_total", "Samples published by the sensor task.", snap.seq);
+    put_header(w, "tw_history_samples", "gauge", "Samples held in the RAM history.");
+    put(w, "tw_history_samples %u\n", (unsigned)sensor_history_count());
+
+    i2c_sched_stats_t bus;
+    i2c_sched_get_stats(&bus);
+    put_counter(w, "tw_i2c_transactions_total", "I2C transactions on the shared bus.", bus.transactions);
+    put_counter(w, "tw_i2c_tx_bytes_total", "Bytes written on the shared bus.", bus.tx_bytes);
+    put_counter(w, "tw_i2c_rx_bytes_total", "Bytes read on the shared bus.", bus.rx_bytes);
+    put_counter(w, "tw_i2c_merged_ops_total", "Ops merged into a preceding transaction.", bus.merged_ops);
+    put_counter(w, "tw_i2c_errors_total", "Failed I2C transactions.", bus.errors);
+    put_counter(w, "tw_i2c_retries_total", "I2C transactions re-sent after a failure.", bus.retries);
+    put_counter(w, "tw_i2c_bus_resets_total", "SCL clock-out bus recoveries.", bus.bus_resets);
+    put_counter(w, "tw_i2c_recoveries_total", "Devices that answered the re-probe after a bus reset.", bus.recoveries);
+    put_counter(w, "tw_i2c_probe_failures_total", "Devices that did not answer the re-probe.", bus.probe_failures);
+    put_counter(w, "tw_i2c_offline_skips_total", "Ops failed fast because their device was offline.", bus.offline_skips);
+
+#if CONFIG_APP_MQTT_TELEMETRY
+    telemetry_stats_t mqtt;
+    telemetry_get_stats(&mqtt);
+    put_counter(w, "tw_mqtt_batches_total", "Telemetry payloads handed to the MQTT client.", mqtt.batches);
+    put_counter(w, "tw_mqtt_samples_total", "Samples sent over MQTT.", mqtt.samples);
+    put_counter(w, "tw_mqtt_dropped_total", "Samples overwritten before they could be sent.", mqtt.dropped);
+#endif
+
+#if CONFIG_APP_PERF_STATS
+    put_header(w, "tw_stage_latency_microseconds", "summary", "Pipeline stage latency (histogram bucket bounds).");
+    for (perf_stage_t stage = 0; stage < PERF_STAGE_COUNT; ++stage) {
+        perf_stage_summary_t st;
+        perf_stats_get(stage, &st);
+        const char *name = perf_stats_stage_name(stage);
+        put(w, "tw_stage_latency_microseconds{stage=\"%s\",quantile=\"0.5\"} %lu\n", name, (unsigned long)st.p50_us);
+        put(w, "tw_stage_latency_microseconds{stage=\"%s\",quantile=\"0.99\"} %lu\n", name, (unsigned long)st.p99_us);
+        put(w, "tw_stage_latency_microseconds_sum{stage=\"%s\"} %llu\n", name, (unsigned long long)st.sum_us);
+        put(w, "tw_stage_latency_microseconds_count{stage=\"%s\"} %lu\n", name, (unsigned long)st.count);
+    }
+#endif
+
+    put_header(w, "tw_uptime_seconds", "gauge", "Seconds since boot.");
+    put(w, "tw_uptime_seconds %lld\n", (long long)(esp_timer_get_time() / 1000000));
+    put_header(w, "tw_heap_free_bytes", "gauge", "Free heap.");
+    put(w, "tw_heap_free_bytes %lu\n", (unsigned long)esp_get_free_heap_size());
+}
+
+/* ---- Handlers ------------------------------------------------------------ */
+
+/**
+ * @brief Send @p cache, rebuilding it first if a sample was published since it was built.
+ */
+static esp_err_t send_cached(httpd_req_t *req, doc_cache_t *cache, char *buf, size_t cap,
+                             void (*build)(doc_writer_t *w), const char *content_type)
+{
+    uint32_t seq = sensor_snapshot_seq();
+    if (!cache->valid || cache->seq != seq) {
+        doc_writer_t w = { .buf = buf, .cap = cap };
+        build(&w);
+        if (w.overflow) {
+            ESP_LOGE(TAG_HTTP, "%s: document exceeds %u bytes", req->uri, (unsigned)cap);
+            cache->valid = false;
+            return httpd_resp_send_500(req);
+        }
+        cache->len = w.len;
+        cache->seq = seq;
+        cache->valid = true;
+    }
+
+    httpd_resp_set_type(req, content_type);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    return httpd_resp_send(req, buf, (ssize_t)cache->len);
+}
+
+static esp_err_t readings_handler(httpd_req_t *req)
+{
+    return send_cached(req, &s_json, s_json_buf, sizeof(s_json_buf), build_json, "application/json");
+}
+
+static esp_err_t metrics_handler(httpd_req_t *req)
+{
+    return send_cached(req, &s_metrics, s_metrics_buf, sizeof(s_metrics_buf), build_metrics,
+                       "text/plain; version=0.0.4");
+}
+
+/* ---- history.bin --------------------------------------------------------- */
+
+static esp_err_t pack_flush(pack_sink_t *sink)
+{
+    esp_err_t err = ESP_OK;
+    if (sink->len) {
+        err = httpd_resp_send_chunk(sink->req, (const char *)s_pack_buf, (ssize_t)sink->len);
+        sink->len = 0;
+    }
+    return err;
+}
+
+static esp_err_t pack_write(const uint8_t *data, size_t len, void *ctx)
+{
+    pack_sink_t *sink = ctx;
+    if (sink->len + len > sizeof(s_pack_buf)) {
+        ESP_RETURN_ON_ERROR(pack_flush(sink), TAG_HTTP, "send");
+    }
+    memcpy(&s_pack_buf[sink->len], data, len);
+    sink->len += len;
+    return ESP_OK;
+}
+
+static bool pack_visit(const sensor_sample_t *sample, void *ctx)
+{
+    return history_pack_add(ctx, sample) == ESP_OK;
+}
+
+/**
+ * @brief Encode the RAM ring as it stands when the request arrives.
+ *
+ * Samples published while the response is going out are left for the next request.
+ */
+static void pack_ram(history_pack_t *pack)
+{
+    uint32_t end = sensor_history_total();
+    uint32_t from = end - (uint32_t)sensor_history_count();
+    while (from != end && pack->err == ESP_OK) {
+        uint32_t left = end - from;
+        size_t n = sensor_history_read(&from, s_pack_samples, left < HTTP_PACK_READ ? left : HTTP_PACK_READ);
+        if (n == 0) break;
+        from += (uint32_t)n;
+        for (size_t i = 0; i < n; ++i) {
+            if (sensor_sample_dated(&s_pack_samples[i])) {
+                history_pack_add(pack, &s_pack_samples[i]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Stream the history in the history_pack.h format, from flash or (`?source=ram`) from RAM.
+ */
+static esp_err_t history_bin_handler(httpd_req_t *req)
+{
+    char query[32];
+    char source[8] = "";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "source", source, sizeof(source));
+    }
+    bool from_flash = history_log_capacity() > 0 && strcmp(source, "ram") != 0;
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    pack_sink_t sink = { .req = req };
+    history_pack_t pack;
+    history_pack_begin(&pack, pack_write, &sink);
+    if (from_flash) {
+        history_log_foreach(pack_visit, &pack);
+    } else {
+        pack_ram(&pack);
+    }
+
+    esp_err_t err = history_pack_finish(&pack);
+    if (err == ESP_OK) {
+        err = pack_flush(&sink);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG_HTTP, "%s: aborted after %u bytes: %s", req->uri, (unsigned)pack.bytes, esp_err_to_name(err));
+        return err;     // closes the socket, the client sees a truncated body
+    }
+    ESP_LOGD(TAG_HTTP, "%s: %lu samples in %u bytes", req->uri, (unsigned long)pack.samples, (unsigned)pack.bytes);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t http_api_start(void)
+{
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_APP_HTTP_PORT;
+    config.lru_purge_enable = true;     // many scrapers with keep-alive must not exhaust the sockets
+    config.core_id = CONFIG_APP_CORE_NET;
+    config.task_priority = CONFIG_APP_NET_TASK_PRIO;
+
+    httpd_handle_t server = NULL;
+    ESP_RETURN_ON_ERROR(httpd_start(&server, &config), TAG_HTTP, "start");
+
+    const httpd_uri_t readings = { .uri = "/api/v1/readings", .method = HTTP_GET, .handler = readings_handler };
+    const httpd_uri_t metrics = { .uri = "/metrics", .method = HTTP_GET, .handler = metrics_handler };
+    const httpd_uri_t history = { .uri = "/api/v1/history.bin", .method = HTTP_GET, .handler = history_bin_handler };
+    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(server, &readings), TAG_HTTP, "readings");
+    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(server, &metrics), TAG_HTTP, "metrics");
+    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(server, &history), TAG_HTTP, "history");
+
+    ESP_LOGI(TAG_HTTP, "Listening on port %d", CONFIG_APP_HTTP_PORT);
+    return ESP_OK;
+}
+
+#endif // CONFIG_APP_HTTP_SERVER
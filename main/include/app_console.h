@@ -0,0 +1,37 @@
+#ifndef APP_CONSOLE_H
+#define APP_CONSOLE_H
+
+#include "esp_err.h"
+
+/**
+ * @file app_console.h
+ * @brief UART console REPL and the commands every build has.
+ *
+ * @details
+ * app_console_init() creates the REPL and registers `tz` and `help`. Other
+ * modules add their commands with esp_console_cmd_register() before
+ * app_console_start() runs the REPL (perf_stats_register_commands() adds
+ * `perf` and `tasks`).
+ */
+
+/**
+ * @brief Create the UART REPL and register the `tz` and `help` commands.
+ *
+ * `tz` shows the time zone and the built-in names; `tz <zone>` sets and
+ * stores it (local_time_set_tz()).
+ *
+ * @return ESP_OK on success, or the esp_console error.
+ */
+esp_err_t app_console_init(void);
+
+/**
+ * @brief Start the REPL task created by app_console_init().
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_INVALID_STATE if app_console_init() has not succeeded
+ *   - The esp_console error otherwise
+ */
+esp_err_t app_console_start(void);
+
+#endif // APP_CONSOLE_H
@@ -0,0 +1,86 @@
+#ifndef BME280_ASYNC_H
+#define BME280_ASYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "bme280_defs.h"
+
+/**
+ * @brief Split trigger/collect state for one BME280 in forced or normal mode.
+ */
+typedef struct {
+    struct bme280_dev *dev;     /**< Initialized and configured Bosch device */
+    uint32_t meas_delay_us;     /**< Worst-case conversion time for the current oversampling */
+    bool normal;                /**< Converting continuously (bme280_async_start_normal()) */
+} bme280_async_t;
+
+/**
+ * @brief Bind a context to a configured BME280 and compute its conversion time.
+ *
+ * Reads back the oversampling chosen by configure_sensor_settings() and
+ * caches the resulting worst-case measurement time, so triggering a sample
+ * costs one register write.
+ *
+ * @param[out] ctx Context to initialize.
+ * @param[in]  dev BME280 device already set up by i2c_shared_init().
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_INVALID_ARG on NULL arguments
+ *   - ESP_FAIL if the Bosch API reports an error
+ */
+esp_err_t bme280_async_init(bme280_async_t *ctx, struct bme280_dev *dev);
+
+/**
+ * @brief Start one forced-mode conversion and return immediately.
+ *
+ * @param[in]  ctx     Context from bme280_async_init().
+ * @param[out] wait_us Time until the result is ready; the caller should sleep that long.
+ *
+ * @return ESP_OK on success, ESP_FAIL if the mode write failed.
+ */
+esp_err_t bme280_async_trigger(bme280_async_t *ctx, uint32_t *wait_us);
+
+/**
+ * @brief Switch the chip to continuous normal-mode conversions with its IIR filter.
+ *
+ * @details
+ * Picks the longest standby time t_sb for which measurement time + t_sb still
+ * fits in @p period_us, so at least one fresh, filtered conversion lands in
+ * every read period. After this, bme280_async_collect() alone returns the
+ * newest result; bme280_async_trigger() must not be used any more.
+ *
+ * The first result is ready one @ref bme280_async_t::meas_delay_us after the call.
+ *
+ * @param[in] ctx       Context from bme280_async_init().
+ * @param[in] filter    IIR coefficient, BME280_FILTER_COEFF_OFF .. BME280_FILTER_COEFF_16.
+ * @param[in] period_us Interval at which the caller reads the result.
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_INVALID_ARG if @p ctx is not initialized
+ *   - ESP_FAIL if the Bosch API reports an error
+ */
+esp_err_t bme280_async_start_normal(bme280_async_t *ctx, uint8_t filter, uint32_t period_us);
+
+/**
+ * @brief Burst-read the compensated result of a conversion started by bme280_async_trigger(),
+ *        or the newest normal-mode result.
+ *
+ * In forced mode the status register is checked first, so calling it too early
+ * is harmless. In normal mode this is one burst read.
+ *
+ * @param[in]  ctx Context from bme280_async_init().
+ * @param[out] out Compensated temperature / pressure / humidity.
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_NOT_FINISHED if the forced conversion is still running (retry later)
+ *   - ESP_FAIL on a bus or Bosch API error
+ */
+esp_err_t bme280_async_collect(bme280_async_t *ctx, struct bme280_data *out);
+
+#endif // BME280_ASYNC_H
@@ -0,0 +1,57 @@
+#ifndef BME280_SENSOR_H
+#define BME280_SENSOR_H
+
+#include <stdint.h>
+
+#include "bme280_defs.h"
+
+#include "bme280_async.h"
+#include "sensor_registry.h"
+
+#define BME280_SENSOR_BURST_LEN     12      /**< status (0xF3) through hum_lsb (0xFE) */
+
+/**
+ * @brief One BME280 as a sensor_registry.h sensor.
+ *
+ * Bind it to a configured Bosch device with bme280_sensor_bind(), then pass
+ * it to sensor_registry_add() with @ref bme280_sensor_driver. After each
+ * sample round in which its bit is set, @ref data holds the new result.
+ */
+typedef struct {
+    bme280_async_t async;                       /**< Bosch device, conversion time and mode */
+    uint8_t trigger_cmd[2];                     /**< ctrl_meas register + value that starts a forced conversion */
+    uint8_t read_reg;                           /**< First register of the result burst */
+    uint8_t raw[BME280_SENSOR_BURST_LEN];       /**< Bytes of the last result burst */
+    struct bme280_data data;                    /**< Latest compensated result */
+} bme280_sensor_t;
+
+/**
+ * @brief Registry driver for bme280_sensor_t.
+ *
+ * @details
+ * - init: bme280_async_init(); with CONFIG_APP_BME280_NORMAL also
+ *   bme280_async_start_normal() with the configured IIR coefficient
+ * - trigger: one ctrl_meas write (none in normal mode)
+ * - collect: one burst read, status register included in forced mode, then
+ *   bme280_compensate_data() on the raw bytes
+ * - recover: i2c_reconfigure_bme280(), then init again
+ */
+extern const sensor_driver_t bme280_sensor_driver;
+
+/**
+ * @brief I2C device handle of a bound sensor, for sensor_registry_add().
+ */
+static inline i2c_master_dev_handle_t bme280_sensor_device(const bme280_sensor_t *sensor)
+{
+    return (i2c_master_dev_handle_t)sensor->async.dev->intf_ptr;
+}
+
+/**
+ * @brief Point @p sensor at a Bosch device set up by i2c_shared_init() or i2c_add_bme280().
+ */
+static inline void bme280_sensor_bind(bme280_sensor_t *sensor, struct bme280_dev *dev)
+{
+    *sensor = (bme280_sensor_t){ .async.dev = dev };
+}
+
+#endif // BME280_SENSOR_H
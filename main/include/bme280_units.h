@@ -0,0 +1,70 @@
+#ifndef BME280_UNITS_H
+#define BME280_UNITS_H
+
+#include <stdint.h>
+
+#include "bme280_defs.h"
+
+/**
+ * @file bme280_units.h
+ * @brief Fixed-point accessors for struct bme280_data, whatever compensation the driver was built with.
+ *
+ * @details
+ * The Bosch driver changes the meaning of struct bme280_data with its build flags
+ * (set from CONFIG_APP_BME280_COMPENSATION in main/CMakeLists.txt):
+ *
+ * | Flag                   | temperature  | pressure | humidity      |
+ * |------------------------|--------------|----------|---------------|
+ * | BME280_DOUBLE_ENABLE   | double °C    | double Pa| double %RH    |
+ * | BME280_64BIT_ENABLE    | int32 0.01 °C| 0.01 Pa  | %RH x 1024    |
+ * | BME280_32BIT_ENABLE    | int32 0.01 °C| Pa       | %RH x 1024    |
+ *
+ * Everything past the driver uses these accessors, so only this header knows.
+ */
+
+#ifdef BME280_DOUBLE_ENABLE
+
+static inline int32_t bme280_round(double v)
+{
+    return (int32_t)((v < 0) ? v - 0.5 : v + 0.5);
+}
+
+static inline int32_t bme280_temperature_c100(const struct bme280_data *d)
+{
+    return bme280_round(d->temperature * 100.0);
+}
+
+static inline uint32_t bme280_pressure_pa(const struct bme280_data *d)
+{
+    return (d->pressure > 0) ? (uint32_t)bme280_round(d->pressure) : 0;
+}
+
+static inline uint32_t bme280_humidity_c100(const struct bme280_data *d)
+{
+    return (d->humidity > 0) ? (uint32_t)bme280_round(d->humidity * 100.0) : 0;
+}
+
+#else
+
+static inline int32_t bme280_temperature_c100(const struct bme280_data *d)
+{
+    return d->temperature;
+}
+
+static inline uint32_t bme280_pressure_pa(const struct bme280_data *d)
+{
+#ifdef BME280_64BIT_ENABLE
+    return (d->pressure + 50) / 100;
+#else
+    return d->pressure;
+#endif
+}
+
+static inline uint32_t bme280_humidity_c100(const struct bme280_data *d)
+{
+    return (d->humidity * 100 + 512) / 1024;
+}
+
+#endif // BME280_DOUBLE_ENABLE
+
+#endif // BME280_UNITS_H
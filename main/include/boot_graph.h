@@ -0,0 +1,69 @@
+#ifndef BOOT_GRAPH_H
+#define BOOT_GRAPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define BOOT_GRAPH_MAX_STAGES   16      /**< One event group bit per stage */
+
+/**
+ * @brief One init step of the boot sequence.
+ *
+ * A stage starts as soon as every stage in @ref deps has finished, in its own
+ * short-lived task, so stages without a dependency between them run at the
+ * same time (on both cores).
+ */
+typedef struct {
+    const char *name;           /**< Label in the boot timeline */
+    esp_err_t (*run)(void);     /**< Init step; NULL = not in this build, done at once */
+    uint32_t deps;              /**< Bit i: stage i of the table must finish first; only earlier stages */
+} boot_stage_t;
+
+/**
+ * @brief Points after boot that the timeline reports.
+ */
+typedef enum {
+    BOOT_MILESTONE_FIRST_SAMPLE,    /**< First sensor sample published */
+    BOOT_MILESTONE_FIRST_FRAME,     /**< First rendered frame on the panel */
+    BOOT_MILESTONE_COUNT,
+} boot_milestone_t;
+
+/**
+ * @brief Run the stages of @p stages in dependency order, independent ones concurrently.
+ *
+ * @details
+ * Blocks the caller until every stage has finished, then logs the timeline:
+ * start and end of each stage in ms since boot (esp_timer_get_time()). A
+ * stage whose dependency failed is skipped.
+ *
+ * @param[in] stages Stage table; must stay valid until this returns.
+ * @param[in] count  Entries in @p stages, at most @ref BOOT_GRAPH_MAX_STAGES.
+ *
+ * @return
+ *   - ESP_OK if every stage succeeded
+ *   - ESP_ERR_INVALID_ARG for a bad table (too long, a dependency on a later stage)
+ *   - ESP_ERR_NO_MEM if a stage task could not be created
+ *   - Otherwise the error of the first failed stage in table order
+ */
+esp_err_t boot_graph_run(const boot_stage_t *stages, size_t count);
+
+/**
+ * @brief Record @p milestone now, if it was not reached yet, and log it.
+ *
+ * @note Safe from any task; only the first call per milestone has an effect.
+ */
+void boot_graph_mark(boot_milestone_t milestone);
+
+/**
+ * @brief Time of @p milestone in us since boot, or 0 if not reached yet.
+ */
+int64_t boot_graph_milestone_us(boot_milestone_t milestone);
+
+/**
+ * @brief Time in us since boot at which boot_graph_run() finished, or 0.
+ */
+int64_t boot_graph_done_us(void);
+
+#endif // BOOT_GRAPH_H
@@ -0,0 +1,239 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdint.h>
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+
+#include "common_i2c_init.h"
+#include "display_font.h"
+
+#define DISPLAY_WIDTH   SSD1306_PANEL_WIDTH
+#define DISPLAY_HEIGHT  SSD1306_PANEL_HEIGHT
+#define DISPLAY_PAGES   (DISPLAY_HEIGHT / PIXELS_PER_PAGE)
+
+#define DISPLAY_FIELD_MAX_CHARS     (DISPLAY_WIDTH / DISPLAY_FONT_CELL_WIDTH)   /**< Longest value a display_field_t can hold */
+
+/**
+ * @brief Placement of a value inside its fixed-width slot.
+ */
+typedef enum {
+    DISPLAY_ALIGN_LEFT,
+    DISPLAY_ALIGN_RIGHT,
+    DISPLAY_ALIGN_CENTER,
+} display_align_t;
+
+/**
+ * @brief Where and how one text field is drawn, fully resolved at compile time.
+ *
+ * Build entries with DISPLAY_FIELD_LAYOUT(), so the centering is done by the
+ * compiler and display_field_init() only copies and draws. An entry with
+ * @ref value_chars 0 is a field the panel has no room for: it draws nothing.
+ */
+typedef struct {
+    uint16_t x;                                 /**< Left edge of the prefix */
+    uint16_t y;                                 /**< Top edge in pixels */
+    uint8_t prefix_chars;                       /**< strlen(prefix) */
+    uint8_t value_chars;                        /**< Width of the value slot in characters */
+    display_align_t align;                      /**< Value alignment inside the slot */
+    const char *prefix;                         /**< Static text before the value */
+    const char *suffix;                         /**< Static text after the value */
+} display_field_layout_t;
+
+/** Left edge that centers @p chars font cells on the panel */
+#define DISPLAY_CENTER_X(chars) \
+    (((chars) * DISPLAY_FONT_CELL_WIDTH < DISPLAY_WIDTH) ? (DISPLAY_WIDTH - (chars) * DISPLAY_FONT_CELL_WIDTH) / 2 : 0)
+
+/**
+ * @brief Constant initializer for a display_field_layout_t centered on the panel.
+ *
+ * The whole field (prefix + value slot + suffix) is centered, so the prefix
+ * and suffix never move when the value changes length. @p prefix and
+ * @p suffix must be string literals.
+ */
+#define DISPLAY_FIELD_LAYOUT(y_, prefix_, chars_, align_, suffix_) {                            \
+    .x = DISPLAY_CENTER_X(sizeof(prefix_) - 1 + (chars_) + sizeof(suffix_) - 1),                \
+    .y = (y_),                                                                                  \
+    .prefix_chars = sizeof(prefix_) - 1,                                                        \
+    .value_chars = (chars_),                                                                    \
+    .align = (align_),                                                                          \
+    .prefix = (prefix_),                                                                        \
+    .suffix = (suffix_),                                                                        \
+}
+
+/** Layout entry for a field the panel has no room for */
+#define DISPLAY_FIELD_ABSENT        DISPLAY_FIELD_LAYOUT(0, "", 0, DISPLAY_ALIGN_LEFT, "")
+
+/**
+ * @brief A fixed-position text field: static prefix, fixed-width value, static suffix.
+ *
+ * The field remembers which characters are on screen, so updating it only
+ * touches the cells whose character changed.
+ */
+typedef struct {
+    uint16_t y;                                 /**< Top edge in pixels */
+    uint16_t value_x;                           /**< Left edge of the value slot */
+    uint8_t value_chars;                        /**< Width of the value slot in characters */
+    display_align_t align;                      /**< Value alignment inside the slot */
+    char shown[DISPLAY_FIELD_MAX_CHARS];        /**< Characters currently drawn in the slot */
+} display_field_t;
+
+/**
+ * @brief Take over the SSD1306 GDDRAM with a dirty-tracked framebuffer.
+ *
+ * @details
+ * Switches the panel to horizontal addressing mode, clears the local
+ * framebuffer and marks every page dirty, so the first display_flush()
+ * overwrites whatever the driver left on screen. On a 128x32 panel the
+ * GDDRAM pages below the panel are cleared once, for display_set_row_shift().
+ *
+ * @param[in] dev I2C device handle of the SSD1306 (see i2c_get_ssd1306()).
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_INVALID_ARG if @p dev is NULL
+ *   - Error code from the I2C driver otherwise
+ *
+ * @note Call once, after i2c_shared_init() has initialized the panel.
+ */
+esp_err_t display_init(i2c_master_dev_handle_t dev);
+
+/**
+ * @brief Clear the whole framebuffer.
+ *
+ * Only pixels that were lit become dirty.
+ */
+void display_clear(void);
+
+/**
+ * @brief Draw a string with opaque 8x8 cells at an arbitrary pixel position.
+ *
+ * @param[in] x   Left edge in pixels.
+ * @param[in] y   Top edge in pixels; need not be page aligned.
+ * @param[in] str NUL-terminated ASCII string. Unknown characters render as '?'.
+ *
+ * @note Pixels outside the panel are clipped.
+ */
+void display_draw_string(uint16_t x, uint16_t y, const char *str);
+
+/**
+ * @brief Draw one pixel column of up to 32 px, e.g. a graph sample.
+ *
+ * Bit 0 of @p bits is the pixel at @p y. The column is opaque: pixels in
+ * [y, y + height) that are not set in @p bits are cleared, pixels outside it
+ * are left alone. Only the bytes that change become dirty, so redrawing one
+ * column costs at most one byte per page it touches.
+ *
+ * @param[in] x      Column in pixels.
+ * @param[in] y      Top edge in pixels; need not be page aligned.
+ * @param[in] height Column height in pixels (1..32).
+ * @param[in] bits   Pixel values, top first.
+ */
+void display_draw_column(uint16_t x, uint16_t y, uint8_t height, uint32_t bits);
+
+/**
+ * @brief Redraw a full-width 8 px band with a horizontally centered string.
+ *
+ * Everything in the band outside the string is cleared, so a shorter
+ * string never leaves stale glyphs next to it.
+ *
+ * @param[in] y   Top edge of the band in pixels.
+ * @param[in] str NUL-terminated ASCII string.
+ */
+void display_draw_line_centered(uint16_t y, const char *str);
+
+/**
+ * @brief Place a field as @p layout says and draw its static parts.
+ *
+ * @param[out] field  Field to initialize.
+ * @param[in]  layout Entry from DISPLAY_FIELD_LAYOUT(); value_chars is capped
+ *                    at @ref DISPLAY_FIELD_MAX_CHARS.
+ *
+ * @note Call after display_init(); the value slot is drawn on the first display_field_set().
+ */
+void display_field_init(display_field_t *field, const display_field_layout_t *layout);
+
+/**
+ * @brief Show @p value in the field, redrawing only the characters that changed.
+ *
+ * @param[in,out] field Field from display_field_init().
+ * @param[in]     value New value; truncated to the slot width, padded with spaces.
+ */
+void display_field_set(display_field_t *field, const char *value);
+
+/**
+ * @brief Send only the changed page/column windows to the panel.
+ *
+ * @details
+ * Each page keeps the first and last column that changed since the last
+ * flush. Vertically adjacent dirty pages are merged into one window when
+ * that costs fewer bytes on the bus than addressing them separately.
+ * Returns immediately when nothing changed.
+ *
+ * Blocks until the batch has gone out.
+ *
+ * @return
+ *   - ESP_OK on success (including "nothing to send")
+ *   - ESP_ERR_INVALID_STATE while a display_flush_async() batch is in flight
+ *   - Error code from the I2C driver otherwise, also for a failed earlier
+ *     async flush; the whole frame is then dirty again
+ */
+esp_err_t display_flush(void);
+
+/**
+ * @brief Queue the changed windows on the bus scheduler and return without waiting.
+ *
+ * @details
+ * Builds the same windows as display_flush() and hands them to
+ * i2c_sched_submit_async(). The bytes are copied out of the framebuffer first,
+ * so drawing can continue at once while the previous frame is still on the bus.
+ * When the batch completes, @p notify_bits are set in the calling task's
+ * notification value; call this again then, and any drawing done in between
+ * goes out as the next batch.
+ *
+ * While a batch is still in flight this returns ESP_OK without sending
+ * anything: the new changes stay dirty until the next call.
+ *
+ * @param[in] notify_bits Completion bits for the calling task, non-zero.
+ *
+ * @return
+ *   - ESP_OK if a batch was queued, nothing changed, or a batch is still in flight
+ *   - Error code of the previous batch if it failed; the whole frame is dirty
+ *     again and goes out on the next call
+ */
+esp_err_t display_flush_async(uint32_t notify_bits);
+
+/**
+ * @brief Set the panel contrast (SSD1306 command 0x81), e.g. to dim it at night.
+ *
+ * One 3-byte command; the framebuffer is untouched. Repeating the current
+ * level sends nothing. The level is restored after a bus recovery.
+ *
+ * @param[in] level 0 (dimmest, not off) to 255.
+ *
+ * @return ESP_OK, or the I2C error (the level is then sent again on the next call).
+ */
+esp_err_t display_set_contrast(uint8_t level);
+
+/**
+ * @brief Move the whole image down by @p rows with the display start line register.
+ *
+ * @details
+ * The controller shifts the image itself: one 2-byte command instead of a
+ * full-frame push, and the framebuffer, dirty spans and field positions stay
+ * as they are. The bottom @p rows rows leave the panel and the top rows show
+ * the end of GDDRAM: on a 128x64 panel that is the bottom of the frame, on a
+ * 128x32 panel the hidden pages, which display_init() clears. Keep @p rows to
+ * the blank margin of the layout. Repeating the current shift sends nothing.
+ *
+ * @param[in] rows 0 (no shift) to 63.
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_INVALID_ARG if @p rows is out of range
+ *   - The I2C error otherwise
+ */
+esp_err_t display_set_row_shift(uint8_t rows);
+
+#endif // DISPLAY_H
@@ -0,0 +1,21 @@
+#ifndef DISPLAY_FONT_H
+#define DISPLAY_FONT_H
+
+#include <stdint.h>
+
+#define DISPLAY_FONT_FIRST_CHAR     0x20    /**< First glyph in the table (' ') */
+#define DISPLAY_FONT_LAST_CHAR      0x7E    /**< Last glyph in the table ('~') */
+#define DISPLAY_FONT_GLYPH_COLUMNS  5       /**< Inked columns per glyph */
+#define DISPLAY_FONT_CELL_WIDTH     8       /**< Horizontal advance, matches FONT_8x8 */
+
+/**
+ * @brief 5x7 ASCII glyphs in SSD1306 page format.
+ *
+ * @details
+ * One byte per column, LSB = top pixel, so a glyph can be copied straight
+ * into a framebuffer page. Glyphs are drawn inside an 8 px cell (1 px left
+ * padding, 2 px right padding) so layout math written for FONT_8x8 still holds.
+ */
+extern const uint8_t display_font_5x7[DISPLAY_FONT_LAST_CHAR - DISPLAY_FONT_FIRST_CHAR + 1][DISPLAY_FONT_GLYPH_COLUMNS];
+
+#endif // DISPLAY_FONT_H
@@ -0,0 +1,55 @@
+#ifndef FIXED_FORMAT_H
+#define FIXED_FORMAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Displayed value of one reading, held by fixed_quantize().
+ */
+typedef struct {
+    int32_t shown;      /**< Last value put on screen, a multiple of the step */
+    bool valid;         /**< @ref shown is set; clear it to force the next update */
+} fixed_hold_t;
+
+/**
+ * @brief Format a fixed-point value as a decimal string, without printf.
+ *
+ * @p value carries @p scale decimal digits (e.g. 2 for 0.01 units). The result
+ * shows @p decimals of them (at most @p scale), rounded half away from zero:
+ * fixed_format(buf, sizeof(buf), -1234, 2, 1) gives "-12.3".
+ *
+ * @param[out] out      Destination, NUL-terminated on success.
+ * @param[in]  size     Size of @p out.
+ * @param[in]  value    Fixed-point value.
+ * @param[in]  scale    Decimal digits stored in @p value (0..9).
+ * @param[in]  decimals Decimal digits to show (0..scale).
+ *
+ * @return Length written (excluding NUL), or 0 if @p out is too small or the
+ *         arguments are out of range (then @p out is "" if size > 0).
+ */
+size_t fixed_format(char *out, size_t size, int32_t value, unsigned scale, unsigned decimals);
+
+/**
+ * @brief Quantize @p value to the displayed step, with hysteresis.
+ *
+ * @details
+ * The held value moves only when @p value is more than half a step plus
+ * @p hysteresis away from it, i.e. when the rounded digits would change and
+ * the reading has left the band around the rounding boundary. It then takes
+ * the nearest multiple of @p step (half away from zero, as fixed_format()).
+ *
+ * A renderer that only formats and draws when this returns true skips the
+ * work, and the bus traffic, for changes below the displayed precision.
+ *
+ * @param[in,out] hold       Held value; the first call (valid = false) always updates.
+ * @param[in]     value      New reading, in the same units as @p step.
+ * @param[in]     step       Smallest displayed change, e.g. 10 for 0.1 °C in 0.01 °C units; > 0.
+ * @param[in]     hysteresis Extra distance past the half step before the value moves; >= 0.
+ *
+ * @return true if hold->shown changed.
+ */
+bool fixed_quantize(fixed_hold_t *hold, int32_t value, int32_t step, int32_t hysteresis);
+
+#endif // FIXED_FORMAT_H
@@ -0,0 +1,62 @@
+#ifndef GRAPH_SCREEN_H
+#define GRAPH_SCREEN_H
+
+#include "sdkconfig.h"
+
+#include "display.h"
+
+#if CONFIG_APP_PANEL_SHIFT
+#define GRAPH_SHIFT_RESERVE     CONFIG_APP_PANEL_SHIFT_ROWS /**< Bottom rows kept blank: panel_care.h shifts them off the panel */
+#else
+#define GRAPH_SHIFT_RESERVE     0
+#endif
+
+/** Top-to-top distance of the three strips: 21 px on 64 rows with a 2-row shift, 11 on 32 with 1 row */
+#define GRAPH_STRIP_PITCH       ((DISPLAY_HEIGHT - GRAPH_SHIFT_RESERVE + 2) / 3)
+#define GRAPH_STRIP_HEIGHT      (GRAPH_STRIP_PITCH - 2)     /**< Pixel rows per sparkline (2 px gap) */
+
+#if CONFIG_APP_GRAPH_SCREEN
+
+/**
+ * @brief Rebuild the sparklines from the sample history and draw the whole screen.
+ *
+ * @details
+ * Temperature, humidity and pressure get one strip each, top to bottom
+ * (@ref GRAPH_STRIP_HEIGHT: 19 px on a 64-row panel, 9 px on 32 rows, with
+ * the default shift). The strips leave @ref GRAPH_SHIFT_RESERVE rows blank at
+ * the bottom, so no sparkline wraps to the top of the panel while
+ * panel_care_update() moves the image down.
+ * Every column is the mean of CONFIG_APP_GRAPH_SAMPLES_PER_COLUMN consecutive
+ * samples (sensor_history_mean()); the newest columns that the RAM history
+ * still holds are laid out from the left edge. Each strip is scaled to the
+ * range of its columns.
+ *
+ * @note Draws into the framebuffer only; the caller flushes. The caller is
+ *       expected to have cleared the screen (display_clear()).
+ */
+void graph_screen_draw(void);
+
+/**
+ * @brief Add the columns completed since the last call, as a sweep.
+ *
+ * @details
+ * The panel has no one-column hardware shift, and shifting the framebuffer
+ * would dirty every byte of the graph. Instead the write position sweeps from
+ * left to right and wraps, like an oscilloscope: a new column is drawn at the
+ * cursor and the column after it is blanked as a gap marking "now". One update
+ * dirties three columns per strip, a few bytes on the bus.
+ *
+ * A value outside the current scale rescales that strip and redraws it.
+ *
+ * @note Only call while the graph screen is shown, after graph_screen_draw().
+ */
+void graph_screen_update(void);
+
+#else
+
+static inline void graph_screen_draw(void) {}
+static inline void graph_screen_update(void) {}
+
+#endif // CONFIG_APP_GRAPH_SCREEN
+
+#endif // GRAPH_SCREEN_H
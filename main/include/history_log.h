@@ -0,0 +1,53 @@
+#ifndef HISTORY_LOG_H
+#define HISTORY_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "sensor_history.h"
+
+#define HISTORY_LOG_PARTITION_LABEL     "history"
+#define HISTORY_LOG_PARTITION_SUBTYPE   0x40        /**< Custom data subtype, see partitions.csv */
+#define HISTORY_LOG_MAGIC               0x31545348  /**< "HST1" */
+#define HISTORY_LOG_RECORD_SIZE         16          /**< sensor_sample_t + CRC32 */
+
+/**
+ * @brief Called for each stored sample by history_log_foreach(); return false to stop.
+ */
+typedef bool (*history_log_visit_t)(const sensor_sample_t *sample, void *ctx);
+
+/**
+ * @brief Open the history partition and find the write position.
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_NOT_FOUND if the partition table has no history partition
+ *   - Flash error otherwise
+ */
+esp_err_t history_log_init(void);
+
+/**
+ * @brief Append one sample; erases the oldest sector when the current one is full.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if not initialized, or the flash error.
+ */
+esp_err_t history_log_append(const sensor_sample_t *sample);
+
+/**
+ * @brief Visit every stored sample, oldest first.
+ *
+ * Records that fail their CRC (e.g. torn by a power cut) are skipped.
+ *
+ * @return Number of samples visited.
+ */
+size_t history_log_foreach(history_log_visit_t visit, void *ctx);
+
+/**
+ * @brief How many samples the partition holds before the oldest are dropped.
+ */
+size_t history_log_capacity(void);
+
+#endif // HISTORY_LOG_H
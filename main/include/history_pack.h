@@ -0,0 +1,115 @@
+#ifndef HISTORY_PACK_H
+#define HISTORY_PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#include "fixed_format.h"
+#include "sensor_history.h"
+
+/**
+ * @file history_pack.h
+ * @brief Compact export stream for sensor_sample_t series: quantized, delta and run-length coded.
+ *
+ * @details
+ * The stream is a sequence of self-contained blocks; a damaged block costs
+ * only its own samples. All multi-byte integers are LEB128 varints, signed
+ * ones zigzag-mapped first ((v << 1) ^ (v >> 31)).
+ *
+ * | Field        | Coding        | Meaning |
+ * |--------------|---------------|---------|
+ * | magic        | 2 bytes       | "hp" |
+ * | version      | 1 byte        | @ref HISTORY_PACK_VERSION |
+ * | steps        | 3 varints     | temperature (0.01 °C), humidity (0.01 %RH), pressure (Pa) per unit |
+ * | keyframe     | varint        | timestamp (epoch s) |
+ * |              | zigzag varint, 2 varints | temperature, humidity, pressure in steps |
+ * | records      | see below     | |
+ * | end          | varint 0      | |
+ * | crc          | 4 bytes LE    | CRC-32 (zlib) of magic through end |
+ *
+ * Record: tag = (count << 3) | mask, then zigzag dt, then one zigzag delta
+ * (in steps) per mask bit (bit 0 temperature, 1 humidity, 2 pressure).
+ * It covers n = count + (mask ? 1 : 0) samples: count samples equal to the
+ * previous one, then, if mask != 0, the sample with the deltas applied. dt
+ * is the time from the previous record's last sample to this record's last
+ * one; sample k of n is at t_prev + floor((2 k dt + n) / (2 n)).
+ *
+ * Values are quantized with fixed_quantize() at the block's steps and half a
+ * step of hysteresis, so a stored value is within one step of the sample and
+ * sensor noise does not break runs. Run timestamps are interpolated; the
+ * encoder ends a run when a sample's interval is more than
+ * @ref HISTORY_PACK_JITTER_S away from the run's mean, so stored times are
+ * as accurate as the sampling jitter. On a steady indoor series most
+ * samples fold into runs: host_sim packs a week at 2.5 s into about 16 KB.
+ *
+ * tools/history_decode.py turns a stream back into CSV or JSON.
+ */
+
+#define HISTORY_PACK_VERSION        1
+#define HISTORY_PACK_JITTER_S       1       /**< Largest interval deviation a run absorbs */
+#define HISTORY_PACK_RECORD_MAX     25      /**< Longest record: tag, dt and three deltas, 5 bytes each at most */
+#define HISTORY_PACK_BLOCK_SAMPLES  CONFIG_APP_HISTORY_PACK_BLOCK_SAMPLES
+
+/**
+ * @brief Sink for encoded bytes: a socket, a UART, a file.
+ *
+ * Called once per header, record and trailer, with at most a few dozen bytes.
+ *
+ * @return ESP_OK, or an error that stops the stream (history_pack_add() and
+ *         history_pack_finish() return it from then on).
+ */
+typedef esp_err_t (*history_pack_write_t)(const uint8_t *data, size_t len, void *ctx);
+
+/**
+ * @brief Encoder state; the stream goes straight to the sink, nothing is buffered beyond one record.
+ *
+ * Fill it with history_pack_begin(); the other fields belong to the encoder.
+ */
+typedef struct {
+    history_pack_write_t write;
+    void *ctx;
+    esp_err_t err;                  /**< First sink error, sticky */
+
+    int32_t step_t, step_h, step_p; /**< Quantization steps of the current stream */
+    fixed_hold_t temperature;       /**< Quantized values, raw units */
+    fixed_hold_t humidity;
+    fixed_hold_t pressure;
+    int32_t base_t, base_h, base_p; /**< Last values the decoder knows, in steps */
+
+    bool in_block;
+    uint32_t block_samples;         /**< Samples covered by the open block, keyframe included */
+    uint32_t crc;                   /**< CRC-32 of the open block so far */
+    uint32_t base_ts;               /**< Timestamp of the last sample the decoder knows */
+    uint32_t run_count;             /**< Unchanged samples not yet written */
+    uint32_t run_last_ts;           /**< Timestamp of the newest of them */
+
+    uint32_t samples;               /**< Samples added */
+    size_t bytes;                   /**< Bytes written */
+} history_pack_t;
+
+/**
+ * @brief Start a stream with the configured steps (CONFIG_APP_HISTORY_PACK_*).
+ */
+void history_pack_begin(history_pack_t *pack, history_pack_write_t write, void *ctx);
+
+/**
+ * @brief Add one sample; timestamps should not go backwards, but a stream stays valid if they do.
+ *
+ * A block is closed after @ref HISTORY_PACK_BLOCK_SAMPLES samples and the next sample opens a new one.
+ *
+ * @return ESP_OK, or the sink's error.
+ */
+esp_err_t history_pack_add(history_pack_t *pack, const sensor_sample_t *sample);
+
+/**
+ * @brief Write the pending run and close the open block.
+ *
+ * @return ESP_OK, or the first sink error of the stream.
+ */
+esp_err_t history_pack_finish(history_pack_t *pack);
+
+#endif // HISTORY_PACK_H
@@ -0,0 +1,45 @@
+#ifndef HTTP_API_H
+#define HTTP_API_H
+
+#include "esp_err.h"
+
+#include "sdkconfig.h"
+
+#define HTTP_API_HISTORY_SAMPLES    24      /**< Newest samples listed in the JSON document */
+#define HTTP_API_STATS_WINDOW_S     3600    /**< Window of the min/max/mean block */
+
+#if CONFIG_APP_HTTP_SERVER
+
+/**
+ * @brief Start esp_http_server on CONFIG_APP_HTTP_PORT with the read-only endpoints.
+ *
+ * @details
+ * - `GET /metrics`: Prometheus text exposition (readings, sample count,
+ *   I2C and MQTT counters, stage latency summaries, uptime, free heap)
+ * - `GET /api/v1/readings`: JSON with the latest sample, min/max/mean over
+ *   the last @ref HTTP_API_STATS_WINDOW_S seconds, the newest
+ *   @ref HTTP_API_HISTORY_SAMPLES samples and the same counters
+ * - `GET /api/v1/history.bin`: the stored history as a history_pack.h
+ *   stream, chunked; from the flash log when it is mounted, from the RAM
+ *   ring with `?source=ram` or without the partition. A flash append during
+ *   the transfer can repeat or reorder a sample at the log's ends; the
+ *   stream stays decodable (tools/history_decode.py)
+ *
+ * Each document is serialized once per published sample, not per request:
+ * the first request after sensor_snapshot_publish() rebuilds it, every later
+ * one sends the cached bytes. The counters are therefore as of that rebuild.
+ * history.bin is encoded per request.
+ *
+ * @return ESP_OK on success, or the httpd_start() / handler registration error.
+ *
+ * @note Call after the network stack is up (wifi_init_sta() or wifi_start_async()).
+ */
+esp_err_t http_api_start(void);
+
+#else
+
+static inline esp_err_t http_api_start(void) { return ESP_OK; }
+
+#endif // CONFIG_APP_HTTP_SERVER
+
+#endif // HTTP_API_H
@@ -0,0 +1,101 @@
+#ifndef LOCAL_TIME_H
+#define LOCAL_TIME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "esp_err.h"
+
+/**
+ * @file local_time.h
+ * @brief Runtime time zone (persisted in NVS) and a cached epoch → local time conversion.
+ *
+ * @details
+ * localtime_r() evaluates the POSIX TZ rules on every call. Within one local
+ * day and one UTC offset, local time is just the epoch plus a constant, so
+ * local_time_get() keeps the broken-down date and the epoch of local
+ * midnight, and fills in hour, minute and second with integer division.
+ * It runs localtime_r() only when the day rolls over, when the next offset
+ * change (DST transition) is reached, or after a time zone change.
+ *
+ * The next transition is found once per offset period by probing
+ * localtime_r() a week at a time and bisecting the week it falls in, about
+ * 75 calls twice a year. POSIX TZ rules have at most two transitions per
+ * year, so no period is shorter than a week.
+ */
+
+#define LOCAL_TIME_TZ_MAX       64      /**< Longest POSIX TZ string, terminator included */
+
+/**
+ * @brief Conversion cache, one per caller; not shared between tasks.
+ *
+ * Zero-initialize it. local_time_get() owns the fields.
+ */
+typedef struct {
+    struct tm tm;               /**< Local time of the last local_time_get() */
+    time_t day_start;           /**< Epoch of local 00:00:00 of tm's day, at the current offset */
+    time_t valid_from;          /**< day_start, or searched_from if later: the offset is known from here */
+    time_t valid_until;         /**< Next local midnight or next transition, whichever comes first */
+    time_t searched_from;       /**< Epoch the transition search started at */
+    time_t next_transition;     /**< First offset change after searched_from (or the search horizon) */
+    int32_t utc_offset_s;       /**< Local minus UTC, seconds */
+    uint32_t tz_gen;            /**< Time zone generation the cache was built for */
+    bool valid;
+} local_time_cache_t;
+
+/**
+ * @brief Counters of the cache's slow paths.
+ */
+typedef struct {
+    uint32_t conversions;       /**< localtime_r() calls by local_time_get() (rollovers, transitions, tz changes) */
+    uint32_t searches;          /**< Transition searches */
+    uint32_t tz_changes;        /**< Successful local_time_set_tz() calls */
+} local_time_stats_t;
+
+/**
+ * @brief Apply the stored time zone, or CONFIG_APP_TIMEZONE if NVS holds none.
+ *
+ * Only the first call reads NVS; later calls return at once.
+ *
+ * @note NVS must be initialized (wifi_nvs_init()).
+ */
+void local_time_init(void);
+
+/**
+ * @brief Switch to @p tz, store it in NVS and invalidate every cache.
+ *
+ * @param[in] tz A POSIX TZ string ("EET-2EEST,M3.5.0/3,M10.5.0/4") or one of
+ *               the names listed by local_time_zone_name() ("Europe/Bucharest").
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_INVALID_ARG if @p tz is empty, too long or not a TZ string
+ *   - NVS error if it could not be stored (it is applied all the same)
+ */
+esp_err_t local_time_set_tz(const char *tz);
+
+/**
+ * @brief Copy the POSIX TZ string in effect into @p buf.
+ */
+void local_time_get_tz(char *buf, size_t size);
+
+/**
+ * @brief Name of built-in zone @p index, or NULL past the last one.
+ */
+const char *local_time_zone_name(size_t index);
+
+/**
+ * @brief Local time for @p now, through @p cache.
+ *
+ * @return Pointer to cache->tm, valid until the next call with this cache.
+ */
+const struct tm *local_time_get(local_time_cache_t *cache, time_t now);
+
+/**
+ * @brief Snapshot of the slow-path counters.
+ */
+void local_time_get_stats(local_time_stats_t *out);
+
+#endif // LOCAL_TIME_H
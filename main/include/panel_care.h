@@ -0,0 +1,42 @@
+#ifndef PANEL_CARE_H
+#define PANEL_CARE_H
+
+#include <time.h>
+
+#include "sdkconfig.h"
+
+#define PANEL_CARE_ENABLED  (CONFIG_APP_PANEL_SHIFT || CONFIG_APP_NIGHT_DIM)
+
+#if PANEL_CARE_ENABLED
+
+/**
+ * @brief Apply the burn-in shift and the night contrast for @p now.
+ *
+ * @details
+ * Both are functions of the wall-clock time only, so they need no state that
+ * would have to survive deep sleep:
+ *   - CONFIG_APP_PANEL_SHIFT: every CONFIG_APP_PANEL_SHIFT_PERIOD_S the image
+ *     moves one row, 0 → CONFIG_APP_PANEL_SHIFT_ROWS and back
+ *     (display_set_row_shift())
+ *   - CONFIG_APP_NIGHT_DIM: CONFIG_APP_NIGHT_CONTRAST from
+ *     CONFIG_APP_NIGHT_START_HOUR to CONFIG_APP_NIGHT_END_HOUR local time,
+ *     CONFIG_APP_DAY_CONTRAST otherwise and while the clock is unsynced
+ *     (display_set_contrast())
+ *
+ * Only changes reach the bus, a few command bytes each; the framebuffer is
+ * never redrawn for either. Cheap enough to call every frame.
+ *
+ * @note Call from the task that owns the display, after display_init().
+ */
+void panel_care_update(time_t now);
+
+#else
+
+static inline void panel_care_update(time_t now)
+{
+    (void)now;
+}
+
+#endif // PANEL_CARE_ENABLED
+
+#endif // PANEL_CARE_H
@@ -0,0 +1,129 @@
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+
+#include "sdkconfig.h"
+
+#define PERF_HIST_BUCKETS       20  /**< Bucket 0: 0 us; bucket i: [2^(i-1), 2^i) us; last bucket is open-ended */
+#define PERF_MAX_TASKS          4   /**< Tasks whose stack high-water mark is reported */
+#define PERF_MAX_SYSTEM_TASKS   24  /**< Tasks listed by perf_stats_dump_tasks(), system tasks included */
+
+/**
+ * @brief Pipeline stages with a latency histogram.
+ */
+typedef enum {
+    PERF_STAGE_FRAME = 0,   /**< One render loop iteration: compose + flush */
+    PERF_STAGE_FLUSH,       /**< display_flush_async(): batch build and submit; the bus time overlaps the next frame */
+    PERF_STAGE_SENSOR,      /**< BME280 trigger -> collect -> publish, conversion wait included */
+    PERF_STAGE_COUNT,
+} perf_stage_t;
+
+/**
+ * @brief Summary of one stage, as printed by perf_stats_dump().
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t p50_us;        /**< Upper bound of the median's histogram bucket */
+    uint32_t p99_us;
+} perf_stage_summary_t;
+
+#if CONFIG_APP_PERF_STATS
+
+/**
+ * @brief Timestamp to pass to perf_stats_end().
+ */
+static inline int64_t perf_stats_begin(void)
+{
+    return esp_timer_get_time();
+}
+
+/**
+ * @brief Record the time elapsed since @p start_us for @p stage.
+ *
+ * @param[in] stage    Stage to account.
+ * @param[in] start_us Value returned by perf_stats_begin().
+ *
+ * @note Task context only; a short critical section guards the histogram.
+ */
+void perf_stats_end(perf_stage_t stage, int64_t start_us);
+
+/**
+ * @brief Report the stack high-water mark of @p task in perf_stats_dump().
+ *
+ * @param[in] task Task handle.
+ * @param[in] name Label shown in the dump (must outlive the program).
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_NO_MEM if @ref PERF_MAX_TASKS tasks are already watched
+ */
+esp_err_t perf_stats_watch_task(TaskHandle_t task, const char *name);
+
+/**
+ * @brief Summarize @p stage for export (e.g. the HTTP metrics endpoint).
+ *
+ * @param[in]  stage Stage to read.
+ * @param[out] out   Summary; all zero for an unknown stage.
+ */
+void perf_stats_get(perf_stage_t stage, perf_stage_summary_t *out);
+
+/**
+ * @brief Short lowercase name of @p stage ("frame", "flush", "sensor").
+ */
+const char *perf_stats_stage_name(perf_stage_t stage);
+
+/**
+ * @brief Print stage histograms, I2C traffic and stack high-water marks to stdout.
+ */
+void perf_stats_dump(void);
+
+/**
+ * @brief Print every task's core, priority, CPU share and stack headroom, then the load per core.
+ *
+ * Shares are measured over the window since the previous call (since boot
+ * on the first call), from the FreeRTOS run-time counters. A core's load is
+ * 100 % minus the share of its idle task.
+ */
+void perf_stats_dump_tasks(void);
+
+/**
+ * @brief Clear the stage histograms and the I2C traffic counters.
+ */
+void perf_stats_reset(void);
+
+/**
+ * @brief Add the `perf` and `tasks` commands to the console.
+ *
+ * `perf` dumps the statistics, `perf reset` clears them, `tasks` runs
+ * perf_stats_dump_tasks().
+ *
+ * @return ESP_OK on success, or the esp_console error.
+ *
+ * @note Call between app_console_init() and app_console_start().
+ */
+esp_err_t perf_stats_register_commands(void);
+
+#else
+
+static inline int64_t perf_stats_begin(void) { return 0; }
+static inline void perf_stats_end(perf_stage_t stage, int64_t start_us) { (void)stage; (void)start_us; }
+static inline esp_err_t perf_stats_watch_task(TaskHandle_t task, const char *name) { (void)task; (void)name; return ESP_OK; }
+static inline void perf_stats_get(perf_stage_t stage, perf_stage_summary_t *out) { (void)stage; *out = (perf_stage_summary_t){0}; }
+static inline const char *perf_stats_stage_name(perf_stage_t stage) { (void)stage; return ""; }
+static inline void perf_stats_dump(void) {}
+static inline void perf_stats_dump_tasks(void) {}
+static inline void perf_stats_reset(void) {}
+static inline esp_err_t perf_stats_register_commands(void) { return ESP_OK; }
+
+#endif // CONFIG_APP_PERF_STATS
+
+#endif // PERF_STATS_H
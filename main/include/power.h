@@ -0,0 +1,56 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "bme280_defs.h"
+#include "sdkconfig.h"
+
+#define POWER_WAKE_GUARD_US     2000    /**< Wake this long after the aligned edge so time() already reads it */
+
+/**
+ * @brief Apply the configured power mode.
+ *
+ * With CONFIG_APP_POWER_LIGHT_SLEEP, enables dynamic frequency scaling
+ * (CONFIG_APP_PM_MIN_FREQ_MHZ .. CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ) and automatic
+ * light sleep whenever every task is blocked. Otherwise does nothing.
+ *
+ * @return ESP_OK on success, or the esp_pm_configure() error.
+ */
+esp_err_t power_init(void);
+
+/**
+ * @brief Number of boots since power-on, deep-sleep wake-ups included.
+ */
+uint32_t power_rtc_boot_count(void);
+
+/**
+ * @brief Keep @p data in RTC memory so it survives deep sleep.
+ */
+void power_rtc_store_sample(const struct bme280_data *data);
+
+/**
+ * @brief Fetch the sample kept by power_rtc_store_sample() before the last deep sleep.
+ *
+ * @param[out] out Retained sample.
+ *
+ * @return true if a sample was retained, false after a cold boot.
+ */
+bool power_rtc_load_sample(struct bme280_data *out);
+
+/**
+ * @brief Enter deep sleep until the next wall-clock multiple of @p interval_s.
+ *
+ * Waking on aligned edges (e.g. whole minutes) keeps the shown time exact
+ * even though the application only runs for a moment per interval.
+ *
+ * @param[in] interval_s Wake period in seconds.
+ *
+ * @note Does not return; the application restarts from app_main() on wake.
+ */
+void power_deep_sleep_aligned(uint32_t interval_s) __attribute__((noreturn));
+
+#endif // POWER_H
@@ -0,0 +1,67 @@
+#ifndef SAMPLE_RATE_H
+#define SAMPLE_RATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#include "sensor_history.h"
+
+/**
+ * @brief Adaptive sampling period of the sensor task.
+ *
+ * @details
+ * Each new sample is compared with the reference sample (the last one that
+ * moved the period). If any of temperature, humidity or pressure moved by at
+ * least its CONFIG_APP_SENSOR_ADAPTIVE_*_DELTA, the period drops straight back
+ * to the fastest one; otherwise it doubles, up to the slowest one. A stable
+ * room is therefore sampled every few tens of seconds, and the first real
+ * change is followed at full rate.
+ */
+typedef struct {
+    uint32_t min_ms;                /**< Fastest period */
+    uint32_t max_ms;                /**< Slowest period */
+    uint32_t period_ms;             /**< Current period */
+    sensor_sample_t ref;            /**< Sample the deltas are measured from */
+    bool have_ref;                  /**< @ref ref is set */
+} sample_rate_t;
+
+/**
+ * @brief Sampling counters since boot.
+ */
+typedef struct {
+    uint32_t period_ms;             /**< Current period */
+    uint32_t speedups;              /**< Samples that dropped the period to the minimum */
+    uint32_t backoffs;              /**< Samples that doubled the period */
+} sample_rate_stats_t;
+
+#if CONFIG_APP_SENSOR_ADAPTIVE
+
+/**
+ * @brief Start at the fastest period, with no reference sample.
+ *
+ * @param[out] rate   State to initialize.
+ * @param[in]  min_ms Fastest period (> 0).
+ * @param[in]  max_ms Slowest period; raised to @p min_ms if lower.
+ */
+void sample_rate_init(sample_rate_t *rate, uint32_t min_ms, uint32_t max_ms);
+
+/**
+ * @brief Feed one sample and get the period until the next one.
+ *
+ * @param[in,out] rate   State from sample_rate_init().
+ * @param[in]     sample New sample, or NULL if the round failed (the period is kept).
+ *
+ * @return Period in ms until the next sample.
+ */
+uint32_t sample_rate_update(sample_rate_t *rate, const sensor_sample_t *sample);
+
+/**
+ * @brief Copy the sampling counters.
+ */
+void sample_rate_get_stats(sample_rate_stats_t *out);
+
+#endif // CONFIG_APP_SENSOR_ADAPTIVE
+
+#endif // SAMPLE_RATE_H
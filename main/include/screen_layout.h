@@ -0,0 +1,34 @@
+#ifndef SCREEN_LAYOUT_H
+#define SCREEN_LAYOUT_H
+
+#include "display.h"
+
+/**
+ * @brief Fields of the text screen, indexes into @ref text_screen_layout.
+ */
+typedef enum {
+    TEXT_FIELD_TIME,            /**< "HH:MM:SS" or the unsynced notice */
+    TEXT_FIELD_DATE,            /**< "YYYY-MM-DD" or the unsynced notice */
+    TEXT_FIELD_HUMIDITY,        /**< "Hum-" value "%" */
+    TEXT_FIELD_TEMPERATURE,     /**< "Temp-" value "C" */
+    TEXT_FIELD_PRESSURE,        /**< "Pres-" value "hPa" */
+    TEXT_FIELD_COUNT,
+} text_field_t;
+
+/**
+ * @brief Position, width, alignment and labels of every text screen field.
+ *
+ * @details
+ * Selected at compile time from the configured panel height
+ * (CONFIG_COMMON_I2C_SSD1306_HEIGHT):
+ *   - 128x64: time, date, then humidity / temperature / pressure on the
+ *     lower pages
+ *   - 128x32: time and the three readings, one 8 px page each; the date is
+ *     left out (@ref DISPLAY_FIELD_ABSENT)
+ *
+ * All positions are constant expressions (DISPLAY_FIELD_LAYOUT()), so
+ * nothing is measured or centered at run time.
+ */
+extern const display_field_layout_t text_screen_layout[TEXT_FIELD_COUNT];
+
+#endif // SCREEN_LAYOUT_H
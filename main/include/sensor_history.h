@@ -0,0 +1,137 @@
+#ifndef SENSOR_HISTORY_H
+#define SENSOR_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "bme280_defs.h"
+#include "sdkconfig.h"
+
+#define SENSOR_HISTORY_LEN      CONFIG_APP_HISTORY_SAMPLES  /**< Samples kept in RAM */
+#define SENSOR_SAMPLE_UNDATED   0   /**< Timestamp of a sample taken before the wall clock was valid */
+
+/**
+ * @brief One BME280 sample in compact fixed point (12 bytes).
+ */
+typedef struct {
+    uint32_t timestamp;         /**< Wall-clock epoch seconds when the sample was taken, or @ref SENSOR_SAMPLE_UNDATED */
+    int16_t temperature_c100;   /**< Temperature in 0.01 °C */
+    uint16_t humidity_c100;     /**< Relative humidity in 0.01 % */
+    uint32_t pressure_pa;       /**< Pressure in Pa */
+} sensor_sample_t;
+
+/**
+ * @brief Whether @p s carries a wall-clock timestamp.
+ *
+ * Undated samples (taken before SNTP or a retained clock made the time valid)
+ * stay in the RAM ring for the display and the graph, but are never spilled to
+ * flash, counted by sensor_history_stats() or returned by sensor_history_copy(),
+ * and the consumers of sensor_history_read() drop them.
+ */
+static inline bool sensor_sample_dated(const sensor_sample_t *s)
+{
+    return s->timestamp != SENSOR_SAMPLE_UNDATED;
+}
+
+/**
+ * @brief Min/max/mean over a window of samples, same units as @ref sensor_sample_t.
+ */
+typedef struct {
+    uint32_t count;             /**< Samples in the window; the other fields are 0 if none */
+    uint32_t first_timestamp;   /**< Oldest sample in the window */
+    uint32_t last_timestamp;    /**< Newest sample in the window */
+    int16_t temperature_min, temperature_max, temperature_mean;
+    uint16_t humidity_min, humidity_max, humidity_mean;
+    uint32_t pressure_min, pressure_max, pressure_mean;
+} sensor_history_stats_t;
+
+/**
+ * @brief Create the lock and, with CONFIG_APP_HISTORY_SPILL, open the flash log.
+ *
+ * @return
+ *   - ESP_OK on success (a missing history partition only disables spilling)
+ *   - ESP_ERR_NO_MEM if the lock could not be created
+ */
+esp_err_t sensor_history_init(void);
+
+/**
+ * @brief Convert a compensated BME280 reading to @ref sensor_sample_t (rounded, saturated).
+ */
+sensor_sample_t sensor_sample_from_bme280(const struct bme280_data *data, uint32_t timestamp);
+
+/**
+ * @brief Append a sample in O(1), overwriting the oldest once the ring is full.
+ *
+ * Every CONFIG_APP_HISTORY_SPILL_EVERY-th dated sample is also written to the flash log.
+ *
+ * @note Task context only.
+ */
+void sensor_history_append(const sensor_sample_t *sample);
+
+/**
+ * @brief Number of samples currently held in RAM.
+ */
+size_t sensor_history_count(void);
+
+/**
+ * @brief Samples appended since boot; wraps at 2^32.
+ *
+ * Sample number n (counting from 0) is the one appended when the total went
+ * from n to n + 1, which is how sensor_history_mean() addresses a range.
+ */
+uint32_t sensor_history_total(void);
+
+/**
+ * @brief Mean of the @p count samples numbered [end - count, end).
+ *
+ * Addressing by sample number rather than age keeps a bucket stable while
+ * the sensor task appends. The timestamp is the newest sample's.
+ *
+ * @param[in]  end   One past the newest sample, in sensor_history_total() numbering.
+ * @param[in]  count Samples to average (> 0).
+ * @param[out] out   Mean sample.
+ *
+ * @return false if any of the samples is no longer (or not yet) in the ring.
+ */
+bool sensor_history_mean(uint32_t end, size_t count, sensor_sample_t *out);
+
+/**
+ * @brief Copy up to @p max samples starting at sample number @p *from, oldest first.
+ *
+ * Lets a consumer use the ring as a bounded queue: it keeps the number of
+ * the next sample it wants and advances it by the return value. Undated
+ * samples are copied like the others, so the numbering stays contiguous;
+ * exporters skip them with sensor_sample_dated().
+ *
+ * @param[in,out] from First sample wanted, in sensor_history_total() numbering.
+ *                     Moved forward to the oldest sample held if that one has
+ *                     already been overwritten.
+ * @param[out]    out  Destination.
+ * @param[in]     max  Capacity of @p out.
+ *
+ * @return Number of samples written.
+ */
+size_t sensor_history_read(uint32_t *from, sensor_sample_t *out, size_t max);
+
+/**
+ * @brief Copy dated samples taken at or after @p since, oldest first.
+ *
+ * @param[out] out   Destination.
+ * @param[in]  max   Capacity of @p out; the newest @p max samples are kept if more match.
+ * @param[in]  since Earliest timestamp to include (0 for all).
+ *
+ * @return Number of samples written.
+ */
+size_t sensor_history_copy(sensor_sample_t *out, size_t max, uint32_t since);
+
+/**
+ * @brief Min/max/mean of the dated samples taken during the last @p window_s seconds before @p now.
+ *
+ * @return true if at least one sample fell into the window.
+ */
+bool sensor_history_stats(uint32_t now, uint32_t window_s, sensor_history_stats_t *out);
+
+#endif // SENSOR_HISTORY_H
@@ -0,0 +1,71 @@
+#ifndef SENSOR_SNAPSHOT_H
+#define SENSOR_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+
+#include "bme280_defs.h"
+
+#define SENSOR_SNAPSHOT_MAX_SUBSCRIBERS 4
+
+/**
+ * @brief One published BME280 sample.
+ */
+typedef struct {
+    struct bme280_data data;    /**< Compensated temperature / pressure / humidity */
+    int64_t captured_us;        /**< esp_timer_get_time() when the sample was published */
+    uint32_t seq;               /**< Samples published so far; 0 means none yet */
+} sensor_snapshot_t;
+
+/**
+ * @brief Publish a new sample (single writer: sensor_task()).
+ *
+ * @details
+ * Writes the sample under a sequence counter (seqlock): the counter is odd
+ * while the copy is in progress and even once it is complete. Readers never
+ * block the writer. Every subscriber is then woken with its notify bits.
+ *
+ * @param[in] data Sample to publish.
+ *
+ * @note Must only be called from one task.
+ */
+void sensor_snapshot_publish(const struct bme280_data *data);
+
+/**
+ * @brief Copy the latest sample without taking any lock.
+ *
+ * Retries if the writer updated the sample during the copy, so the result is
+ * never torn. Safe from any task and any number of readers.
+ *
+ * @param[out] out Latest sample.
+ *
+ * @return true if a sample has been published, false otherwise (@p out is zeroed).
+ */
+bool sensor_snapshot_read(sensor_snapshot_t *out);
+
+/**
+ * @brief Number of samples published so far.
+ *
+ * Cheap way for a consumer to tell whether sensor_snapshot_read() would
+ * return something new.
+ */
+uint32_t sensor_snapshot_seq(void);
+
+/**
+ * @brief Wake @p task with xTaskNotify(eSetBits) on every publish.
+ *
+ * @param[in] task        Task to notify.
+ * @param[in] notify_bits Bits OR-ed into the task's notification value.
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_ERR_INVALID_ARG if @p task is NULL
+ *   - ESP_ERR_NO_MEM if @ref SENSOR_SNAPSHOT_MAX_SUBSCRIBERS are already registered
+ */
+esp_err_t sensor_snapshot_subscribe(TaskHandle_t task, uint32_t notify_bits);
+
+#endif // SENSOR_SNAPSHOT_H
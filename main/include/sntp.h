@@ -1,19 +1,26 @@
 #ifndef SNTP_H
 #define SNTP_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /**
  * @brief Block until time is synchronized or a timeout occurs.
  *
  * @details
- * Waits for SNTP to complete synchronization. Uses the official
- * esp_netif_sntp_sync_wait() API (ESP-IDF 5.x). If that fails, falls
- * back to a manual check of the system time to validate synchronization.
+ * Waits on NET_TIME_SYNCED_BIT of the Wi-Fi event group, which the
+ * sntp_sync_time() override sets once a server answer has been applied
+ * (esp_netif_sntp_sync_wait() relies on the hook it replaces, so it would
+ * never return). If the bit is not set within @p timeout_ms, falls back to
+ * checking the system clock with clock_is_plausible() (a post-2016 epoch,
+ * e.g. kept across a soft reset), up to 10 times 500 ms apart.
  *
  * @param timeout_ms Maximum time to wait in milliseconds.
  *
  * @return None
  *
- * @note Logs a warning if synchronization fails within the timeout.
+ * @note Logs a warning if neither succeeds; the call then takes about
+ *       @p timeout_ms plus 5 s.
  */
 void wait_for_time_blocking(uint32_t timeout_ms);
 
@@ -22,11 +29,11 @@ void wait_for_time_blocking(uint32_t timeout_ms);
  *
  * @details
  * This function performs the following steps:
- *   - Initializes NVS (required for Wi-Fi).
- *   - Connects to Wi-Fi in station mode.
- *   - Starts SNTP client to synchronize time with NTP servers.
- *   - Configures the timezone for Europe/Bucharest (with automatic DST).
- *   - Blocks until the system time is synchronized or the given timeout expires.
+ *   - Applies the configured time zone (local_time_init()).
+ *   - Starts SNTP client to synchronize time with NTP servers, or defers it
+ *     while the clock is still trusted (see sntp_time_is_trusted()).
+ *   - Blocks until the system time is synchronized or a 10 s timeout expires,
+ *     unless the clock is trusted.
  *
  * @note This function should be called once during system startup,
  *       typically from app_main().
@@ -36,4 +43,42 @@ void wait_for_time_blocking(uint32_t timeout_ms);
  */
 void init_sntp(void);
 
+/**
+ * @brief Start SNTP and apply the time zone without waiting for a sync.
+ *
+ * @details
+ * Same setup as init_sntp() minus the blocking wait. The SNTP client keeps
+ * retrying until the network is up; completion sets @ref NET_TIME_SYNCED_BIT
+ * in wifi_get_event_group().
+ *
+ * @note Call after wifi_start_async() so the network stack exists.
+ */
+void init_sntp_async(void);
+
+/**
+ * @brief Whether the clock is within its error budget without a new sync.
+ *
+ * @return true if a sync was recorded in NVS, the RTC clock has kept running
+ *         since (soft reset or deep sleep, not power loss), and the estimated
+ *         error |drift| x elapsed is still below CONFIG_APP_SNTP_MAX_ERROR_MS.
+ *
+ * @note Initializes NVS on first use.
+ */
+bool sntp_time_is_trusted(void);
+
+/**
+ * @brief Opposite of sntp_time_is_trusted(): the clock should be resynced now.
+ *
+ * For callers that bring the network up only when needed (deep-sleep wake-ups).
+ */
+bool sntp_resync_due(void);
+
+/**
+ * @brief Check whether the system clock can be shown to the user.
+ *
+ * @return true once SNTP has synchronized, or if the clock already holds a
+ *         plausible (post-2016) date; false otherwise.
+ */
+bool sntp_time_is_valid(void);
+
 #endif // SNTP_H
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "sdkconfig.h"
+#include "sensor_history.h"
+
+#define TELEMETRY_FORMAT_VERSION    1
+#define TELEMETRY_HEADER_SIZE       4       /**< version, record size, u16 record count */
+#define TELEMETRY_RECORD_SIZE       12      /**< u32 timestamp, i16 0.01 °C, u16 0.01 %RH, u32 Pa */
+#define TELEMETRY_MAX_BATCH         128     /**< Most samples in one payload (backlog flush) */
+
+#define TELEMETRY_PAYLOAD_MAX       (TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_BATCH * TELEMETRY_RECORD_SIZE)
+
+/**
+ * @brief Publisher counters since boot.
+ */
+typedef struct {
+    uint32_t batches;       /**< Payloads handed to the MQTT client */
+    uint32_t samples;       /**< Samples in those payloads */
+    uint32_t dropped;       /**< Samples overwritten in the history before they could be sent */
+} telemetry_stats_t;
+
+/**
+ * @brief Pack @p count samples into one payload.
+ *
+ * @details
+ * Layout, all little endian:
+ *
+ * | Offset        | Size | Field                                     |
+ * |---------------|------|-------------------------------------------|
+ * | 0             | 1    | @ref TELEMETRY_FORMAT_VERSION             |
+ * | 1             | 1    | @ref TELEMETRY_RECORD_SIZE                |
+ * | 2             | 2    | record count                              |
+ * | 4 + 12 * i    | 4    | timestamp, epoch seconds                  |
+ * | 8 + 12 * i    | 2    | temperature, int16 0.01 °C                |
+ * | 10 + 12 * i   | 2    | humidity, uint16 0.01 %RH                 |
+ * | 12 + 12 * i   | 4    | pressure, uint32 Pa                       |
+ *
+ * Samples taken before the first SNTP sync carry timestamps near 1970.
+ *
+ * @param[out] out     Destination.
+ * @param[in]  size    Size of @p out.
+ * @param[in]  samples Samples, oldest first.
+ * @param[in]  count   Number of samples (at most @ref TELEMETRY_MAX_BATCH).
+ *
+ * @return Payload length, or 0 if it does not fit @p out.
+ */
+size_t telemetry_encode(uint8_t *out, size_t size, const sensor_sample_t *samples, size_t count);
+
+#if CONFIG_APP_MQTT_TELEMETRY
+
+/**
+ * @brief Start the MQTT client and the publisher task.
+ *
+ * @details
+ * The publisher treats the sample history (sensor_history.h) as its queue: it
+ * remembers the number of the next unsent sample and, while the broker is
+ * connected, sends every CONFIG_APP_MQTT_BATCH_SAMPLES samples as one payload
+ * (telemetry_encode()) to CONFIG_APP_MQTT_TOPIC. While Wi-Fi or the broker is
+ * down, samples simply stay in the ring; after reconnecting the backlog goes
+ * out in payloads of up to @ref TELEMETRY_MAX_BATCH samples. The queue is
+ * bounded by CONFIG_APP_HISTORY_SAMPLES; older samples are counted as dropped.
+ *
+ * @return
+ *   - ESP_OK on success
+ *   - ESP_FAIL if the client could not be created
+ *   - ESP_ERR_NO_MEM if the task could not be created or no subscriber slot is left
+ *
+ * @note Call after the network stack is up (wifi_init_sta() or wifi_start_async())
+ *       and sensor_history_init(). The client reconnects on its own.
+ */
+esp_err_t telemetry_start(void);
+
+/**
+ * @brief Copy the publisher counters.
+ */
+void telemetry_get_stats(telemetry_stats_t *out);
+
+#else
+
+static inline esp_err_t telemetry_start(void) { return ESP_OK; }
+static inline void telemetry_get_stats(telemetry_stats_t *out) { *out = (telemetry_stats_t){0}; }
+
+#endif // CONFIG_APP_MQTT_TELEMETRY
+
+#endif // TELEMETRY_H
@@ -1,9 +1,33 @@
 #ifndef WIFI_H
 #define WIFI_H
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "esp_bit_defs.h"
+
 #define WIFI_SSID "WIFI_SSID"
 #define WIFI_PASS "WIFI_PASS"
 
+#define NET_WIFI_CONNECTED_BIT  BIT0    /**< Set while the STA interface holds an IP address */
+#define NET_TIME_SYNCED_BIT     BIT1    /**< Set by sntp.c once system time has been synchronized */
+
+/**
+ * @brief Initialize the default NVS partition once, erasing it if its layout is outdated.
+ *
+ * Wi-Fi needs NVS; other NVS users (the SNTP sync state) call this before
+ * the network is started. Later calls return immediately.
+ */
+void wifi_nvs_init(void);
+
+/**
+ * @brief Get the network status event group, creating it on first use.
+ *
+ * Bits: @ref NET_WIFI_CONNECTED_BIT, @ref NET_TIME_SYNCED_BIT.
+ *
+ * @return Event group handle (never NULL; aborts on allocation failure).
+ */
+EventGroupHandle_t wifi_get_event_group(void);
+
 /**
  * @brief Initialize Wi-Fi in STA mode and wait for IP.
  *
@@ -21,4 +45,20 @@
  */
 void wifi_init_sta(void);
 
+/**
+ * @brief Same bring-up as wifi_init_sta(), but returns without waiting for an IP.
+ *
+ * The connection completes in the background; wait on or poll
+ * @ref NET_WIFI_CONNECTED_BIT in wifi_get_event_group() if needed.
+ */
+void wifi_start_async(void);
+
+/**
+ * @brief Turn the radio off (e.g. before deep sleep) without reconnecting.
+ *
+ * Clears @ref NET_WIFI_CONNECTED_BIT. A later wifi_start_async() is not
+ * supported in the same boot; deep sleep restarts the application anyway.
+ */
+void wifi_stop(void);
+
 #endif // WIFI_H
\ No newline at end of file
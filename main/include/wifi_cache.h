@@ -0,0 +1,58 @@
+#ifndef WIFI_CACHE_H
+#define WIFI_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_netif.h"
+
+#define WIFI_CACHE_NVS_NAMESPACE    "wifi_cache"
+#define WIFI_CACHE_NVS_KEY          "link"
+#define WIFI_CACHE_VERSION          1       /**< Bump when @ref wifi_cache_t changes layout */
+
+/**
+ * @brief Last good association and lease, persisted in NVS.
+ */
+typedef struct {
+    uint32_t version;                   /**< @ref WIFI_CACHE_VERSION */
+    char ssid[33];                      /**< SSID the entry belongs to; a different WIFI_SSID invalidates it */
+    uint8_t bssid[6];                   /**< AP the station was associated with */
+    uint8_t channel;                    /**< Primary channel of that AP */
+    esp_netif_ip_info_t ip_info;        /**< Address, netmask and gateway from the last DHCP lease */
+    esp_netif_dns_info_t dns;           /**< Main DNS server from the same lease */
+    int64_t leased_at;                  /**< Wall time the lease was obtained (0 if the clock was unset) */
+} wifi_cache_t;
+
+/**
+ * @brief Load the cached link for @p ssid.
+ *
+ * @param[in]  ssid SSID about to be joined.
+ * @param[out] out  Cached entry.
+ *
+ * @return
+ *   - ESP_OK if a valid entry for @p ssid exists
+ *   - ESP_ERR_NOT_FOUND if there is none, it is from another SSID, or its version is stale
+ *   - NVS error otherwise
+ *
+ * @note NVS must already be initialized (wifi_start() does it first).
+ */
+esp_err_t wifi_cache_load(const char *ssid, wifi_cache_t *out);
+
+/**
+ * @brief Store @p entry.
+ *
+ * Called once per DHCP lease, not on connects that reuse the cached one.
+ *
+ * @return ESP_OK on success, or the NVS error.
+ */
+esp_err_t wifi_cache_save(const wifi_cache_t *entry);
+
+/**
+ * @brief Forget the cached link (e.g. after the cached AP refused us).
+ *
+ * @return ESP_OK on success (also if nothing was cached), or the NVS error.
+ */
+esp_err_t wifi_cache_clear(void);
+
+#endif // WIFI_CACHE_H
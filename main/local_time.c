@@ -0,0 +1,237 @@
+/**
+ * @file local_time.c
+ * @brief Time zone setting and the cached local time conversion (see local_time.h).
+ *
+ * @details
+ * The time zone lives in NVS next to the SNTP sync state ("time" namespace,
+ * key "tz"). setenv() / tzset() are only called by local_time_init() and
+ * local_time_set_tz(); every change bumps a generation counter, and a cache
+ * built for an older generation converts again on its next use.
+ */
+
+#include <ctype.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+#include "sdkconfig.h"
+
+#include "local_time.h"
+
+static const char *TAG_LTIME = "LOCAL_TIME";
+
+#define LOCAL_TIME_NVS_NAMESPACE    "time"
+#define LOCAL_TIME_NVS_KEY_TZ       "tz"
+
+#define SECONDS_PER_DAY             86400
+#define SEARCH_STEP_S               (7 * SECONDS_PER_DAY)
+#define SEARCH_STEPS                53      /**< A year and a day: rules repeat yearly */
+
+/**
+ * @brief Built-in zones, for `tz Europe/Bucharest` instead of the POSIX string.
+ */
+static const struct {
+    const char *name;
+    const char *posix;
+} s_zones[] = {
+    { "UTC",                 "UTC0" },
+    { "Europe/London",       "GMT0BST,M3.5.0/1,M10.5.0" },
+    { "Europe/Berlin",       "CET-1CEST,M3.5.0,M10.5.0/3" },
+    { "Europe/Bucharest",    "EET-2EEST,M3.5.0/3,M10.5.0/4" },
+    { "America/New_York",    "EST5EDT,M3.2.0,M11.1.0" },
+    { "America/Chicago",     "CST6CDT,M3.2.0,M11.1.0" },
+    { "America/Denver",      "MST7MDT,M3.2.0,M11.1.0" },
+    { "America/Los_Angeles", "PST8PDT,M3.2.0,M11.1.0" },
+    { "Asia/Kolkata",        "IST-5:30" },
+    { "Asia/Tokyo",          "JST-9" },
+    { "Australia/Sydney",    "AEST-10AEDT,M10.1.0,M4.1.0/3" },
+};
+
+static char s_tz[LOCAL_TIME_TZ_MAX];
+static bool s_loaded;
+static atomic_uint s_tz_gen;
+static atomic_uint s_conversions;
+static atomic_uint s_searches;
+static atomic_uint s_tz_changes;
+
+/**
+ * @brief Days from 1970-01-01 to the civil date @p y-@p m-@p d (proleptic Gregorian).
+ */
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+/**
+ * @brief localtime_r() for @p t, returning the UTC offset it applied.
+ */
+static int32_t convert(time_t t, struct tm *tm)
+{
+    localtime_r(&t, tm);
+    int64_t local = days_from_civil(tm->tm_year + 1900, (unsigned)tm->tm_mon + 1, (unsigned)tm->tm_mday) *
+                    SECONDS_PER_DAY + tm->tm_hour * 3600 + tm->tm_min * 60 + tm->tm_sec;
+    return (int32_t)(local - (int64_t)t);
+}
+
+/**
+ * @brief First second after @p from whose offset differs from @p offset, or the search horizon.
+ */
+static time_t find_transition(time_t from, int32_t offset)
+{
+    atomic_fetch_add_explicit(&s_searches, 1, memory_order_relaxed);
+
+    struct tm tm;
+    time_t lo = from;
+    for (int step = 1; step <= SEARCH_STEPS; ++step) {
+        time_t hi = from + (time_t)step * SEARCH_STEP_S;
+        if (convert(hi, &tm) == offset) {
+            lo = hi;
+            continue;
+        }
+        // Offset changes in (lo, hi]: bisect to the second
+        while (hi - lo > 1) {
+            time_t mid = lo + (hi - lo) / 2;
+            if (convert(mid, &tm) == offset) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        return hi;
+    }
+    return lo;  // no DST in this zone: search again in a year
+}
+
+/**
+ * @brief Rough POSIX TZ syntax check: a zone name, then an offset.
+ *
+ * newlib falls back to UTC without a word on a string it cannot parse, so
+ * this catches the likely typos (an IANA name that is not in the table, an
+ * empty or truncated string) before they reach the clock.
+ */
+static bool tz_plausible(const char *tz)
+{
+    size_t len = strlen(tz);
+    if (len == 0 || len >= LOCAL_TIME_TZ_MAX || (!isalpha((unsigned char)tz[0]) && tz[0] != '<')) {
+        return false;
+    }
+    bool digit = false;
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = (unsigned char)tz[i];
+        if (!isgraph(c)) {
+            return false;
+        }
+        digit |= isdigit(c) != 0;
+    }
+    return digit;
+}
+
+static void apply(const char *tz)
+{
+    strlcpy(s_tz, tz, sizeof(s_tz));
+    setenv("TZ", s_tz, 1);
+    tzset();
+    atomic_fetch_add_explicit(&s_tz_gen, 1, memory_order_release);
+}
+
+void local_time_init(void)
+{
+    if (s_loaded) return;
+    s_loaded = true;
+
+    char tz[LOCAL_TIME_TZ_MAX] = "";
+    nvs_handle_t nvs;
+    if (nvs_open(LOCAL_TIME_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        size_t len = sizeof(tz);
+        if (nvs_get_str(nvs, LOCAL_TIME_NVS_KEY_TZ, tz, &len) != ESP_OK || !tz_plausible(tz)) {
+            tz[0] = '\0';
+        }
+        nvs_close(nvs);
+    }
+
+    apply(tz[0] ? tz : CONFIG_APP_TIMEZONE);
+    ESP_LOGI(TAG_LTIME, "Time zone %s%s", s_tz, tz[0] ? "" : " (default)");
+}
+
+esp_err_t local_time_set_tz(const char *tz)
+{
+    ESP_RETURN_ON_FALSE(tz, ESP_ERR_INVALID_ARG, TAG_LTIME, "no time zone");
+    for (size_t i = 0; i < sizeof(s_zones) / sizeof(s_zones[0]); ++i) {
+        if (strcmp(tz, s_zones[i].name) == 0) {
+            tz = s_zones[i].posix;
+            break;
+        }
+    }
+    ESP_RETURN_ON_FALSE(tz_plausible(tz), ESP_ERR_INVALID_ARG, TAG_LTIME, "not a POSIX TZ string: %s", tz);
+
+    s_loaded = true;
+    apply(tz);
+    atomic_fetch_add_explicit(&s_tz_changes, 1, memory_order_relaxed);
+    ESP_LOGI(TAG_LTIME, "Time zone set to %s", s_tz);
+
+    nvs_handle_t nvs;
+    ESP_RETURN_ON_ERROR(nvs_open(LOCAL_TIME_NVS_NAMESPACE, NVS_READWRITE, &nvs), TAG_LTIME, "nvs open");
+    esp_err_t err = nvs_set_str(nvs, LOCAL_TIME_NVS_KEY_TZ, s_tz);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    ESP_RETURN_ON_ERROR(err, TAG_LTIME, "nvs save");
+    return ESP_OK;
+}
+
+void local_time_get_tz(char *buf, size_t size)
+{
+    strlcpy(buf, s_tz, size);
+}
+
+const char *local_time_zone_name(size_t index)
+{
+    return index < sizeof(s_zones) / sizeof(s_zones[0]) ? s_zones[index].name : NULL;
+}
+
+const struct tm *local_time_get(local_time_cache_t *cache, time_t now)
+{
+    unsigned gen = atomic_load_explicit(&s_tz_gen, memory_order_acquire);
+    if (!cache->valid || cache->tz_gen != gen || now < cache->valid_from || now >= cache->valid_until) {
+        atomic_fetch_add_explicit(&s_conversions, 1, memory_order_relaxed);
+        cache->utc_offset_s = convert(now, &cache->tm);
+
+        // The transition found last time stands unless the zone changed or the clock was stepped past it
+        if (!cache->valid || cache->tz_gen != gen || now < cache->searched_from || now >= cache->next_transition) {
+            cache->next_transition = find_transition(now, cache->utc_offset_s);
+            cache->searched_from = now;
+        }
+
+        // On a transition day, day_start is midnight at the new offset, which may lie before the transition
+        cache->day_start = now - (cache->tm.tm_hour * 3600 + cache->tm.tm_min * 60 + cache->tm.tm_sec);
+        time_t midnight = cache->day_start + SECONDS_PER_DAY;
+        cache->valid_from = (cache->day_start > cache->searched_from) ? cache->day_start : cache->searched_from;
+        cache->valid_until = (midnight < cache->next_transition) ? midnight : cache->next_transition;
+        cache->tz_gen = gen;
+        cache->valid = true;
+        return &cache->tm;
+    }
+
+    int32_t second_of_day = (int32_t)(now - cache->day_start);
+    cache->tm.tm_hour = second_of_day / 3600;
+    cache->tm.tm_min = second_of_day / 60 % 60;
+    cache->tm.tm_sec = second_of_day % 60;
+    return &cache->tm;
+}
+
+void local_time_get_stats(local_time_stats_t *out)
+{
+    out->conversions = atomic_load_explicit(&s_conversions, memory_order_relaxed);
+    out->searches = atomic_load_explicit(&s_searches, memory_order_relaxed);
+    out->tz_changes = atomic_load_explicit(&s_tz_changes, memory_order_relaxed);
+}
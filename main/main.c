@@ -6,37 +6,65 @@
  * @details
  * This application:
  *   1) Initializes a shared I2C bus and attaches an SSD1306 OLED and a BME280 sensor
- *   2) Connects to Wi-Fi and starts SNTP to maintain system time
- *   3) Spawns a periodic sensor task that performs a single forced BME280 read every 2.5s
- *   4) Renders current time/date and the latest temperature/pressure/humidity on the OLED each second
+ *   2) Spawns a periodic sensor task that triggers a forced BME280 conversion every
+ *      CONFIG_APP_SENSOR_PERIOD_MS (2.5 s by default), sleeps through it and collects
+ *      the result (bme280_async.h)
+ *   3) Connects to Wi-Fi and starts SNTP to maintain system time
+ *      (in the background with CONFIG_APP_ASYNC_STARTUP, otherwise blocking)
+ *   4) Renders current time/date on every wall-clock second edge and the latest
+ *      temperature/pressure/humidity whenever a new sample is published
  *
  * Concurrency:
- * - A FreeRTOS mutex (s_bme_lock) protects access to the shared BME280 measurement struct.
+ * - The latest BME280 sample is shared through a lock-free seqlock (sensor_snapshot.h);
+ *   readers never block the sensor task.
+ * - The render loop sleeps on task notifications: an esp_timer aligned to second edges
+ *   and sensor_snapshot_publish() both wake it, so redraws happen only when something changed.
+ * - Task topology (Kconfig "Task topology"): sensor and render tasks and the I2C worker on
+ *   CONFIG_APP_CORE_APP (core 1), radio and network tasks on core 0. Priorities run
+ *   I2C worker > sensor > render > network helpers, so a flush never delays a sample.
+ *
+ * Power (power.h, CONFIG_APP_POWER_MODE):
+ * - Always on (default), or DFS + automatic light sleep between ticks, or one short
+ *   run per deep-sleep wake-up with the last sample and SNTP state kept in RTC memory.
+ *
+ * Instrumentation:
+ * - With CONFIG_APP_PERF_STATS, frame/flush/sensor latency histograms, I2C traffic and
+ *   stack high-water marks are printed by the `perf` console command (perf_stats.h);
+ *   `tasks` shows the CPU share of every task and the load per core.
  *
  * Display:
- * - Text is centered horizontally using the 8x8 font width for layout math.
- * - WIDTH/HEIGHT must match your panel configuration selected in ssd1306 driver.
+ * - Text rows come from the compile-time field table in screen_layout.c (position,
+ *   width and alignment of each display_field_t); glyphs are the bundled 5x7 font
+ *   (display_font.h) drawn in 8 px cells.
+ * - Frames are composed in a dirty-tracked framebuffer (display.c); only changed
+ *   page/column windows are sent over I2C, not the whole 1 KB frame.
+ * - With CONFIG_APP_GRAPH_SCREEN, a second screen shows sparklines of the sample
+ *   history (graph_screen.h), switched on a timer or by a button.
+ * - The panel size is CONFIG_COMMON_I2C_SSD1306_HEIGHT (128x64 or 128x32); the field table
+ *   has one layout per height, and the graph strips follow it at compile time.
  *
  * @note Requires working implementations of:
  *       - i2c_shared_init() to create the bus and device handles
- *       - wifi_init_sta() to join a Wi-Fi network
- *       - init_sntp() to start time sync
+ *       - wifi_init_sta() / wifi_start_async() to join a Wi-Fi network
+ *       - init_sntp() / init_sntp_async() to start time sync
  *
- * @warning Ensure your SSD1306 WIDTH/HEIGHT and I2C pins match your hardware.
+ * @warning Ensure your SSD1306 panel size and I2C pins match your hardware.
  * @copyright MIT
  */
 
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <sys/time.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
 
+#include "driver/gpio.h"
 #include "driver/i2c_master.h"
-
+#include "esp_check.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "fonts.h"
 #include "i2c_bus.h"
@@ -49,134 +77,783 @@
 #include "bme280_read.h"
 
 #include "common_i2c_init.h"
+#include "app_console.h"
+#include "bme280_sensor.h"
+#include "bme280_units.h"
+#include "display.h"
+#include "screen_layout.h"
+#include "panel_care.h"
+#include "boot_graph.h"
+#include "fixed_format.h"
+#include "http_api.h"
+#include "graph_screen.h"
+#include "local_time.h"
+#include "perf_stats.h"
+#include "power.h"
+#include "sensor_history.h"
+#include "sample_rate.h"
+#include "sensor_snapshot.h"
 #include "sntp.h"
+#include "telemetry.h"
 #include "wifi.h"
 
+static const char *TAG_MAIN = "MAIN";
+
+#if CONFIG_APP_POWER_DEEP_SLEEP
+#define TIME_SHOW_SECONDS   false               // redrawn once per wake-up, seconds would be stale
+static const char *TIME_UNSYNCED_CLOCK = "--:--";
+#else
+#define TIME_SHOW_SECONDS   true
+static const char *TIME_UNSYNCED_CLOCK = "--:--:--";
+#endif
+static const char *TIME_UNSYNCED_DATE = "time unsynced";
+
 static struct bme280_dev bme280_device_handle = {0};
+static bme280_sensor_t s_bme_primary;           /**< Registry view of bme280_device_handle */
+#if CONFIG_APP_BME280_SECONDARY
+static struct bme280_dev bme280_secondary_handle = {0};
+static bme280_sensor_t s_bme_secondary;
+#endif
 static ssd1306_t ssd1306_device_handle = (ssd1306_t){0};
-static struct bme280_data bme280_device_data = {0};
 
-static SemaphoreHandle_t s_bme_lock;
+#define RENDER_NOTIFY_SECOND    BIT0    /**< A wall-clock second edge has passed */
+#define RENDER_NOTIFY_SENSOR    BIT1    /**< A new sample was published (sensor_snapshot_subscribe()) */
+#define RENDER_NOTIFY_BUTTON    BIT2    /**< The screen button was pressed */
+#define RENDER_NOTIFY_FLUSHED   BIT3    /**< The display_flush_async() batch has left the bus */
+#define RENDER_EDGE_GUARD_US    1000    /**< Wake this long after the edge so time() already reads the new second */
+
+#define SCREEN_DEBOUNCE_US      200000  /**< Presses closer together than this are contact bounce */
+
+static TaskHandle_t s_render_task;
+static TaskHandle_t s_sensor_task;
+static esp_timer_handle_t s_second_timer;
+
+/**
+ * @brief What render_task() is showing.
+ */
+typedef enum {
+    SCREEN_TEXT,        /**< Clock and current readings */
+    SCREEN_GRAPH,       /**< Sparklines (graph_screen.h) */
+} screen_t;
+
+static screen_t s_screen = SCREEN_TEXT;
+
+static display_field_t s_fields[TEXT_FIELD_COUNT];  /**< Text screen fields, placed by text_screen_layout */
+
+/**
+ * @brief Displayed readings, held with hysteresis at the displayed precision.
+ */
+static struct {
+    fixed_hold_t temperature_c100;  /**< 0.1 °C steps */
+    fixed_hold_t humidity_c100;     /**< 0.1 %RH steps */
+    fixed_hold_t pressure_pa;       /**< 0.01 hPa steps */
+} s_shown;
+
+/**
+ * @brief Place the text fields from the compile-time layout and draw their static labels once.
+ */
+static void init_fields(void)
+{
+    for (size_t i = 0; i < TEXT_FIELD_COUNT; ++i) {
+        display_field_init(&s_fields[i], &text_screen_layout[i]);
+    }
+    // The value slots are blank again: the next render_sensor() must draw them
+    s_shown.temperature_c100.valid = false;
+    s_shown.humidity_c100.valid = false;
+    s_shown.pressure_pa.valid = false;
+}
+
+static local_time_cache_t s_clock_time;     /**< Local time cache of render_clock() */
+
+/** Two decimal digits of @p v (0..99) at @p out */
+static char *put_2digits(char *out, int v)
+{
+    out[0] = (char)('0' + v / 10);
+    out[1] = (char)('0' + v % 10);
+    return out + 2;
+}
+
+/**
+ * @brief Draw the time and date for @p now.
+ *
+ * Until sntp_time_is_valid() reports a usable clock, the rows show a
+ * "time unsynced" indicator instead of the 1970-based system time.
+ *
+ * local_time_get() turns the epoch into local time with a few divisions
+ * except at midnight and DST transitions, and the digits are written
+ * directly, so the per-second path does no TZ rule evaluation or strftime().
+ */
+static void render_clock(time_t now)
+{
+    char time_buffer[10]; // "HH:MM:SS"
+    char date_buffer[15]; // "YYYY-MM-DD"
+    if (sntp_time_is_valid()) {
+        const struct tm *tm = local_time_get(&s_clock_time, now);
+        char *p = put_2digits(time_buffer, tm->tm_hour);
+        *p++ = ':';
+        p = put_2digits(p, tm->tm_min);
+        if (TIME_SHOW_SECONDS) {
+            *p++ = ':';
+            p = put_2digits(p, tm->tm_sec);
+        }
+        *p = '\0';
+
+        int year = tm->tm_year + 1900;
+        p = put_2digits(put_2digits(date_buffer, year / 100 % 100), year % 100);
+        *p++ = '-';
+        p = put_2digits(p, tm->tm_mon + 1);
+        *p++ = '-';
+        p = put_2digits(p, tm->tm_mday);
+        *p = '\0';
+    } else {
+        strlcpy(time_buffer, TIME_UNSYNCED_CLOCK, sizeof(time_buffer));
+        strlcpy(date_buffer, TIME_UNSYNCED_DATE, sizeof(date_buffer));
+    }
+    display_field_set(&s_fields[TEXT_FIELD_TIME], time_buffer);
+    display_field_set(&s_fields[TEXT_FIELD_DATE], date_buffer);
+}
+
+/**
+ * @brief Draw humidity, temperature and pressure, if any displayed digit changes.
+ *
+ * Reads the latest sample through sensor_snapshot_read(), which never tears
+ * and never blocks the sensor task, and quantizes it with fixed_quantize().
+ * A sample that only moves below the displayed precision, or stays inside
+ * the CONFIG_APP_DISPLAY_HYST_* band, is dropped before formatting, so it
+ * adds nothing to the next flush. Only the numeric part is formatted, with
+ * integer math (fixed_format(), bme280_units.h); the labels and units were
+ * drawn once by init_fields().
+ *
+ * Before the first sensor_snapshot_publish() nothing is drawn: the value
+ * slots stay blank instead of showing a zeroed sample.
+ *
+ * @return true once a published sample is on screen, false if there is none yet.
+ */
+static bool render_sensor(void)
+{
+    sensor_snapshot_t snap;
+    if (!sensor_snapshot_read(&snap)) {
+        return false;
+    }
+
+    // Non-short-circuit |: every hold must see the sample
+    bool changed = fixed_quantize(&s_shown.temperature_c100, bme280_temperature_c100(&snap.data),
+                                  10, CONFIG_APP_DISPLAY_HYST_TEMP_C100);
+    changed |= fixed_quantize(&s_shown.humidity_c100, (int32_t)bme280_humidity_c100(&snap.data),
+                              10, CONFIG_APP_DISPLAY_HYST_HUM_C100);
+    changed |= fixed_quantize(&s_shown.pressure_pa, (int32_t)bme280_pressure_pa(&snap.data),
+                              1, CONFIG_APP_DISPLAY_HYST_PRES_PA);
+    if (!changed) {
+        return true;
+    }
+
+    char temperature_str[12];
+    char pressure_str[12];
+    char humidity_str[12];
+    fixed_format(temperature_str, sizeof(temperature_str), s_shown.temperature_c100.shown, 2, 1);
+    fixed_format(pressure_str,    sizeof(pressure_str),    s_shown.pressure_pa.shown, 2, 2); // Pa = hPa x 100
+    fixed_format(humidity_str,    sizeof(humidity_str),    s_shown.humidity_c100.shown, 2, 1);
+
+    display_field_set(&s_fields[TEXT_FIELD_HUMIDITY], humidity_str);
+    display_field_set(&s_fields[TEXT_FIELD_TEMPERATURE], temperature_str);
+    display_field_set(&s_fields[TEXT_FIELD_PRESSURE], pressure_str);
+    return true;
+}
+
+#if CONFIG_APP_GRAPH_SCREEN
+static int64_t s_screen_since_us;   /**< When the current screen was entered */
+static int64_t s_last_press_us;
+
+#if CONFIG_APP_SCREEN_BUTTON_GPIO >= 0
+static void IRAM_ATTR screen_button_isr(void *arg)
+{
+    (void)arg;
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(s_render_task, RENDER_NOTIFY_BUTTON, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+#endif
+
+/**
+ * @brief Configure CONFIG_APP_SCREEN_BUTTON_GPIO (active low, internal pull-up), if any.
+ */
+static void init_screen_button(void)
+{
+#if CONFIG_APP_SCREEN_BUTTON_GPIO >= 0
+    const gpio_config_t io = {
+        .pin_bit_mask = 1ULL << CONFIG_APP_SCREEN_BUTTON_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&io));
+    ESP_ERROR_CHECK(gpio_install_isr_service(0));
+    ESP_ERROR_CHECK(gpio_isr_handler_add(CONFIG_APP_SCREEN_BUTTON_GPIO, screen_button_isr, NULL));
+#endif
+}
+
+/**
+ * @brief True when a (debounced) button press or the CONFIG_APP_SCREEN_CYCLE_S timer asks for the other screen.
+ */
+static bool screen_switch_due(uint32_t events)
+{
+    int64_t now = esp_timer_get_time();
+    if (events & RENDER_NOTIFY_BUTTON) {
+        bool bounce = now - s_last_press_us < SCREEN_DEBOUNCE_US;
+        s_last_press_us = now;
+        if (!bounce) return true;
+    }
+    return CONFIG_APP_SCREEN_CYCLE_S > 0 && now - s_screen_since_us >= (int64_t)CONFIG_APP_SCREEN_CYCLE_S * 1000000;
+}
+#else
+static inline void init_screen_button(void) {}
+static inline bool screen_switch_due(uint32_t events) { (void)events; return false; }
+#endif // CONFIG_APP_GRAPH_SCREEN
+
+/**
+ * @brief Clear the panel and draw the static parts of @p screen.
+ *
+ * The next frame then fills in everything dynamic, as on the first frame.
+ */
+static void enter_screen(screen_t screen)
+{
+    s_screen = screen;
+    display_clear();
+    if (screen == SCREEN_GRAPH) {
+        graph_screen_draw();
+    } else {
+        init_fields();
+    }
+#if CONFIG_APP_GRAPH_SCREEN
+    s_screen_since_us = esp_timer_get_time();
+#endif
+}
+
+/**
+ * @brief esp_timer callback fired just after a wall-clock second edge.
+ */
+static void second_timer_cb(void *arg)
+{
+    (void)arg;
+    xTaskNotify(s_render_task, RENDER_NOTIFY_SECOND, eSetBits);
+}
+
+/**
+ * @brief (Re)arm @ref s_second_timer for the next wall-clock second edge.
+ *
+ * Computed from gettimeofday() on every call, so SNTP steps and variable
+ * I2C time never accumulate into drift.
+ */
+static void arm_second_timer(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    uint64_t until_edge_us = (uint64_t)(1000000 - tv.tv_usec) + RENDER_EDGE_GUARD_US;
+    esp_timer_stop(s_second_timer); // ESP_ERR_INVALID_STATE if it already fired: fine
+    ESP_ERROR_CHECK(esp_timer_start_once(s_second_timer, until_edge_us));
+}
 
 /**
- * @brief Render loop: clears screen, draws time/date and latest BME280 values every second.
+ * @brief Event-driven render loop: redraws on second edges and on new sensor data.
+ *
+ * The task sleeps on its notification value. @ref s_second_timer posts
+ * @ref RENDER_NOTIFY_SECOND right after each wall-clock second edge, and
+ * sensor_snapshot_publish() posts @ref RENDER_NOTIFY_SENSOR for every new sample.
+ * The clock rows are only redrawn when the second actually changed, the sensor
+ * rows only when a new sample arrived.
+ *
+ * Each row is a display_field_t: labels are drawn once, and only value
+ * characters that differ from the last frame are blitted into the dirty-tracked
+ * framebuffer (see display.h); display_flush_async() then queues those windows
+ * instead of the full 1 KB frame and returns while they are still on the bus.
+ * Its completion (@ref RENDER_NOTIFY_FLUSHED) wakes the loop once more, so
+ * anything drawn while the previous batch was in flight goes out right after it.
+ * Until the first sample is published, @ref RENDER_NOTIFY_SENSOR stays pending
+ * across wakes and @ref BOOT_MILESTONE_FIRST_FRAME is held back, so the first
+ * frame counted is one with real sensor values.
  *
- * Centers text horizontally using FONT_8x8 width (8 px).
- * Reads BME280 values under @ref s_bme_lock to avoid tearing.
+ * With CONFIG_APP_GRAPH_SCREEN the loop alternates with the sparkline screen,
+ * every CONFIG_APP_SCREEN_CYCLE_S seconds or on a press of the screen button
+ * (@ref RENDER_NOTIFY_BUTTON). The graph only redraws when a sample completes
+ * a column (graph_screen_update()).
  *
- * @note Blocks forever; intended to run in the main task context.
+ * @param[in] arg Unused.
+ *
+ * @note Runs forever on CONFIG_APP_CORE_APP at CONFIG_APP_RENDER_TASK_PRIO, below the sensor task.
  */
-static void print_data(void)
+static void render_task(void *arg)
 {
-    ssd1306_clear_screen(&ssd1306_device_handle);
+    (void)arg;
+    ESP_ERROR_CHECK(display_init(i2c_get_ssd1306()));
+    enter_screen(SCREEN_TEXT);
+    init_screen_button();
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = second_timer_cb,
+        .name = "render_second",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_second_timer));
+
+    time_t last_second = -1;
+    uint32_t events = RENDER_NOTIFY_SENSOR; // first frame draws the sensor rows too
+    uint32_t pending = 0;                   // RENDER_NOTIFY_SENSOR until a sample has been drawn
 
     while (1) {
-        time_t now = 0;
-        struct tm timeinfo = {0};
-        uint16_t horizontal_cursor;
-        uint16_t vertical_cursor;
-
-        time(&now);
-        localtime_r(&now, &timeinfo);
-
-        // ---- Time (HH:MM:SS), centered on row 1
-        char time_buffer[10]; // "HH:MM:SS"
-        strftime(time_buffer, sizeof(time_buffer), "%H:%M:%S", &timeinfo);
-        horizontal_cursor = (WIDTH / 2) - (8 * 8 / 2);
-        vertical_cursor   = (PIXELS_PER_PAGE * 1) - 4;
-        ssd1306_set_cursor(&ssd1306_device_handle, horizontal_cursor, vertical_cursor);
-        ssd1306_draw_string(&ssd1306_device_handle, time_buffer, &FONT_8x8, true);
-
-        // ---- Date (YYYY-MM-DD), centered on row 2
-        char date_buffer[15]; // "YYYY-MM-DD"
-        strftime(date_buffer, sizeof(date_buffer), "%Y-%m-%d", &timeinfo);
-        horizontal_cursor = (WIDTH / 2) - (8 * 10 / 2);
-        vertical_cursor   = (PIXELS_PER_PAGE * 2);
-        ssd1306_set_cursor(&ssd1306_device_handle, horizontal_cursor, vertical_cursor);
-        ssd1306_draw_string(&ssd1306_device_handle, date_buffer, &FONT_8x8, true);
-
-        // ---- Sensor strings (protected read)
-        char temperature_str[15];
-        char pressure_str[20];
-        char humidity_str[15];
-        xSemaphoreTake(s_bme_lock, portMAX_DELAY);
-        snprintf(temperature_str, sizeof(temperature_str), "Temp-%.1fC",  bme280_device_data.temperature);
-        snprintf(pressure_str,    sizeof(pressure_str),    "Pres-%.2fhPa", bme280_device_data.pressure / 100.0);
-        snprintf(humidity_str,    sizeof(humidity_str),    "Hum-%.1f%%",   bme280_device_data.humidity);
-        xSemaphoreGive(s_bme_lock);
-
-        // ---- Humidity on row 4
-        horizontal_cursor = (WIDTH / 2) - ((strlen(humidity_str) * 8) / 2);
-        vertical_cursor   = (PIXELS_PER_PAGE * 4) - 4;
-        ssd1306_set_cursor(&ssd1306_device_handle, horizontal_cursor, vertical_cursor);
-        ssd1306_draw_string(&ssd1306_device_handle, humidity_str, &FONT_8x8, true);
-
-        // ---- Temperature on row 5
-        horizontal_cursor = (WIDTH / 2) - ((strlen(temperature_str) * 8) / 2);
-        vertical_cursor   = (PIXELS_PER_PAGE * 5) - 2;
-        ssd1306_set_cursor(&ssd1306_device_handle, horizontal_cursor, vertical_cursor);
-        ssd1306_draw_string(&ssd1306_device_handle, temperature_str, &FONT_8x8, true);
-
-        // ---- Pressure on row 6
-        horizontal_cursor = (WIDTH / 2) - ((strlen(pressure_str) * 8) / 2);
-        vertical_cursor   = (PIXELS_PER_PAGE * 6);
-        ssd1306_set_cursor(&ssd1306_device_handle, horizontal_cursor, vertical_cursor);
-        ssd1306_draw_string(&ssd1306_device_handle, pressure_str, &FONT_8x8, true);
-
-        ESP_ERROR_CHECK(ssd1306_update(&ssd1306_device_handle));
-        vTaskDelay(pdMS_TO_TICKS(1000));
-    }
-}
-
-/**
- * @brief Periodically performs a single forced BME280 measurement and publishes it.
- *
- * Uses bme_forced_read_once() to trigger one-shot sampling, then stores the result
- * into @ref bme280_device_data under @ref s_bme_lock.
+        int64_t frame_start = perf_stats_begin();
+
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+
+        if (screen_switch_due(events)) {
+            enter_screen((s_screen == SCREEN_TEXT) ? SCREEN_GRAPH : SCREEN_TEXT);
+            last_second = -1;
+            events |= RENDER_NOTIFY_SENSOR;
+        }
+
+        panel_care_update(tv.tv_sec);
+
+        if (s_screen == SCREEN_GRAPH) {
+            if (events & RENDER_NOTIFY_SENSOR) {
+                graph_screen_update();
+            }
+        } else {
+            if (tv.tv_sec != last_second) {
+                render_clock(tv.tv_sec);
+                last_second = tv.tv_sec;
+            }
+            if ((events & RENDER_NOTIFY_SENSOR) && !render_sensor()) {
+                pending = RENDER_NOTIFY_SENSOR; // nothing published yet: retry on the next wake
+            }
+        }
+
+        // ---- Only the changed page/column windows go out on the bus, without waiting for them
+        int64_t flush_start = perf_stats_begin();
+        // A bus fault is not fatal: the frame stays dirty and goes out once the scheduler has recovered the panel
+        (void)display_flush_async(RENDER_NOTIFY_FLUSHED);
+        perf_stats_end(PERF_STAGE_FLUSH, flush_start);
+        perf_stats_end(PERF_STAGE_FRAME, frame_start);
+
+        arm_second_timer();
+        xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+        if ((events & RENDER_NOTIFY_FLUSHED) && !pending) {
+            boot_graph_mark(BOOT_MILESTONE_FIRST_FRAME);
+        }
+        events |= pending;
+        pending = 0;
+    }
+}
+
+/**
+ * @brief Timestamp for a sample taken now: the wall clock once it is valid, else @ref SENSOR_SAMPLE_UNDATED.
+ *
+ * With the asynchronous startup the first samples of a cold boot come before
+ * SNTP; stamped with time(NULL) they would read 1970 in the flash log, the
+ * telemetry and the history export.
+ */
+static uint32_t sample_timestamp(void)
+{
+    return sntp_time_is_valid() ? (uint32_t)time(NULL) : SENSOR_SAMPLE_UNDATED;
+}
+
+#if CONFIG_APP_SENSOR_TIMER
+/**
+ * @brief esp_timer callback: wake the sensor task for the next sample.
+ */
+static void sensor_timer_cb(void *arg)
+{
+    xTaskNotifyGive((TaskHandle_t)arg);
+}
+#endif
+
+#if CONFIG_APP_SENSOR_ADAPTIVE
+/**
+ * @brief Microseconds from now until the sample that follows the round started at @p round_start_us.
+ *
+ * With CONFIG_APP_SENSOR_WAKE_ALIGN the time is rounded up to the next
+ * wall-clock second edge plus @ref RENDER_EDGE_GUARD_US, the moment
+ * arm_second_timer() wakes the render loop. The sensor task has the higher
+ * priority, so its trigger goes out first and the clock redraw runs during
+ * the conversion wait.
+ */
+static uint64_t next_sample_delay_us(int64_t round_start_us, uint32_t period_ms)
+{
+    int64_t delay_us = round_start_us + (int64_t)period_ms * 1000 - esp_timer_get_time();
+    if (delay_us < 0) {
+        delay_us = 0;
+    }
+#if CONFIG_APP_SENSOR_WAKE_ALIGN
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t phase_us = ((int64_t)tv.tv_usec + delay_us - RENDER_EDGE_GUARD_US) % 1000000;
+    if (phase_us < 0) {
+        phase_us += 1000000;
+    }
+    if (phase_us != 0) {
+        delay_us += 1000000 - phase_us;
+    }
+#endif
+    return (uint64_t)delay_us;
+}
+#endif
+
+/**
+ * @brief Bind the BME280 handles and add them to the sensor registry.
+ *
+ * @param[out] primary   Registry index of the 0x76 sensor.
+ * @param[out] secondary Registry index of the 0x77 sensor (CONFIG_APP_BME280_SECONDARY), else untouched.
+ */
+static esp_err_t register_sensors(size_t *primary, size_t *secondary)
+{
+    bme280_sensor_bind(&s_bme_primary, &bme280_device_handle);
+    ESP_RETURN_ON_ERROR(sensor_registry_add(&bme280_sensor_driver, &s_bme_primary, bme280_sensor_device(&s_bme_primary),
+                                            "bme280@0x76", primary), TAG_MAIN, "bme280@0x76");
+#if CONFIG_APP_BME280_SECONDARY
+    bme280_sensor_bind(&s_bme_secondary, &bme280_secondary_handle);
+    ESP_RETURN_ON_ERROR(sensor_registry_add(&bme280_sensor_driver, &s_bme_secondary, bme280_sensor_device(&s_bme_secondary),
+                                            "bme280@0x77", secondary), TAG_MAIN, "bme280@0x77");
+#else
+    (void)secondary;
+#endif
+    return ESP_OK;
+}
+
+/**
+ * @brief Periodically samples every registered sensor and publishes the primary BME280.
+ *
+ * All sensors are sampled together by sensor_registry_sample(): their
+ * conversions run in parallel and their reads share one bus batch. Each
+ * primary sample is appended to the history and then handed to
+ * sensor_snapshot_publish(), which also wakes every subscriber (the render loop).
+ *
+ * With CONFIG_APP_BME280_NORMAL the chips convert continuously with their IIR
+ * filter (bme280_sensor.h), and each period only reads the latest results.
+ *
+ * With CONFIG_APP_SENSOR_ADAPTIVE the period follows the readings
+ * (sample_rate.h): CONFIG_APP_SENSOR_PERIOD_MS while they change, doubling up
+ * to CONFIG_APP_SENSOR_PERIOD_MAX_MS while they are stable. With
+ * CONFIG_APP_SENSOR_WAKE_ALIGN each sample is moved to the render loop's next
+ * second edge (next_sample_delay_us()), so light sleep is left once for both.
  *
  * @param[in] arg Unused.
  *
- * @note Runs forever with a 2.5s period.
- * @note Stack size and priority are configured in app_main() when creating the task.
+ * @note Runs forever. A fixed CONFIG_APP_SENSOR_PERIOD_MS period is measured from read to read:
+ *       xTaskDelayUntil() on the tick, or a periodic esp_timer with CONFIG_APP_SENSOR_TIMER.
+ *       With CONFIG_APP_SENSOR_ADAPTIVE each round sets the next delay as above instead:
+ *       a one-shot esp_timer, or a delay from the start of the round.
+ * @note Runs on CONFIG_APP_CORE_APP at CONFIG_APP_SENSOR_TASK_PRIO (see "Task topology" in Kconfig).
  */
 void sensor_task(void *arg)
 {
     (void)arg;
-    
-    struct bme280_data tmp;
+
+    size_t primary = 0, secondary = 0;
+    ESP_ERROR_CHECK(register_sensors(&primary, &secondary));
+
+#if CONFIG_APP_SENSOR_ADAPTIVE
+    sample_rate_t rate;
+    sample_rate_init(&rate, CONFIG_APP_SENSOR_PERIOD_MS, CONFIG_APP_SENSOR_PERIOD_MAX_MS);
+#endif
+
+#if CONFIG_APP_SENSOR_TIMER
+    esp_timer_handle_t timer;
+    const esp_timer_create_args_t timer_args = {
+        .callback = sensor_timer_cb,
+        .arg = xTaskGetCurrentTaskHandle(),
+        .name = "sensor_period",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer));
+#if !CONFIG_APP_SENSOR_ADAPTIVE
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, CONFIG_APP_SENSOR_PERIOD_MS * 1000ull));
+#endif
+#elif !CONFIG_APP_SENSOR_ADAPTIVE
+    TickType_t last_wake = xTaskGetTickCount();
+#endif
+
     while (1)
     {
-        bme_forced_read_once(&bme280_device_handle, &tmp);
-        xSemaphoreTake(s_bme_lock, portMAX_DELAY);
-        bme280_device_data = tmp;                  
-        xSemaphoreGive(s_bme_lock);
-        vTaskDelay(pdMS_TO_TICKS(2500));
+        int64_t sample_start = perf_stats_begin();
+#if CONFIG_APP_SENSOR_ADAPTIVE
+        int64_t round_start_us = esp_timer_get_time();
+#endif
+        uint32_t fresh = 0;
+        sensor_sample_t compact = {0};
+        sensor_registry_sample(&fresh);
+        if (fresh & (1u << primary)) {
+            // History first: the publish wakes the render loop, and the graph reads the ring
+            compact = sensor_sample_from_bme280(&s_bme_primary.data, sample_timestamp());
+            sensor_history_append(&compact);
+            sensor_snapshot_publish(&s_bme_primary.data);
+            perf_stats_end(PERF_STAGE_SENSOR, sample_start);
+            boot_graph_mark(BOOT_MILESTONE_FIRST_SAMPLE);
+        }
+#if CONFIG_APP_BME280_SECONDARY
+        if (fresh & (1u << secondary)) {
+            ESP_LOGD(TAG_MAIN, "bme280@0x77: %ld cC", (long)bme280_temperature_c100(&s_bme_secondary.data));
+        }
+#endif
+#if CONFIG_APP_SENSOR_ADAPTIVE
+        uint32_t period_ms = sample_rate_update(&rate, (fresh & (1u << primary)) ? &compact : NULL);
+        uint64_t delay_us = next_sample_delay_us(round_start_us, period_ms);
+#if CONFIG_APP_SENSOR_TIMER
+        ESP_ERROR_CHECK(esp_timer_start_once(timer, delay_us));
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#else
+        vTaskDelay((TickType_t)((delay_us * configTICK_RATE_HZ + 999999) / 1000000));   // rounded up
+#endif
+#elif CONFIG_APP_SENSOR_TIMER
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#else
+        xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CONFIG_APP_SENSOR_PERIOD_MS));
+#endif
     }
 }
 
+#if CONFIG_APP_POWER_DEEP_SLEEP
 /**
- * @brief Application entry point.
+ * @brief One deep-sleep wake-up: sample, draw, resync the clock if due, sleep.
  *
- * Initializes I2C (shared bus for BME280 + SSD1306), starts Wi-Fi and SNTP,
- * creates the BME mutex, spawns the @ref sensor_task, then enters the render loop.
+ * The panel keeps showing the last frame while the ESP32 sleeps. The sample
+ * retained in RTC memory is published first, so a failed read still shows the
+ * previous values rather than zeros. Wi-Fi is only started when sntp_resync_due()
+ * says the estimated clock error has used up its budget. A display error is
+ * logged and the frame skipped; the cycle still resyncs if due and goes back
+ * to sleep rather than panicking.
  *
- * @note Blocks in @ref print_data(); this function never returns.
+ * @note Does not return.
  */
-void app_main(void)
+static void deep_sleep_cycle(void)
 {
-    // Initialize shared I2C bus
-    ESP_ERROR_CHECK(i2c_shared_init(&bme280_device_handle, &ssd1306_device_handle));
-    
-    // Initialize Network
-    wifi_init_sta();
+    struct bme280_data sample;
+    if (power_rtc_load_sample(&sample)) {
+        sensor_snapshot_publish(&sample);
+    }
+
+    // The same registry round as sensor_task(), so a secondary BME280 is sampled here too
+    size_t primary = 0, secondary = 0;
+    uint32_t fresh = 0;
+    if (register_sensors(&primary, &secondary) == ESP_OK && sensor_registry_sample(&fresh) == ESP_OK &&
+        (fresh & (1u << primary))) {
+        sample = s_bme_primary.data;
+#if CONFIG_APP_BME280_SECONDARY
+        if (fresh & (1u << secondary)) {
+            ESP_LOGD(TAG_MAIN, "bme280@0x77: %ld cC", (long)bme280_temperature_c100(&s_bme_secondary.data));
+        }
+#endif
+        sensor_snapshot_publish(&sample);
+        boot_graph_mark(BOOT_MILESTONE_FIRST_SAMPLE);
+        power_rtc_store_sample(&sample);
+        sensor_sample_t compact = sensor_sample_from_bme280(&sample, sample_timestamp());
+        sensor_history_append(&compact); // RAM ring restarts per wake-up; the flash log keeps the series
+    }
+
+    local_time_init();
+    // A panel fault only costs this frame: the sample and boot count are already in RTC memory
+    esp_err_t err = display_init(i2c_get_ssd1306());
+    bool panel_ok = (err == ESP_OK);
+    if (panel_ok) {
+        init_fields();
+        render_clock(time(NULL));
+        bool sensor_drawn = render_sensor(); // no sample this wake-up: the value slots stay blank
+        panel_care_update(time(NULL));  // the panel keeps its registers, but this boot does not know them
+        err = display_flush();
+        if (err == ESP_OK && sensor_drawn) {
+            boot_graph_mark(BOOT_MILESTONE_FIRST_FRAME);
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG_MAIN, "Display: %s, frame skipped this wake-up", esp_err_to_name(err));
+    }
+
+    if (sntp_resync_due()) {
+        wifi_start_async();
+        EventBits_t bits = xEventGroupWaitBits(wifi_get_event_group(), NET_WIFI_CONNECTED_BIT, pdFALSE, pdTRUE,
+                                               pdMS_TO_TICKS(CONFIG_APP_DEEP_SLEEP_WIFI_TIMEOUT_MS));
+        if (bits & NET_WIFI_CONNECTED_BIT) {
+            init_sntp();
+            if (panel_ok && (xEventGroupGetBits(wifi_get_event_group()) & NET_TIME_SYNCED_BIT)) {
+                render_clock(time(NULL));
+                (void)display_flush(); // a fault here keeps the estimated time on screen until the next wake-up
+            }
+        }
+        wifi_stop();
+    }
+
+    power_deep_sleep_aligned(CONFIG_APP_DEEP_SLEEP_INTERVAL_S);
+}
+#endif
+
+/* ---- Boot stages (boot_graph.h) */
+
+/**
+ * @brief Indexes into @ref s_boot_stages; the dependency bits of each stage.
+ */
+enum {
+    BOOT_POWER,
+    BOOT_SETTINGS,
+    BOOT_HISTORY,
+    BOOT_I2C,
+    BOOT_BME280,
+    BOOT_OLED,
+    BOOT_NET,
+    BOOT_SENSOR,
+    BOOT_RENDER,
+    BOOT_SERVICES,
+    BOOT_CONSOLE,
+    BOOT_STAGE_COUNT,
+};
 
-    // Initialize Time
+#define DEP(stage)  (1u << (stage))
+
+static esp_err_t boot_power(void)
+{
+    return power_init();
+}
+
+/**
+ * @brief NVS, the network event group and the time zone (NVS or CONFIG_APP_TIMEZONE): everything later stages read on first use.
+ *
+ * wifi_get_event_group() and wifi_nvs_init() create their objects lazily, which
+ * is only safe from one task, so this stage does it before anything runs
+ * side by side.
+ */
+static esp_err_t boot_settings(void)
+{
+    wifi_nvs_init();
+    ESP_RETURN_ON_FALSE(wifi_get_event_group(), ESP_ERR_NO_MEM, TAG_MAIN, "net events");
+    local_time_init();
+    return ESP_OK;
+}
+
+static esp_err_t boot_history(void)
+{
+    return sensor_history_init();
+}
+
+static esp_err_t boot_i2c(void)
+{
+    return i2c_shared_start();
+}
+
+static esp_err_t boot_bme280(void)
+{
+    ESP_RETURN_ON_ERROR(i2c_shared_init_bme280(&bme280_device_handle), TAG_MAIN, "bme280");
+#if CONFIG_APP_BME280_SECONDARY
+    ESP_RETURN_ON_ERROR(i2c_add_bme280(BME280_I2C_ADDR_SEC, &bme280_secondary_handle), TAG_MAIN, "bme280@0x77");
+#endif
+    return ESP_OK;
+}
+
+static esp_err_t boot_oled(void)
+{
+    return i2c_shared_init_ssd1306(&ssd1306_device_handle);
+}
+
+#if !CONFIG_APP_POWER_DEEP_SLEEP
+static esp_err_t boot_net(void)
+{
+#if CONFIG_APP_ASYNC_STARTUP
+    // Network and time come up in the background
+    wifi_start_async();
+    init_sntp_async();
+#else
+    // Blocks this stage only: the sensor and display stages do not wait for the AP
+    wifi_init_sta();
     init_sntp();
+#endif
+    return ESP_OK;
+}
 
-    s_bme_lock = xSemaphoreCreateMutex();
-    configASSERT(s_bme_lock);
+static esp_err_t boot_sensor(void)
+{
+    if (xTaskCreatePinnedToCore(sensor_task, "sensor_task", CONFIG_APP_SENSOR_TASK_STACK, NULL,
+                                CONFIG_APP_SENSOR_TASK_PRIO, &s_sensor_task, CONFIG_APP_CORE_APP) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t boot_render(void)
+{
+    // Every published sample wakes the render loop
+    if (xTaskCreatePinnedToCore(render_task, "render", CONFIG_APP_RENDER_TASK_STACK, NULL,
+                                CONFIG_APP_RENDER_TASK_PRIO, &s_render_task, CONFIG_APP_CORE_APP) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return sensor_snapshot_subscribe(s_render_task, RENDER_NOTIFY_SENSOR);
+}
+
+static esp_err_t boot_services(void)
+{
+    // Batched MQTT uplink; queues in the sample history while the link is down
+    ESP_RETURN_ON_ERROR(telemetry_start(), TAG_MAIN, "telemetry");
+    // Cached JSON / Prometheus documents for scrapers
+    return http_api_start();
+}
+
+static esp_err_t boot_console(void)
+{
+    // `tz` on the serial console; with CONFIG_APP_PERF_STATS also `perf` / `tasks`
+    // (stage timings, I2C traffic, stack usage and CPU load)
+    ESP_RETURN_ON_ERROR(app_console_init(), TAG_MAIN, "console");
+    ESP_RETURN_ON_ERROR(perf_stats_watch_task(s_render_task, "render"), TAG_MAIN, "watch render");
+    ESP_RETURN_ON_ERROR(perf_stats_watch_task(s_sensor_task, "sensor_task"), TAG_MAIN, "watch sensor");
+    ESP_RETURN_ON_ERROR(perf_stats_register_commands(), TAG_MAIN, "perf commands");
+    return app_console_start();
+}
+#endif // !CONFIG_APP_POWER_DEEP_SLEEP
+
+/**
+ * @brief The boot sequence as a dependency graph.
+ *
+ * The I2C bring-up (speed probe, BME280 reset and calibration, SSD1306 init)
+ * runs next to NVS and the Wi-Fi start, and the BME280 and SSD1306 init next
+ * to each other; the sensor and render tasks start as soon as their own
+ * devices are ready, whatever the network is doing. In deep-sleep mode only
+ * the hardware stages run, and deep_sleep_cycle() follows.
+ */
+static const boot_stage_t s_boot_stages[BOOT_STAGE_COUNT] = {
+    [BOOT_POWER]    = { "power",    boot_power,    0 },
+    [BOOT_SETTINGS] = { "settings", boot_settings, DEP(BOOT_POWER) },
+    [BOOT_HISTORY]  = { "history",  boot_history,  DEP(BOOT_POWER) },
+    [BOOT_I2C]      = { "i2c",      boot_i2c,      DEP(BOOT_POWER) },
+    [BOOT_BME280]   = { "bme280",   boot_bme280,   DEP(BOOT_I2C) },
+    [BOOT_OLED]     = { "oled",     boot_oled,     DEP(BOOT_I2C) },
+#if CONFIG_APP_POWER_DEEP_SLEEP
+    [BOOT_NET]      = { "net" },
+    [BOOT_SENSOR]   = { "sensor" },
+    [BOOT_RENDER]   = { "render" },
+    [BOOT_SERVICES] = { "services" },
+    [BOOT_CONSOLE]  = { "console" },
+#else
+    [BOOT_NET]      = { "net",      boot_net,      DEP(BOOT_SETTINGS) },
+    [BOOT_SENSOR]   = { "sensor",   boot_sensor,   DEP(BOOT_BME280) | DEP(BOOT_HISTORY) | DEP(BOOT_SETTINGS) },
+    [BOOT_RENDER]   = { "render",   boot_render,   DEP(BOOT_OLED) | DEP(BOOT_HISTORY) | DEP(BOOT_SETTINGS) },
+    [BOOT_SERVICES] = { "services", boot_services, DEP(BOOT_NET) | DEP(BOOT_HISTORY) },
+    [BOOT_CONSOLE]  = { "console",  boot_console,  DEP(BOOT_SENSOR) | DEP(BOOT_RENDER) },
+#endif
+};
 
-    xTaskCreatePinnedToCore(sensor_task, "sensor_task", 2 * 1024, NULL, 1, NULL, 1);
+/**
+ * @brief Application entry point.
+ *
+ * Runs @ref s_boot_stages through boot_graph_run(): Wi-Fi and SNTP, the I2C
+ * bus with the BME280 and SSD1306, and the @ref sensor_task and
+ * @ref render_task start in dependency order, independent stages in
+ * parallel, and the boot timeline is logged. Both application tasks are
+ * pinned to CONFIG_APP_CORE_APP, away from the radio and network tasks.
+ * Returning lets ESP-IDF delete the main task. The time of the first sample
+ * and of the first frame are logged when they happen (boot_graph_mark()).
+ *
+ * With CONFIG_APP_ASYNC_STARTUP the network comes up in the background;
+ * without it the net stage blocks until connected and synced, which now only
+ * holds up the services that need the network.
+ */
+void app_main(void)
+{
+    ESP_ERROR_CHECK(boot_graph_run(s_boot_stages, BOOT_STAGE_COUNT));
 
-    print_data();
+#if CONFIG_APP_POWER_DEEP_SLEEP
+    deep_sleep_cycle();
+#endif
 }
@@ -0,0 +1,72 @@
+/**
+ * @file panel_care.c
+ * @brief OLED burn-in shift and night dimming through SSD1306 registers.
+ *
+ * @details
+ * Shifting pixels in the framebuffer would dirty every page and push the full
+ * frame each step; dimming by drawing fewer pixels would change the look. The
+ * controller can do both itself: the display start line moves the image, the
+ * contrast register scales the segment current. Each costs a command of a
+ * few bytes when it changes and nothing otherwise.
+ */
+
+#include "panel_care.h"
+
+#if PANEL_CARE_ENABLED
+
+#include "display.h"
+#include "local_time.h"
+#include "sntp.h"
+
+static time_t s_last = -1;  /**< Second last evaluated */
+
+#if CONFIG_APP_PANEL_SHIFT
+/**
+ * @brief Row shift for @p now: a triangle 0, 1, .. N, .. 1, so each step moves the image one row.
+ */
+static uint8_t shift_rows(time_t now)
+{
+    const uint32_t cycle = 2 * CONFIG_APP_PANEL_SHIFT_ROWS;
+    uint32_t step = (uint32_t)((uint64_t)now / CONFIG_APP_PANEL_SHIFT_PERIOD_S) % cycle;
+    return (uint8_t)((step <= CONFIG_APP_PANEL_SHIFT_ROWS) ? step : cycle - step);
+}
+#endif
+
+#if CONFIG_APP_NIGHT_DIM
+static local_time_cache_t s_local;  /**< Own cache: each local_time_cache_t has a single user */
+
+/**
+ * @brief True if local hour @p hour is inside the night window; the window may wrap midnight.
+ */
+static bool is_night(int hour)
+{
+    const int start = CONFIG_APP_NIGHT_START_HOUR;
+    const int end = CONFIG_APP_NIGHT_END_HOUR;
+    return (start <= end) ? (hour >= start && hour < end) : (hour >= start || hour < end);
+}
+#endif
+
+void panel_care_update(time_t now)
+{
+    if (now == s_last) {
+        return;
+    }
+    s_last = now;
+
+    // Failures are retried on the next second: the cached state only advances on success
+#if CONFIG_APP_PANEL_SHIFT
+    (void)display_set_row_shift(shift_rows(now));
+#endif
+
+#if CONFIG_APP_NIGHT_DIM
+    uint8_t level = CONFIG_APP_DAY_CONTRAST;
+    if (sntp_time_is_valid()) {
+        if (is_night(local_time_get(&s_local, now)->tm_hour)) {
+            level = CONFIG_APP_NIGHT_CONTRAST;
+        }
+    }
+    (void)display_set_contrast(level);
+#endif
+}
+
+#endif // PANEL_CARE_ENABLED
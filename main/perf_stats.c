@@ -0,0 +1,335 @@
+/**
+ * @file perf_stats.c
+ * @brief Latency histograms, I2C traffic and stack usage for the render and sensor pipeline.
+ *
+ * @details
+ * Each stage keeps count/min/max/sum and a log2 histogram of its latency in
+ * microseconds, measured with esp_timer_get_time(). Recording is a handful of
+ * integer operations inside a short critical section, so it can stay enabled
+ * on real hardware while measuring a change.
+ *
+ * Bus traffic comes from the I2C scheduler's counters (i2c_sched_get_stats()),
+ * which see every transaction on the shared bus. Stack high-water marks are
+ * read on demand for the tasks registered with perf_stats_watch_task().
+ *
+ * The numbers are dumped by the `perf` console command, which
+ * perf_stats_register_commands() adds to the app_console.h REPL.
+ *
+ * The `tasks` command reads the FreeRTOS run-time counters of every task
+ * (uxTaskGetSystemState()) and reports each task's share of a core since the
+ * previous `tasks` call, and the load per core from its idle task.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_APP_PERF_STATS
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "i2c_sched.h"
+#include "local_time.h"
+#include "perf_stats.h"
+#include "sensor_registry.h"
+#include "sample_rate.h"
+#include "boot_graph.h"
+#include "telemetry.h"
+
+static const char *TAG_PERF = "PERF";
+
+/**
+ * @brief Accumulated latency of one stage.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t hist[PERF_HIST_BUCKETS];
+} perf_stage_stats_t;
+
+typedef struct {
+    TaskHandle_t task;
+    const char *name;
+} perf_task_t;
+
+static const char *const stage_names[PERF_STAGE_COUNT] = {
+    [PERF_STAGE_FRAME]  = "frame",
+    [PERF_STAGE_FLUSH]  = "flush",
+    [PERF_STAGE_SENSOR] = "sensor",
+};
+
+static perf_stage_stats_t s_stages[PERF_STAGE_COUNT];
+static portMUX_TYPE s_stages_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static perf_task_t s_tasks[PERF_MAX_TASKS];
+static size_t s_task_count;
+
+/** Run-time counters at the previous `tasks` call, to report deltas */
+typedef struct {
+    TaskHandle_t task;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} perf_runtime_t;
+
+static TaskStatus_t s_status[PERF_MAX_SYSTEM_TASKS];
+static perf_runtime_t s_prev_runtime[PERF_MAX_SYSTEM_TASKS];
+static size_t s_prev_count;
+static configRUN_TIME_COUNTER_TYPE s_prev_total;
+
+/**
+ * @brief Histogram bucket for @p us: 0 for 0 us, otherwise 1 + floor(log2(us)), clamped.
+ */
+static inline unsigned bucket_of(uint32_t us)
+{
+    unsigned bucket = (us == 0) ? 0 : (unsigned)(32 - __builtin_clz(us));
+    return (bucket < PERF_HIST_BUCKETS) ? bucket : PERF_HIST_BUCKETS - 1;
+}
+
+/**
+ * @brief Upper bound of the bucket holding the @p permille-th sample, in us.
+ */
+static uint32_t percentile_us(const perf_stage_stats_t *st, uint32_t permille)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)st->count * permille + 999) / 1000);
+    uint32_t seen = 0;
+    for (unsigned b = 0; b < PERF_HIST_BUCKETS; ++b) {
+        seen += st->hist[b];
+        if (seen >= rank) {
+            return (b == 0) ? 0 : (b == PERF_HIST_BUCKETS - 1) ? st->max_us : (1u << b) - 1;
+        }
+    }
+    return st->max_us;
+}
+
+void perf_stats_end(perf_stage_t stage, int64_t start_us)
+{
+    if (stage >= PERF_STAGE_COUNT) return;
+
+    int64_t elapsed = esp_timer_get_time() - start_us;
+    uint32_t us = (elapsed < 0) ? 0 : (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed;
+
+    perf_stage_stats_t *st = &s_stages[stage];
+    portENTER_CRITICAL(&s_stages_mux);
+    if (st->count == 0 || us < st->min_us) st->min_us = us;
+    if (us > st->max_us) st->max_us = us;
+    st->count++;
+    st->sum_us += us;
+    st->hist[bucket_of(us)]++;
+    portEXIT_CRITICAL(&s_stages_mux);
+}
+
+esp_err_t perf_stats_watch_task(TaskHandle_t task, const char *name)
+{
+    ESP_RETURN_ON_FALSE(task && name, ESP_ERR_INVALID_ARG, TAG_PERF, "invalid args");
+    ESP_RETURN_ON_FALSE(s_task_count < PERF_MAX_TASKS, ESP_ERR_NO_MEM, TAG_PERF, "too many tasks");
+
+    s_tasks[s_task_count].task = task;
+    s_tasks[s_task_count].name = name;
+    s_task_count++;
+    return ESP_OK;
+}
+
+void perf_stats_get(perf_stage_t stage, perf_stage_summary_t *out)
+{
+    *out = (perf_stage_summary_t){0};
+    if (stage >= PERF_STAGE_COUNT) return;
+
+    perf_stage_stats_t st;
+    portENTER_CRITICAL(&s_stages_mux);
+    st = s_stages[stage];
+    portEXIT_CRITICAL(&s_stages_mux);
+
+    out->count = st.count;
+    out->min_us = st.min_us;
+    out->max_us = st.max_us;
+    out->sum_us = st.sum_us;
+    out->p50_us = percentile_us(&st, 500);
+    out->p99_us = percentile_us(&st, 990);
+}
+
+const char *perf_stats_stage_name(perf_stage_t stage)
+{
+    return (stage < PERF_STAGE_COUNT) ? stage_names[stage] : "";
+}
+
+void perf_stats_dump(void)
+{
+    perf_stage_stats_t snap[PERF_STAGE_COUNT];
+    portENTER_CRITICAL(&s_stages_mux);
+    memcpy(snap, s_stages, sizeof(snap));
+    portEXIT_CRITICAL(&s_stages_mux);
+
+    printf("%-7s %8s %8s %8s %8s %8s %8s\n", "stage", "count", "min_us", "avg_us", "p50_us", "p99_us", "max_us");
+    for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+        const perf_stage_stats_t *st = &snap[i];
+        uint32_t avg = st->count ? (uint32_t)(st->sum_us / st->count) : 0;
+        printf("%-7s %8lu %8lu %8lu %8lu %8lu %8lu\n", stage_names[i], (unsigned long)st->count,
+               (unsigned long)st->min_us, (unsigned long)avg, (unsigned long)percentile_us(st, 500),
+               (unsigned long)percentile_us(st, 990), (unsigned long)st->max_us);
+    }
+
+    // Non-empty buckets only, as "<upper bound us>:count"
+    for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+        printf("%s hist:", stage_names[i]);
+        for (unsigned b = 0; b < PERF_HIST_BUCKETS; ++b) {
+            if (!snap[i].hist[b]) continue;
+            if (b == PERF_HIST_BUCKETS - 1) {
+                printf(" >=%lu:%lu", (unsigned long)(1u << (b - 1)), (unsigned long)snap[i].hist[b]);
+            } else {
+                printf(" <%lu:%lu", (unsigned long)(1u << b), (unsigned long)snap[i].hist[b]);
+            }
+        }
+        printf("\n");
+    }
+
+    i2c_sched_stats_t bus;
+    i2c_sched_get_stats(&bus);
+    printf("i2c: %lu txn, %lu B tx, %lu B rx, %lu merged, %lu errors\n",
+           (unsigned long)bus.transactions, (unsigned long)bus.tx_bytes, (unsigned long)bus.rx_bytes,
+           (unsigned long)bus.merged_ops, (unsigned long)bus.errors);
+    printf("i2c recovery: %lu retries, %lu bus resets, %lu recovered, %lu probe failures, %lu offline skips\n",
+           (unsigned long)bus.retries, (unsigned long)bus.bus_resets, (unsigned long)bus.recoveries,
+           (unsigned long)bus.probe_failures, (unsigned long)bus.offline_skips);
+
+    printf("boot: stages done %lu ms, first sample %lu ms, first frame %lu ms\n",
+           (unsigned long)(boot_graph_done_us() / 1000),
+           (unsigned long)(boot_graph_milestone_us(BOOT_MILESTONE_FIRST_SAMPLE) / 1000),
+           (unsigned long)(boot_graph_milestone_us(BOOT_MILESTONE_FIRST_FRAME) / 1000));
+
+    local_time_stats_t clock;
+    local_time_get_stats(&clock);
+    printf("clock: %lu local time conversions, %lu DST searches, %lu tz changes\n",
+           (unsigned long)clock.conversions, (unsigned long)clock.searches, (unsigned long)clock.tz_changes);
+
+    sensor_registry_stats_t sensors;
+    sensor_registry_get_stats(&sensors);
+    printf("sensors: %u registered, %lu rounds, %lu batch retries, %lu misses, %lu re-inits\n",
+           (unsigned)sensor_registry_count(), (unsigned long)sensors.rounds, (unsigned long)sensors.batch_retries,
+           (unsigned long)sensors.misses, (unsigned long)sensors.reinits);
+#if CONFIG_APP_SENSOR_ADAPTIVE
+    sample_rate_stats_t rate;
+    sample_rate_get_stats(&rate);
+    printf("sampling: period %lu ms, %lu speed-ups, %lu back-offs\n",
+           (unsigned long)rate.period_ms, (unsigned long)rate.speedups, (unsigned long)rate.backoffs);
+#endif
+
+#if CONFIG_APP_MQTT_TELEMETRY
+    telemetry_stats_t mqtt;
+    telemetry_get_stats(&mqtt);
+    printf("mqtt: %lu batches, %lu samples, %lu dropped\n",
+           (unsigned long)mqtt.batches, (unsigned long)mqtt.samples, (unsigned long)mqtt.dropped);
+#endif
+
+    for (size_t i = 0; i < s_task_count; ++i) {
+        printf("stack %-12s %5lu B free (min)\n", s_tasks[i].name,
+               (unsigned long)uxTaskGetStackHighWaterMark(s_tasks[i].task));
+    }
+}
+
+static configRUN_TIME_COUNTER_TYPE previous_runtime(TaskHandle_t task)
+{
+    for (size_t i = 0; i < s_prev_count; ++i) {
+        if (s_prev_runtime[i].task == task) return s_prev_runtime[i].runtime;
+    }
+    return 0;   // new task: everything it ran counts towards this window
+}
+
+/** @p part / @p whole in tenths of a percent */
+static inline unsigned permille(uint64_t part, uint64_t whole)
+{
+    return whole ? (unsigned)((part * 1000 + whole / 2) / whole) : 0;
+}
+
+void perf_stats_dump_tasks(void)
+{
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = uxTaskGetSystemState(s_status, PERF_MAX_SYSTEM_TASKS, &total);
+    if (count == 0) {
+        printf("more than %d tasks, raise PERF_MAX_SYSTEM_TASKS\n", PERF_MAX_SYSTEM_TASKS);
+        return;
+    }
+
+    // The run-time clock counts wall time, which each core has the full amount of
+    uint64_t window = total - s_prev_total;
+    uint64_t idle[portNUM_PROCESSORS] = {0};
+
+    printf("%-16s %4s %4s %7s %8s\n", "task", "core", "prio", "cpu%", "stack_B");
+    for (UBaseType_t i = 0; i < count; ++i) {
+        const TaskStatus_t *st = &s_status[i];
+        uint64_t ran = st->ulRunTimeCounter - previous_runtime(st->xHandle);
+        BaseType_t core = xTaskGetCoreID(st->xHandle);
+        unsigned share = permille(ran, window);
+
+        if (core >= 0 && core < portNUM_PROCESSORS && st->xHandle == xTaskGetIdleTaskHandleForCore(core)) {
+            idle[core] = ran;
+        }
+        printf("%-16s %4s %4u %5u.%u %8lu\n", st->pcTaskName,
+               (core == tskNO_AFFINITY) ? "-" : (core == 0) ? "0" : "1", (unsigned)st->uxCurrentPriority,
+               share / 10, share % 10, (unsigned long)st->usStackHighWaterMark);
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; ++core) {
+        unsigned busy = 1000 - permille(idle[core] < window ? idle[core] : window, window);
+        printf("core %d: %u.%u%% busy\n", core, busy / 10, busy % 10);
+    }
+    printf("window: %llu ms\n", (unsigned long long)(window / 1000));
+
+    for (UBaseType_t i = 0; i < count; ++i) {
+        s_prev_runtime[i] = (perf_runtime_t){ .task = s_status[i].xHandle, .runtime = s_status[i].ulRunTimeCounter };
+    }
+    s_prev_count = count;
+    s_prev_total = total;
+}
+
+void perf_stats_reset(void)
+{
+    portENTER_CRITICAL(&s_stages_mux);
+    memset(s_stages, 0, sizeof(s_stages));
+    portEXIT_CRITICAL(&s_stages_mux);
+    i2c_sched_reset_stats();
+}
+
+static int perf_cmd(int argc, char **argv)
+{
+    if (argc == 1) {
+        perf_stats_dump();
+        return 0;
+    }
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        perf_stats_reset();
+        return 0;
+    }
+    printf("usage: perf [reset]\n");
+    return 1;
+}
+
+static int tasks_cmd_handler(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    perf_stats_dump_tasks();
+    return 0;
+}
+
+esp_err_t perf_stats_register_commands(void)
+{
+    const esp_console_cmd_t cmd = {
+        .command = "perf",
+        .help = "Print stage latency, I2C traffic and stack usage; 'perf reset' clears them",
+        .hint = "[reset]",
+        .func = perf_cmd,
+    };
+    ESP_RETURN_ON_ERROR(esp_console_cmd_register(&cmd), TAG_PERF, "register");
+
+    const esp_console_cmd_t tasks_cmd = {
+        .command = "tasks",
+        .help = "CPU share per task and load per core since the previous 'tasks'",
+        .func = tasks_cmd_handler,
+    };
+    ESP_RETURN_ON_ERROR(esp_console_cmd_register(&tasks_cmd), TAG_PERF, "register tasks");
+    return ESP_OK;
+}
+
+#endif // CONFIG_APP_PERF_STATS
@@ -0,0 +1,98 @@
+/**
+ * @file power.c
+ * @brief Power modes (DFS + automatic light sleep, deep sleep) and RTC-retained state.
+ *
+ * @details
+ * Light sleep: esp_pm lets the CPU drop to CONFIG_APP_PM_MIN_FREQ_MHZ and the
+ * chip light-sleep between the second-edge timer and the sensor period. The
+ * application code is unchanged; esp_timer and FreeRTOS delays wake the chip.
+ *
+ * Deep sleep: the application runs once per wake-up and sleeps again. What must
+ * survive (the last sample) lives in RTC slow memory, which the bootloader
+ * preserves across deep sleep and reinitializes on every other reset. The
+ * system clock itself keeps running on the RTC timer; when it needs a resync
+ * is decided by sntp_resync_due() from the drift measured at each sync.
+ */
+
+#include <string.h>
+#include <sys/time.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+
+#include "power.h"
+
+static const char *TAG_POWER = "POWER";
+
+/**
+ * @brief State kept in RTC slow memory across deep sleep.
+ */
+typedef struct {
+    uint32_t boot_count;
+    bool has_sample;
+    struct bme280_data sample;  /**< Last published sample */
+} power_rtc_state_t;
+
+RTC_DATA_ATTR static power_rtc_state_t s_rtc;
+
+esp_err_t power_init(void)
+{
+    s_rtc.boot_count++;
+
+#if CONFIG_APP_POWER_LIGHT_SLEEP
+    const esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_APP_PM_MIN_FREQ_MHZ,
+        .light_sleep_enable = true,
+    };
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG_POWER, "esp_pm_configure: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG_POWER, "DFS %d..%d MHz, automatic light sleep", CONFIG_APP_PM_MIN_FREQ_MHZ,
+             CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+#endif
+
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER) {
+        ESP_LOGI(TAG_POWER, "Woke from deep sleep (boot %lu)", (unsigned long)s_rtc.boot_count);
+    }
+    return ESP_OK;
+}
+
+uint32_t power_rtc_boot_count(void)
+{
+    return s_rtc.boot_count;
+}
+
+void power_rtc_store_sample(const struct bme280_data *data)
+{
+    s_rtc.sample = *data;
+    s_rtc.has_sample = true;
+}
+
+bool power_rtc_load_sample(struct bme280_data *out)
+{
+    if (!s_rtc.has_sample) {
+        memset(out, 0, sizeof(*out));
+        return false;
+    }
+    *out = s_rtc.sample;
+    return true;
+}
+
+void power_deep_sleep_aligned(uint32_t interval_s)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    uint64_t period_us = (uint64_t)interval_s * 1000000ULL;
+    uint64_t now_us = (uint64_t)tv.tv_sec * 1000000ULL + (uint64_t)tv.tv_usec;
+    uint64_t sleep_us = period_us - (now_us % period_us) + POWER_WAKE_GUARD_US;
+
+    ESP_LOGI(TAG_POWER, "Deep sleep for %llu ms", (unsigned long long)(sleep_us / 1000));
+    esp_sleep_enable_timer_wakeup(sleep_us);
+    esp_deep_sleep_start();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file sample_rate.c
+ * @brief Exponential back-off of the sensor sampling period while readings are stable.
+ *
+ * @details
+ * A fixed period is either too slow to follow a door opening outdoors or
+ * wastes bus traffic and wake-ups on a stable indoor install. sample_rate_t
+ * snaps back to the fastest period on any significant change and doubles the
+ * period only on calm samples, so a real change is noticed within one slow
+ * period and then followed at full rate.
+ *
+ * Deltas are measured from the reference sample, not from the previous one,
+ * so a slow drift that never exceeds the threshold per sample still triggers
+ * once it adds up.
+ */
+
+#include "sample_rate.h"
+
+#if CONFIG_APP_SENSOR_ADAPTIVE
+
+#include <stdlib.h>
+
+/** Only the sensor task writes them */
+static sample_rate_stats_t s_stats;
+
+/**
+ * @brief True if @p s moved far enough from @p ref to sample at the fastest rate.
+ */
+static bool is_significant(const sensor_sample_t *ref, const sensor_sample_t *s)
+{
+    return abs((int)s->temperature_c100 - (int)ref->temperature_c100) >= CONFIG_APP_SENSOR_ADAPTIVE_TEMP_DELTA_C100 ||
+           abs((int)s->humidity_c100 - (int)ref->humidity_c100) >= CONFIG_APP_SENSOR_ADAPTIVE_HUM_DELTA_C100 ||
+           labs((long)s->pressure_pa - (long)ref->pressure_pa) >= CONFIG_APP_SENSOR_ADAPTIVE_PRES_DELTA_PA;
+}
+
+void sample_rate_init(sample_rate_t *rate, uint32_t min_ms, uint32_t max_ms)
+{
+    if (min_ms == 0) {
+        min_ms = 1;
+    }
+    *rate = (sample_rate_t){
+        .min_ms = min_ms,
+        .max_ms = (max_ms < min_ms) ? min_ms : max_ms,
+        .period_ms = min_ms,
+    };
+    s_stats.period_ms = min_ms;
+}
+
+uint32_t sample_rate_update(sample_rate_t *rate, const sensor_sample_t *sample)
+{
+    if (!sample) {
+        return rate->period_ms;
+    }
+
+    if (!rate->have_ref || is_significant(&rate->ref, sample)) {
+        if (rate->have_ref) {
+            s_stats.speedups += (rate->period_ms != rate->min_ms);
+        }
+        rate->ref = *sample;
+        rate->have_ref = true;
+        rate->period_ms = rate->min_ms;
+    } else if (rate->period_ms < rate->max_ms) {
+        rate->period_ms = (rate->period_ms > rate->max_ms / 2) ? rate->max_ms : rate->period_ms * 2;
+        s_stats.backoffs++;
+    }
+
+    s_stats.period_ms = rate->period_ms;
+    return rate->period_ms;
+}
+
+void sample_rate_get_stats(sample_rate_stats_t *out)
+{
+    if (!out) return;
+    *out = s_stats;
+}
+
+#endif // CONFIG_APP_SENSOR_ADAPTIVE
@@ -0,0 +1,31 @@
+/**
+ * @file screen_layout.c
+ * @brief Compile-time layout of the text screen, one table per panel height.
+ */
+
+#include "screen_layout.h"
+
+#if DISPLAY_HEIGHT >= 64
+
+const display_field_layout_t text_screen_layout[TEXT_FIELD_COUNT] = {
+    [TEXT_FIELD_TIME]        = DISPLAY_FIELD_LAYOUT((PIXELS_PER_PAGE * 1) - 4, "",      8, DISPLAY_ALIGN_CENTER, ""),
+    [TEXT_FIELD_DATE]        = DISPLAY_FIELD_LAYOUT((PIXELS_PER_PAGE * 2),     "",     13, DISPLAY_ALIGN_CENTER, ""),
+    [TEXT_FIELD_HUMIDITY]    = DISPLAY_FIELD_LAYOUT((PIXELS_PER_PAGE * 4) - 4, "Hum-",  5, DISPLAY_ALIGN_RIGHT,  "%"),
+    [TEXT_FIELD_TEMPERATURE] = DISPLAY_FIELD_LAYOUT((PIXELS_PER_PAGE * 5) - 2, "Temp-", 5, DISPLAY_ALIGN_RIGHT,  "C"),
+    [TEXT_FIELD_PRESSURE]    = DISPLAY_FIELD_LAYOUT((PIXELS_PER_PAGE * 6),     "Pres-", 7, DISPLAY_ALIGN_RIGHT,  "hPa"),
+};
+
+#else
+
+// Page-aligned rows: every field update touches a single page
+const display_field_layout_t text_screen_layout[TEXT_FIELD_COUNT] = {
+    [TEXT_FIELD_TIME]        = DISPLAY_FIELD_LAYOUT(PIXELS_PER_PAGE * 0, "",      8, DISPLAY_ALIGN_CENTER, ""),
+    [TEXT_FIELD_DATE]        = DISPLAY_FIELD_ABSENT,
+    [TEXT_FIELD_HUMIDITY]    = DISPLAY_FIELD_LAYOUT(PIXELS_PER_PAGE * 1, "Hum-",  5, DISPLAY_ALIGN_RIGHT,  "%"),
+    [TEXT_FIELD_TEMPERATURE] = DISPLAY_FIELD_LAYOUT(PIXELS_PER_PAGE * 2, "Temp-", 5, DISPLAY_ALIGN_RIGHT,  "C"),
+    [TEXT_FIELD_PRESSURE]    = DISPLAY_FIELD_LAYOUT(PIXELS_PER_PAGE * 3, "Pres-", 7, DISPLAY_ALIGN_RIGHT,  "hPa"),
+};
+
+#endif
+
+_Static_assert(DISPLAY_HEIGHT == 64 || DISPLAY_HEIGHT == 32, "no text layout for this panel height");
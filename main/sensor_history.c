@@ -0,0 +1,219 @@
+/**
+ * @file sensor_history.c
+ * @brief Fixed-size in-RAM time series of BME280 samples.
+ *
+ * @details
+ * A statically allocated ring of @ref SENSOR_HISTORY_LEN compact samples.
+ * Appending is O(1); queries walk the requested window backwards from the
+ * newest sample and stop at the first one that is too old. A short mutex
+ * section guards the ring, so a reader never sees a half-written sample
+ * and the sensor task is held up for at most one query.
+ *
+ * With CONFIG_APP_HISTORY_SPILL, a decimated copy of the series is appended to
+ * the flash log (history_log.h) for history beyond the RAM window.
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_check.h"
+#include "esp_log.h"
+
+#include "bme280_units.h"
+#include "history_log.h"
+#include "sensor_history.h"
+
+static const char *TAG_HIST = "HISTORY";
+
+static sensor_sample_t s_ring[SENSOR_HISTORY_LEN];
+static size_t s_head;                   /**< Next slot to write */
+static size_t s_count;                  /**< Valid samples, up to SENSOR_HISTORY_LEN */
+static uint32_t s_total;                /**< Samples appended since boot (wraps) */
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+
+#if CONFIG_APP_HISTORY_SPILL
+static bool s_spill_ready;
+static uint32_t s_spill_countdown;
+#endif
+
+/** Index of the @p age-th newest sample (0 = newest); caller holds the lock */
+static inline size_t ring_index(size_t age)
+{
+    return (s_head + SENSOR_HISTORY_LEN - 1 - age) % SENSOR_HISTORY_LEN;
+}
+
+static inline int32_t clamp_i32(int32_t v, int32_t lo, int32_t hi)
+{
+    return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+
+esp_err_t sensor_history_init(void)
+{
+    s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    ESP_RETURN_ON_FALSE(s_lock, ESP_ERR_NO_MEM, TAG_HIST, "lock");
+
+#if CONFIG_APP_HISTORY_SPILL
+    esp_err_t err = history_log_init();
+    if (err == ESP_OK) {
+        s_spill_ready = true;
+        ESP_LOGI(TAG_HIST, "Spilling every %d samples, flash holds %u", CONFIG_APP_HISTORY_SPILL_EVERY,
+                 (unsigned)history_log_capacity());
+    } else {
+        ESP_LOGW(TAG_HIST, "No flash log (%s), RAM history only", esp_err_to_name(err));
+    }
+#endif
+    return ESP_OK;
+}
+
+sensor_sample_t sensor_sample_from_bme280(const struct bme280_data *data, uint32_t timestamp)
+{
+    sensor_sample_t s = {
+        .timestamp = timestamp,
+        .temperature_c100 = (int16_t)clamp_i32(bme280_temperature_c100(data), INT16_MIN, INT16_MAX),
+        .humidity_c100 = (uint16_t)((bme280_humidity_c100(data) > UINT16_MAX) ? UINT16_MAX : bme280_humidity_c100(data)),
+        .pressure_pa = bme280_pressure_pa(data),
+    };
+    return s;
+}
+
+void sensor_history_append(const sensor_sample_t *sample)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_ring[s_head] = *sample;
+    s_head = (s_head + 1) % SENSOR_HISTORY_LEN;
+    if (s_count < SENSOR_HISTORY_LEN) s_count++;
+    s_total++;
+    xSemaphoreGive(s_lock);
+
+#if CONFIG_APP_HISTORY_SPILL
+    // Flash write outside the lock: it stalls the cache for a moment, readers need not wait for it
+    if (s_spill_ready && sensor_sample_dated(sample) && s_spill_countdown-- == 0) {
+        s_spill_countdown = CONFIG_APP_HISTORY_SPILL_EVERY - 1;
+        esp_err_t err = history_log_append(sample);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG_HIST, "Spill failed: %s", esp_err_to_name(err));
+        }
+    }
+#endif
+}
+
+size_t sensor_history_count(void)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    size_t count = s_count;
+    xSemaphoreGive(s_lock);
+    return count;
+}
+
+uint32_t sensor_history_total(void)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    uint32_t total = s_total;
+    xSemaphoreGive(s_lock);
+    return total;
+}
+
+bool sensor_history_mean(uint32_t end, size_t count, sensor_sample_t *out)
+{
+    if (!out || count == 0) return false;
+
+    int64_t temperature_sum = 0, humidity_sum = 0, pressure_sum = 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    uint32_t newest_age = s_total - end;
+    bool held = newest_age <= s_count && count <= s_count - newest_age;
+    if (held) {
+        out->timestamp = s_ring[ring_index(newest_age)].timestamp;
+        for (size_t age = newest_age; age < newest_age + count; ++age) {
+            const sensor_sample_t *s = &s_ring[ring_index(age)];
+            temperature_sum += s->temperature_c100;
+            humidity_sum += s->humidity_c100;
+            pressure_sum += s->pressure_pa;
+        }
+    }
+    xSemaphoreGive(s_lock);
+
+    if (!held) return false;
+    out->temperature_c100 = (int16_t)(temperature_sum / (int64_t)count);
+    out->humidity_c100 = (uint16_t)(humidity_sum / (int64_t)count);
+    out->pressure_pa = (uint32_t)(pressure_sum / (int64_t)count);
+    return true;
+}
+
+size_t sensor_history_read(uint32_t *from, sensor_sample_t *out, size_t max)
+{
+    if (!from || !out) return 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    uint32_t oldest = s_total - (uint32_t)s_count;
+    if ((int32_t)(*from - oldest) < 0) {
+        *from = oldest;     // the caller fell behind; the skipped samples are gone
+    }
+    size_t n = ((int32_t)(s_total - *from) > 0) ? s_total - *from : 0;
+    if (n > max) n = max;
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = s_ring[ring_index(s_total - 1 - *from - i)];
+    }
+    xSemaphoreGive(s_lock);
+    return n;
+}
+
+size_t sensor_history_copy(sensor_sample_t *out, size_t max, uint32_t since)
+{
+    if (!out || max == 0) return 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    size_t n = 0;
+    while (n < s_count && n < max && sensor_sample_dated(&s_ring[ring_index(n)]) &&
+           s_ring[ring_index(n)].timestamp >= since) {
+        n++;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = s_ring[ring_index(n - 1 - i)];
+    }
+    xSemaphoreGive(s_lock);
+    return n;
+}
+
+bool sensor_history_stats(uint32_t now, uint32_t window_s, sensor_history_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    uint32_t since = (now > window_s) ? now - window_s : 0;
+
+    int64_t temperature_sum = 0, humidity_sum = 0, pressure_sum = 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (size_t age = 0; age < s_count; ++age) {
+        const sensor_sample_t *s = &s_ring[ring_index(age)];
+        if (s->timestamp < since || !sensor_sample_dated(s)) break;
+        if (s->timestamp > now) continue;
+
+        if (out->count == 0) {
+            out->last_timestamp = s->timestamp;
+            out->temperature_min = out->temperature_max = s->temperature_c100;
+            out->humidity_min = out->humidity_max = s->humidity_c100;
+            out->pressure_min = out->pressure_max = s->pressure_pa;
+        }
+        out->first_timestamp = s->timestamp;
+        if (s->temperature_c100 < out->temperature_min) out->temperature_min = s->temperature_c100;
+        if (s->temperature_c100 > out->temperature_max) out->temperature_max = s->temperature_c100;
+        if (s->humidity_c100 < out->humidity_min) out->humidity_min = s->humidity_c100;
+        if (s->humidity_c100 > out->humidity_max) out->humidity_max = s->humidity_c100;
+        if (s->pressure_pa < out->pressure_min) out->pressure_min = s->pressure_pa;
+        if (s->pressure_pa > out->pressure_max) out->pressure_max = s->pressure_pa;
+        temperature_sum += s->temperature_c100;
+        humidity_sum += s->humidity_c100;
+        pressure_sum += s->pressure_pa;
+        out->count++;
+    }
+    xSemaphoreGive(s_lock);
+
+    if (out->count == 0) return false;
+    out->temperature_mean = (int16_t)(temperature_sum / out->count);
+    out->humidity_mean = (uint16_t)(humidity_sum / out->count);
+    out->pressure_mean = (uint32_t)(pressure_sum / out->count);
+    return true;
+}
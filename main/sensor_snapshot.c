@@ -0,0 +1,100 @@
+/**
+ * @file sensor_snapshot.c
+ * @brief Single-writer / multi-reader seqlock for the latest BME280 sample.
+ *
+ * @details
+ * Replaces the FreeRTOS mutex that used to guard the shared bme280_data.
+ * The writer bumps a sequence counter to an odd value, copies the sample and
+ * bumps it back to even. Readers copy the sample and retry if the counter was
+ * odd or changed meanwhile, so they never block and never stall the writer.
+ *
+ * The copy runs inside a critical section private to the writer. That keeps a
+ * reader on the same core from preempting a half-written sample (and spinning
+ * against a writer that cannot run); a reader on the other core retries for at
+ * most the few hundred nanoseconds the copy takes.
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "esp_timer.h"
+
+#include "sensor_snapshot.h"
+
+static sensor_snapshot_t s_snapshot;
+static atomic_uint s_seq;                       /**< 2 * samples published, odd while writing */
+static portMUX_TYPE s_publish_mux = portMUX_INITIALIZER_UNLOCKED;
+
+typedef struct {
+    TaskHandle_t task;
+    uint32_t bits;
+} subscriber_t;
+
+static subscriber_t s_subscribers[SENSOR_SNAPSHOT_MAX_SUBSCRIBERS];
+static atomic_uint s_subscriber_count;
+static portMUX_TYPE s_subscribe_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void sensor_snapshot_publish(const struct bme280_data *data)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_publish_mux);
+    unsigned seq = atomic_load_explicit(&s_seq, memory_order_relaxed);
+    atomic_store_explicit(&s_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    s_snapshot.data = *data;
+    s_snapshot.captured_us = now_us;
+    s_snapshot.seq = (seq + 2) / 2;
+
+    atomic_store_explicit(&s_seq, seq + 2, memory_order_release);
+    portEXIT_CRITICAL(&s_publish_mux);
+
+    unsigned count = atomic_load_explicit(&s_subscriber_count, memory_order_acquire);
+    for (unsigned i = 0; i < count; ++i) {
+        xTaskNotify(s_subscribers[i].task, s_subscribers[i].bits, eSetBits);
+    }
+}
+
+bool sensor_snapshot_read(sensor_snapshot_t *out)
+{
+    unsigned begin;
+    unsigned end;
+
+    do {
+        begin = atomic_load_explicit(&s_seq, memory_order_acquire);
+        *out = s_snapshot;
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&s_seq, memory_order_relaxed);
+    } while ((begin & 1u) || begin != end);
+
+    if (begin == 0) {
+        memset(out, 0, sizeof(*out));
+        return false;
+    }
+    return true;
+}
+
+uint32_t sensor_snapshot_seq(void)
+{
+    return atomic_load_explicit(&s_seq, memory_order_acquire) / 2;
+}
+
+esp_err_t sensor_snapshot_subscribe(TaskHandle_t task, uint32_t notify_bits)
+{
+    if (!task) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_OK;
+    portENTER_CRITICAL(&s_subscribe_mux);
+    unsigned count = atomic_load_explicit(&s_subscriber_count, memory_order_relaxed);
+    if (count < SENSOR_SNAPSHOT_MAX_SUBSCRIBERS) {
+        s_subscribers[count] = (subscriber_t){ .task = task, .bits = notify_bits };
+        atomic_store_explicit(&s_subscriber_count, count + 1, memory_order_release);
+    } else {
+        err = ESP_ERR_NO_MEM;
+    }
+    portEXIT_CRITICAL(&s_subscribe_mux);
+    return err;
+}
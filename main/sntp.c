@@ -1,58 +1,247 @@
+/**
+ * @file sntp.c
+ * @brief SNTP client with persisted sync state and a drift-driven resync schedule.
+ *
+ * @details
+ * The time of the last sync and an estimate of the local clock drift are kept
+ * in NVS. The RTC timer keeps counting across soft resets and deep sleep, so at
+ * boot the clock can be trusted as long as the estimated error since the last
+ * sync (|drift| x elapsed) is below CONFIG_APP_SNTP_MAX_ERROR_MS. In that case
+ * SNTP is not started until that budget runs out, and nothing waits for it.
+ *
+ * Every sync goes through sntp_sync_time(), overridden here: before stepping
+ * the clock it compares the server time with the local time, which yields the
+ * drift over the interval since the previous sync. The next resync interval
+ * is then chosen so the expected error just reaches the budget.
+ *
+ * Servers: up to three static hosts from Kconfig plus, with
+ * CONFIG_APP_SNTP_DHCP_SERVERS, the one offered by DHCP (slot 0).
+ */
+
+#include <stdlib.h>
+#include <sys/time.h>
+
 #include "esp_sntp.h"
 #include "esp_netif_sntp.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "sdkconfig.h"
 
+#include "local_time.h"
 #include "sntp.h"
 #include "wifi.h"
 
+#define SNTP_NVS_NAMESPACE          "time"
+#define SNTP_NVS_KEY_LAST_SYNC      "last_sync"     /**< i64: epoch seconds of the last sync */
+#define SNTP_NVS_KEY_DRIFT          "drift_ppb"     /**< i32: estimated drift, positive = local clock fast */
+#define SNTP_DRIFT_MIN_INTERVAL_S   60              /**< Shorter intervals give too noisy a drift estimate */
+#define SNTP_DRIFT_WEIGHT           4               /**< EWMA: new estimate counts 1/SNTP_DRIFT_WEIGHT */
+#define SNTP_PLAUSIBLE_EPOCH        1483228800      /**< 2017-01-01 00:00 UTC */
+
+#if CONFIG_APP_SNTP_DHCP_SERVERS
+#define SNTP_FIRST_STATIC_SERVER    1               /**< Slot 0 is the DHCP-provided server */
+#else
+#define SNTP_FIRST_STATIC_SERVER    0
+#endif
+
+#if CONFIG_LWIP_SNTP_MAX_SERVERS < SNTP_FIRST_STATIC_SERVER + 3
+#error "CONFIG_LWIP_SNTP_MAX_SERVERS too small for the configured SNTP servers"
+#endif
+
 static const char *TAG_SNTP = "SNTP";
 static const char *TAG_GETT = "GET_TIME";
 
-static const char *EUROPE_ROMANIA_BUCHAREST = "EET-2EEST,M3.5.0/3,M10.5.0/4";
+static bool s_state_loaded;
+static int64_t s_last_sync;             /**< Epoch seconds of the last sync, 0 = never */
+static int32_t s_drift_ppb;             /**< Valid if @ref s_drift_known */
+static bool s_drift_known;
+static esp_timer_handle_t s_resync_timer;
+
+/**
+ * @brief Whether @p t is past 2016; a plain comparison, as render_clock() asks every second until the first sync.
+ */
+static bool clock_is_plausible(time_t t)
+{
+    return t >= SNTP_PLAUSIBLE_EPOCH;
+}
+
+/**
+ * @brief Read the persisted sync state once per boot.
+ */
+static void load_state(void)
+{
+    if (s_state_loaded) return;
+    s_state_loaded = true;
+
+    wifi_nvs_init();
+    nvs_handle_t nvs;
+    if (nvs_open(SNTP_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return; // nothing stored yet
+    }
+    if (nvs_get_i64(nvs, SNTP_NVS_KEY_LAST_SYNC, &s_last_sync) != ESP_OK) {
+        s_last_sync = 0;
+    }
+    s_drift_known = nvs_get_i32(nvs, SNTP_NVS_KEY_DRIFT, &s_drift_ppb) == ESP_OK;
+    nvs_close(nvs);
+}
+
+static void save_state(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(SNTP_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_i64(nvs, SNTP_NVS_KEY_LAST_SYNC, s_last_sync);
+        if (err == ESP_OK && s_drift_known) {
+            err = nvs_set_i32(nvs, SNTP_NVS_KEY_DRIFT, s_drift_ppb);
+        }
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG_SNTP, "Saving sync state failed: %s", esp_err_to_name(err));
+    }
+}
+
+/**
+ * @brief Seconds after a sync until the estimated error reaches CONFIG_APP_SNTP_MAX_ERROR_MS.
+ *
+ * error_us = |drift_ppb| * t_s / 1000, solved for t_s and clamped to the
+ * configured bounds. Until a drift has been measured, CONFIG_APP_SNTP_DEFAULT_DRIFT_PPM is assumed.
+ */
+static uint32_t resync_interval_s(void)
+{
+    int64_t drift_ppb = s_drift_known ? llabs((int64_t)s_drift_ppb) : (int64_t)CONFIG_APP_SNTP_DEFAULT_DRIFT_PPM * 1000;
+    int64_t interval = (drift_ppb > 0) ? (int64_t)CONFIG_APP_SNTP_MAX_ERROR_MS * 1000000 / drift_ppb
+                                       : CONFIG_APP_SNTP_RESYNC_MAX_S;
+    if (interval < CONFIG_APP_SNTP_RESYNC_MIN_S) interval = CONFIG_APP_SNTP_RESYNC_MIN_S;
+    if (interval > CONFIG_APP_SNTP_RESYNC_MAX_S) interval = CONFIG_APP_SNTP_RESYNC_MAX_S;
+    return (uint32_t)interval;
+}
+
+/**
+ * @brief Seconds until the next resync is due (0 if due now).
+ */
+static uint32_t seconds_until_resync(void)
+{
+    load_state();
+
+    time_t now = time(NULL);
+    if (s_last_sync == 0 || !clock_is_plausible(now) || now < s_last_sync) {
+        return 0;
+    }
+    int64_t elapsed = (int64_t)now - s_last_sync;
+    uint32_t interval = resync_interval_s();
+    return (elapsed >= interval) ? 0 : (uint32_t)(interval - elapsed);
+}
+
+/**
+ * @brief Fold the offset observed at this sync into the drift estimate and persist it.
+ *
+ * @param[in] server Time reported by the server.
+ * @param[in] local  Local time just before it was replaced.
+ */
+static void note_sync(const struct timeval *server, const struct timeval *local)
+{
+    load_state();
+
+    int64_t offset_us = ((int64_t)server->tv_sec - local->tv_sec) * 1000000 + (server->tv_usec - local->tv_usec);
+    int64_t elapsed_s = (int64_t)server->tv_sec - s_last_sync;
+
+    // Only meaningful if the local clock ran freely since the previous sync
+    if (s_last_sync > 0 && clock_is_plausible(local->tv_sec) && elapsed_s >= SNTP_DRIFT_MIN_INTERVAL_S) {
+        int32_t measured = (int32_t)(-offset_us * 1000 / elapsed_s);
+        s_drift_ppb = s_drift_known ? s_drift_ppb + (measured - s_drift_ppb) / SNTP_DRIFT_WEIGHT : measured;
+        s_drift_known = true;
+    }
+
+    s_last_sync = server->tv_sec;
+    save_state();
+
+    uint32_t next_s = resync_interval_s();
+    sntp_set_sync_interval(next_s * 1000);  // applies to the request lwIP schedules after this reply
+    ESP_LOGI(TAG_SNTP, "Offset %lld ms, drift %ld ppb, next sync in %lu s", (long long)(offset_us / 1000),
+             (long)(s_drift_known ? s_drift_ppb : 0), (unsigned long)next_s);
+}
 
 /**
- * @brief Start the SNTP client with a static NTP server.
+ * @brief Replaces the weak lwIP hook that applies a received time.
+ *
+ * Measures the offset before stepping the clock (see note_sync()), then does
+ * what the default does and publishes @ref NET_TIME_SYNCED_BIT.
+ *
+ * @param[in] tv Time received from the server.
+ *
+ * @note Runs in the lwIP task.
+ */
+void sntp_sync_time(struct timeval *tv)
+{
+    struct timeval local;
+    gettimeofday(&local, NULL);
+    settimeofday(tv, NULL);
+    sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+
+    note_sync(tv, &local);
+    xEventGroupSetBits(wifi_get_event_group(), NET_TIME_SYNCED_BIT);
+    ESP_LOGI(TAG_SNTP, "Time synchronized");
+}
+
+/**
+ * @brief Resync timer: the trusted-time budget is used up, start SNTP.
+ */
+static void resync_timer_cb(void *arg)
+{
+    (void)arg;
+    ESP_LOGI(TAG_SNTP, "Drift budget reached, starting SNTP");
+    esp_netif_sntp_start();
+}
+
+/**
+ * @brief Initialize the SNTP client with the Kconfig and DHCP servers.
  *
  * @details
- * Initializes and starts the SNTP service using esp_netif with a fixed
- * NTP server ("pool.ntp.org"). Alternative configuration options include:
- *   - Accepting NTP servers from DHCP.
- *   - Renewing the server list after a new DHCP lease.
- *   - Controlling whether SNTP auto-starts.
+ * Uses esp_netif SNTP with three static servers (CONFIG_APP_SNTP_SERVER_1..3)
+ * and, with CONFIG_APP_SNTP_DHCP_SERVERS, the server offered by DHCP, renewed on
+ * every new lease. The periodic interval starts at resync_interval_s() and is
+ * re-tuned after each sync by note_sync().
  *
- * @note This function should be called once after network initialization
- *       (after Wi-Fi or Ethernet is up).
+ * @param[in] start_now Send the first request immediately; otherwise the caller
+ *                      starts the client later with esp_netif_sntp_start().
  *
- * @return None
+ * @note Call once after network initialization (after Wi-Fi or Ethernet is up).
  */
-static void sntp_start(void)
+static void sntp_start(bool start_now)
 {
-    // Simple configuration with static server; see notes above for DHCP options
-    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG("pool.ntp.org");
-    // Example options:
-    // config.server_from_dhcp = true;             // accept NTP servers via DHCP
-    // config.renew_servers_after_new_IP = true;   // refresh servers on new lease
-    // config.start = true;                        // auto-start (default true)
+    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG_MULTIPLE(3,
+        ESP_SNTP_SERVER_LIST(CONFIG_APP_SNTP_SERVER_1, CONFIG_APP_SNTP_SERVER_2, CONFIG_APP_SNTP_SERVER_3));
+#if CONFIG_APP_SNTP_DHCP_SERVERS
+    config.server_from_dhcp = true;             // slot 0: NTP server from the DHCP lease
+    config.renew_servers_after_new_IP = true;   // refresh it on every new lease
+    config.index_of_first_server = SNTP_FIRST_STATIC_SERVER;
+#endif
+    config.start = start_now;
 
+    sntp_set_sync_interval(resync_interval_s() * 1000);
     ESP_ERROR_CHECK(esp_netif_sntp_init(&config));
-    ESP_LOGI(TAG_SNTP, "SNTP started via esp_netif");
+    ESP_LOGI(TAG_SNTP, "SNTP initialized via esp_netif (%s)", start_now ? "syncing" : "deferred");
 }
 
 void wait_for_time_blocking(uint32_t timeout_ms)
 {
-    esp_err_t r = esp_netif_sntp_sync_wait(pdMS_TO_TICKS(timeout_ms));
-    if (r == ESP_OK) {
+    // sntp_sync_time() publishes the bit; esp_netif_sntp_sync_wait() relies on the hook it replaces
+    EventBits_t bits = xEventGroupWaitBits(wifi_get_event_group(), NET_TIME_SYNCED_BIT, pdFALSE, pdTRUE,
+                                           pdMS_TO_TICKS(timeout_ms));
+    if (bits & NET_TIME_SYNCED_BIT) {
         ESP_LOGI(TAG_GETT, "Time synced");
         return;
     }
 
     // Very simple fallback check
     for (int retry = 0; retry < 10; ++retry) {
-        time_t now = 0;
-        struct tm ti = {0};
-        time(&now);
-        localtime_r(&now, &ti);
-        if (ti.tm_year > (2016 - 1900)) {
+        if (clock_is_plausible(time(NULL))) {
             ESP_LOGI(TAG_GETT, "Time looks valid (fallback).");
             return;
         }
@@ -63,12 +252,51 @@ void wait_for_time_blocking(uint32_t timeout_ms)
 }
 
 
-void init_sntp(void)
+bool sntp_time_is_valid(void)
+{
+    if (xEventGroupGetBits(wifi_get_event_group()) & NET_TIME_SYNCED_BIT) {
+        return true;
+    }
+
+    // Time may survive a soft reset even before the first sync of this boot
+    return clock_is_plausible(time(NULL));
+}
+
+bool sntp_time_is_trusted(void)
+{
+    return seconds_until_resync() > 0;
+}
+
+bool sntp_resync_due(void)
 {
-    sntp_start();
+    return seconds_until_resync() == 0;
+}
+
+void init_sntp_async(void)
+{
+    local_time_init();
 
-    setenv("TZ", EUROPE_ROMANIA_BUCHAREST, 1);
-    tzset();
+    uint32_t defer_s = seconds_until_resync();
+    sntp_start(defer_s == 0);
+    if (defer_s == 0) {
+        return;
+    }
 
-    wait_for_time_blocking(10000);
+    // Clock still within its error budget: no network round trip until it runs out
+    const esp_timer_create_args_t timer_args = {
+        .callback = resync_timer_cb,
+        .name = "sntp_resync",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_resync_timer));
+    ESP_ERROR_CHECK(esp_timer_start_once(s_resync_timer, (uint64_t)defer_s * 1000000ULL));
+    ESP_LOGI(TAG_SNTP, "Clock trusted, first sync in %lu s", (unsigned long)defer_s);
+}
+
+void init_sntp(void)
+{
+    init_sntp_async();
+
+    if (!sntp_time_is_trusted()) {
+        wait_for_time_blocking(10000);
+    }
 }
\ No newline at end of file
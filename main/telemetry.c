@@ -0,0 +1,195 @@
+/**
+ * @file telemetry.c
+ * @brief Batched MQTT publisher for the sample history.
+ *
+ * @details
+ * Every publish keeps the radio awake for a round trip and, over mqtts://,
+ * costs a TLS record, so samples are never sent one by one. The publisher task
+ * wakes on each new sample (sensor_snapshot_subscribe()) and on broker
+ * (re)connects, reads the unsent samples out of the history ring and publishes
+ * them once a full batch has accumulated.
+ *
+ * The ring doubles as the offline queue, so there is no second copy of the
+ * samples; the MQTT client's own outbox covers QoS 1 retransmissions.
+ */
+
+#include <string.h>
+
+#include "sdkconfig.h"
+
+#include "telemetry.h"
+
+static inline uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p = put_u16(p, (uint16_t)v);
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
+size_t telemetry_encode(uint8_t *out, size_t size, const sensor_sample_t *samples, size_t count)
+{
+    size_t len = TELEMETRY_HEADER_SIZE + count * TELEMETRY_RECORD_SIZE;
+    if (!out || count > TELEMETRY_MAX_BATCH || len > size) {
+        return 0;
+    }
+
+    uint8_t *p = out;
+    *p++ = TELEMETRY_FORMAT_VERSION;
+    *p++ = TELEMETRY_RECORD_SIZE;
+    p = put_u16(p, (uint16_t)count);
+    for (size_t i = 0; i < count; ++i) {
+        p = put_u32(p, samples[i].timestamp);
+        p = put_u16(p, (uint16_t)samples[i].temperature_c100);
+        p = put_u16(p, samples[i].humidity_c100);
+        p = put_u32(p, samples[i].pressure_pa);
+    }
+    return len;
+}
+
+#if CONFIG_APP_MQTT_TELEMETRY
+
+#include <stdatomic.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_bit_defs.h"
+#include "esp_check.h"
+#include "esp_crt_bundle.h"
+#include "esp_log.h"
+#include "mqtt_client.h"
+
+#include "sensor_snapshot.h"
+
+static const char *TAG_TELEMETRY = "TELEMETRY";
+
+#define TELEMETRY_NOTIFY_SAMPLE     BIT0    /**< A new sample is in the history */
+#define TELEMETRY_NOTIFY_CONNECTED  BIT1    /**< The broker connection came up */
+
+#define TELEMETRY_TASK_STACK        4096
+
+_Static_assert(CONFIG_APP_MQTT_BATCH_SAMPLES <= TELEMETRY_MAX_BATCH, "batch exceeds the payload buffer");
+
+static esp_mqtt_client_handle_t s_client;
+static TaskHandle_t s_task;
+static atomic_bool s_connected;
+
+static uint32_t s_next;     /**< Number of the oldest unsent sample (sensor_history_total() numbering) */
+static sensor_sample_t s_batch[TELEMETRY_MAX_BATCH];
+static uint8_t s_payload[TELEMETRY_PAYLOAD_MAX];
+
+static telemetry_stats_t s_stats;
+static portMUX_TYPE s_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void mqtt_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    (void)arg; (void)base; (void)event_data;
+
+    switch ((esp_mqtt_event_id_t)event_id) {
+    case MQTT_EVENT_CONNECTED:
+        atomic_store(&s_connected, true);
+        xTaskNotify(s_task, TELEMETRY_NOTIFY_CONNECTED, eSetBits);
+        ESP_LOGI(TAG_TELEMETRY, "Broker connected");
+        break;
+    case MQTT_EVENT_DISCONNECTED:
+        atomic_store(&s_connected, false);
+        ESP_LOGI(TAG_TELEMETRY, "Broker disconnected, queueing");
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Publish full batches of unsent samples until the backlog is below one batch.
+ *
+ * A failed publish leaves @ref s_next unchanged, so the same samples are
+ * retried on the next wake-up.
+ */
+static void flush_pending(void)
+{
+    while (atomic_load(&s_connected)) {
+        uint32_t from = s_next;
+        size_t count = sensor_history_read(&from, s_batch, TELEMETRY_MAX_BATCH);
+        if (from != s_next) {
+            portENTER_CRITICAL(&s_stats_mux);
+            s_stats.dropped += from - s_next;
+            portEXIT_CRITICAL(&s_stats_mux);
+            ESP_LOGW(TAG_TELEMETRY, "%lu samples overwritten before they were sent", (unsigned long)(from - s_next));
+            s_next = from;
+        }
+
+        // Taken before the clock was valid: not sent. The clock stays valid once set, so they only lead the ring
+        size_t undated = 0;
+        while (undated < count && !sensor_sample_dated(&s_batch[undated])) {
+            undated++;
+        }
+        if (undated) {
+            s_next += (uint32_t)undated;
+            continue;
+        }
+        if (count < CONFIG_APP_MQTT_BATCH_SAMPLES) {
+            return;
+        }
+
+        size_t len = telemetry_encode(s_payload, sizeof(s_payload), s_batch, count);
+        int msg_id = esp_mqtt_client_publish(s_client, CONFIG_APP_MQTT_TOPIC, (const char *)s_payload, (int)len,
+                                             CONFIG_APP_MQTT_QOS, 0);
+        if (msg_id < 0) {
+            ESP_LOGW(TAG_TELEMETRY, "Publish of %u samples failed, retrying later", (unsigned)count);
+            return;
+        }
+
+        s_next += (uint32_t)count;
+        portENTER_CRITICAL(&s_stats_mux);
+        s_stats.batches++;
+        s_stats.samples += (uint32_t)count;
+        portEXIT_CRITICAL(&s_stats_mux);
+        ESP_LOGD(TAG_TELEMETRY, "Sent %u samples (%u bytes)", (unsigned)count, (unsigned)len);
+    }
+}
+
+static void telemetry_task(void *arg)
+{
+    (void)arg;
+    while (1) {
+        xTaskNotifyWait(0, UINT32_MAX, NULL, portMAX_DELAY);
+        flush_pending();
+    }
+}
+
+esp_err_t telemetry_start(void)
+{
+    s_next = sensor_history_total();
+
+    const esp_mqtt_client_config_t cfg = {
+        .broker.address.uri = CONFIG_APP_MQTT_BROKER_URI,
+        .broker.verification.crt_bundle_attach = esp_crt_bundle_attach,
+        .task.priority = CONFIG_APP_NET_TASK_PRIO,     // core: CONFIG_MQTT_USE_CORE_0 in sdkconfig
+    };
+    s_client = esp_mqtt_client_init(&cfg);
+    ESP_RETURN_ON_FALSE(s_client, ESP_FAIL, TAG_TELEMETRY, "client init");
+
+    ESP_RETURN_ON_FALSE(xTaskCreatePinnedToCore(telemetry_task, "telemetry", TELEMETRY_TASK_STACK, NULL,
+                                                CONFIG_APP_NET_TASK_PRIO, &s_task, CONFIG_APP_CORE_NET) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG_TELEMETRY, "task");
+    ESP_RETURN_ON_ERROR(sensor_snapshot_subscribe(s_task, TELEMETRY_NOTIFY_SAMPLE), TAG_TELEMETRY, "subscribe");
+    ESP_RETURN_ON_ERROR(esp_mqtt_client_register_event(s_client, MQTT_EVENT_ANY, mqtt_event_handler, NULL),
+                        TAG_TELEMETRY, "events");
+    return esp_mqtt_client_start(s_client);
+}
+
+void telemetry_get_stats(telemetry_stats_t *out)
+{
+    portENTER_CRITICAL(&s_stats_mux);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_stats_mux);
+}
+
+#endif // CONFIG_APP_MQTT_TELEMETRY
@@ -4,38 +4,211 @@
  *
  * @details
  * This module configures the ESP32 Wi-Fi subsystem in station mode (STA),
- * connects to the configured SSID, and blocks execution until a valid
- * IP address is obtained. It also provides automatic reconnection if
- * the connection is lost.
+ * connects to the configured SSID and publishes the link state through an
+ * event group (see wifi_get_event_group()). wifi_init_sta() blocks until a
+ * valid IP address is obtained; wifi_start_async() returns immediately and
+ * lets the connection come up in the background. Both provide automatic
+ * reconnection if the connection is lost.
+ *
+ * Fast reconnect (CONFIG_APP_WIFI_FAST_RECONNECT): the BSSID, channel and DHCP
+ * lease of the last good connection are kept in NVS (wifi_cache.h). The next
+ * start pins that AP and channel, which skips the all-channel scan, and, while
+ * the lease is younger than CONFIG_APP_WIFI_LEASE_REUSE_S, configures the
+ * address statically instead of waiting for DHCP. The static address only
+ * bridges that first connect: once it is up, the DHCP client is started again
+ * so the lease is renewed (or replaced) with the router as usual. If the cached
+ * AP cannot be joined, the cache is dropped and the normal scan + DHCP path
+ * takes over.
+ *
+ * Reconnects back off exponentially with jitter, from
+ * CONFIG_APP_WIFI_BACKOFF_MIN_MS up to CONFIG_APP_WIFI_BACKOFF_MAX_MS.
  */
 
 #include "wifi.h"
 
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
 
 #include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_netif.h"
 
 #include "nvs_flash.h"
+#include "sdkconfig.h"
+
+#include "sntp.h"
+#include "wifi_cache.h"
+
+#define WIFI_BACKOFF_MAX_SHIFT  16      /**< Cap on the doubling count, keeps the shift in range */
 
 static const char *TAG_WIFI = "WIFI_INIT";
-static SemaphoreHandle_t s_ip_ready;
+static EventGroupHandle_t s_net_events;
+static bool s_stopping;                 /**< Set by wifi_stop(): do not reconnect on the resulting disconnect */
+
+static esp_netif_t *s_sta_netif;
+static esp_timer_handle_t s_retry_timer;
+static uint32_t s_retry_attempt;        /**< Consecutive failed attempts, reset on IP */
+
+static wifi_config_t s_wifi_config;
+static bool s_link_pinned;              /**< Connecting to the cached BSSID/channel */
+static bool s_static_lease;             /**< Cached lease applied, DHCP client stopped */
+
+/**
+ * @brief Reconnect timer callback (esp_timer task).
+ */
+static void retry_timer_cb(void *arg)
+{
+    (void)arg;
+    if (!s_stopping) {
+        esp_wifi_connect();
+    }
+}
+
+/**
+ * @brief Schedule the next connect attempt with exponential backoff and jitter.
+ *
+ * The delay doubles per failed attempt up to the configured maximum, then a
+ * random value in [delay/2, delay] is used so a fleet of units does not retry
+ * in lockstep after the AP comes back.
+ */
+static void schedule_reconnect(void)
+{
+    uint32_t shift = (s_retry_attempt < WIFI_BACKOFF_MAX_SHIFT) ? s_retry_attempt : WIFI_BACKOFF_MAX_SHIFT;
+    uint64_t delay_ms = (uint64_t)CONFIG_APP_WIFI_BACKOFF_MIN_MS << shift;
+    if (delay_ms > CONFIG_APP_WIFI_BACKOFF_MAX_MS) {
+        delay_ms = CONFIG_APP_WIFI_BACKOFF_MAX_MS;
+    }
+    delay_ms = delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+    s_retry_attempt++;
+
+    ESP_LOGW(TAG_WIFI, "Disconnected. Retry %lu in %llu ms", (unsigned long)s_retry_attempt,
+             (unsigned long long)delay_ms);
+    esp_timer_stop(s_retry_timer); // not running is fine
+    esp_timer_start_once(s_retry_timer, delay_ms * 1000ULL);
+}
+
+#if CONFIG_APP_WIFI_FAST_RECONNECT
+/**
+ * @brief Pin the cached AP/channel and, if the lease is fresh, set the address statically.
+ */
+static void apply_cached_link(void)
+{
+    wifi_cache_t cache;
+    if (wifi_cache_load(WIFI_SSID, &cache) != ESP_OK) {
+        return;
+    }
+
+    memcpy(s_wifi_config.sta.bssid, cache.bssid, sizeof(s_wifi_config.sta.bssid));
+    s_wifi_config.sta.bssid_set = true;
+    s_wifi_config.sta.channel = cache.channel;
+    s_wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    s_link_pinned = true;
+
+    // An unset clock reads 1970, so it never looks younger than a real lease
+    int64_t now = (int64_t)time(NULL);
+    if (CONFIG_APP_WIFI_LEASE_REUSE_S > 0 && cache.leased_at > 0 && now >= cache.leased_at &&
+        now - cache.leased_at < CONFIG_APP_WIFI_LEASE_REUSE_S && cache.ip_info.ip.addr != 0) {
+        ESP_ERROR_CHECK(esp_netif_dhcpc_stop(s_sta_netif));
+        ESP_ERROR_CHECK(esp_netif_set_ip_info(s_sta_netif, &cache.ip_info));
+        esp_netif_set_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &cache.dns);
+        s_static_lease = true;
+    }
+    ESP_LOGI(TAG_WIFI, "Using cached AP on channel %u%s", cache.channel, s_static_lease ? " + lease" : "");
+}
+
+/**
+ * @brief The cached AP did not take us: forget it and fall back to scan + DHCP.
+ */
+static void drop_cached_link(void)
+{
+    ESP_LOGW(TAG_WIFI, "Cached AP failed, falling back to a full scan");
+    wifi_cache_clear();
+
+    s_wifi_config.sta.bssid_set = false;
+    s_wifi_config.sta.channel = 0;
+    s_wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config);
+    s_link_pinned = false;
+
+    if (s_static_lease) {
+        esp_netif_dhcpc_start(s_sta_netif);
+        s_static_lease = false;
+    }
+}
+
+/**
+ * @brief Hand the cached address back to DHCP once the link is up.
+ *
+ * The lease age is only checked at start; without this a unit that stays up
+ * for days would keep the address long after the router let it expire. The
+ * DHCP client resets the address and the renewed lease arrives as another
+ * IP_EVENT_STA_GOT_IP, which save_link() then stores.
+ */
+static void release_static_lease(void)
+{
+    s_static_lease = false;
+    esp_err_t err = esp_netif_dhcpc_start(s_sta_netif);
+    if (err != ESP_OK && err != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STARTED) {
+        ESP_LOGW(TAG_WIFI, "DHCP restart failed: %s", esp_err_to_name(err));
+    }
+}
+
+/**
+ * @brief Remember the AP and the lease that just produced an IP.
+ */
+static void save_link(const ip_event_got_ip_t *event)
+{
+    if (s_static_lease) {
+        release_static_lease();
+        return; // nothing new: the lease came from the cache
+    }
+
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+
+    wifi_cache_t cache;
+    memset(&cache, 0, sizeof(cache));
+    cache.version = WIFI_CACHE_VERSION;
+    strlcpy(cache.ssid, WIFI_SSID, sizeof(cache.ssid));
+    memcpy(cache.bssid, ap.bssid, sizeof(cache.bssid));
+    cache.channel = ap.primary;
+    cache.ip_info = event->ip_info;
+    esp_netif_get_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &cache.dns);
+
+    // Without a valid clock the lease age is unknown, so it will not be reused
+    cache.leased_at = sntp_time_is_valid() ? (int64_t)time(NULL) : 0;
+
+    esp_err_t err = wifi_cache_save(&cache);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG_WIFI, "Caching link failed: %s", esp_err_to_name(err));
+    }
+}
+#endif
 
 /**
  * @brief General Wi-Fi and IP event handler.
  *
  * Handles the following cases:
  * - `WIFI_EVENT_STA_START`: Initiates a connection attempt.
- * - `WIFI_EVENT_STA_DISCONNECTED`: Logs a warning and retries connection.
- * - `IP_EVENT_STA_GOT_IP`: Signals that an IP address has been acquired.
+ * - `WIFI_EVENT_STA_DISCONNECTED`: Clears @ref NET_WIFI_CONNECTED_BIT, drops a cached AP
+ *   that failed, and schedules a retry with backoff (schedule_reconnect()).
+ * - `IP_EVENT_STA_GOT_IP`: Sets @ref NET_WIFI_CONNECTED_BIT once an IP address has been
+ *   acquired, resets the backoff and caches the link; a connect on the cached
+ *   lease restarts the DHCP client instead.
  *
  * @param[in] arg        Unused user argument.
  * @param[in] event_base The event base type (Wi-Fi or IP).
  * @param[in] event_id   Specific event ID within the base.
- * @param[in] event_data Pointer to event-specific data (unused here).
+ * @param[in] event_data Pointer to event-specific data.
  */
 static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                                int32_t event_id, void *event_data)
@@ -44,57 +217,124 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
         if (event_id == WIFI_EVENT_STA_START) {
             esp_wifi_connect();
         } else if (event_id == WIFI_EVENT_STA_DISCONNECTED) {
-            ESP_LOGW(TAG_WIFI, "Disconnected. Retrying...");
-            esp_wifi_connect();
+            xEventGroupClearBits(s_net_events, NET_WIFI_CONNECTED_BIT);
+            if (s_stopping) {
+                return;
+            }
+#if CONFIG_APP_WIFI_FAST_RECONNECT
+            if (s_link_pinned) {
+                drop_cached_link();
+            }
+#endif
+            schedule_reconnect();
         }
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ESP_LOGI(TAG_WIFI, "Got IP!");
-        if (s_ip_ready) {
-            xSemaphoreGive(s_ip_ready);
-        }
+        s_retry_attempt = 0;
+#if CONFIG_APP_WIFI_FAST_RECONNECT
+        save_link((const ip_event_got_ip_t *)event_data);
+        s_link_pinned = false; // later drops are ordinary: keep the cache
+#endif
+        xEventGroupSetBits(s_net_events, NET_WIFI_CONNECTED_BIT);
     }
 }
 
-void wifi_init_sta(void)
+void wifi_nvs_init(void)
 {
-    /* 1) Initialize NVS */
+    static bool s_nvs_ready;
+    if (s_nvs_ready) return;
+
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
         ESP_ERROR_CHECK(nvs_flash_init());
+    } else {
+        ESP_ERROR_CHECK(err);
     }
+    s_nvs_ready = true;
+}
+
+EventGroupHandle_t wifi_get_event_group(void)
+{
+    if (!s_net_events) {
+        s_net_events = xEventGroupCreate();
+        ESP_ERROR_CHECK(s_net_events ? ESP_OK : ESP_ERR_NO_MEM);
+    }
+    return s_net_events;
+}
+
+/**
+ * @brief Bring up NVS, netif and the Wi-Fi driver and start connecting.
+ *
+ * Does not wait for the connection; progress is reported through
+ * @ref s_net_events by @ref wifi_event_handler().
+ */
+static void wifi_start(void)
+{
+    /* 1) Initialize NVS */
+    wifi_nvs_init();
 
     /* 2) Network stack + default event loop */
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
+    s_sta_netif = esp_netif_create_default_wifi_sta();
+
+    const esp_timer_create_args_t retry_args = {
+        .callback = retry_timer_cb,
+        .name = "wifi_retry",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&retry_args, &s_retry_timer));
 
     /* 3) Initialize Wi-Fi driver */
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
     /* 4) Configure STA parameters */
-    wifi_config_t wifi_config = {0};
-    strlcpy((char *)wifi_config.sta.ssid, WIFI_SSID, sizeof(wifi_config.sta.ssid));
-    strlcpy((char *)wifi_config.sta.password, WIFI_PASS, sizeof(wifi_config.sta.password));
-    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
-    wifi_config.sta.pmf_cfg.capable = true;   /**< Protected Management Frames supported */
-    wifi_config.sta.pmf_cfg.required = false; /**< PMF not mandatory */
-
-    /* 5) Create semaphore + register event handlers */
-    s_ip_ready = xSemaphoreCreateBinary();
-    ESP_ERROR_CHECK(s_ip_ready ? ESP_OK : ESP_ERR_NO_MEM);
+    strlcpy((char *)s_wifi_config.sta.ssid, WIFI_SSID, sizeof(s_wifi_config.sta.ssid));
+    strlcpy((char *)s_wifi_config.sta.password, WIFI_PASS, sizeof(s_wifi_config.sta.password));
+    s_wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    s_wifi_config.sta.pmf_cfg.capable = true;   /**< Protected Management Frames supported */
+    s_wifi_config.sta.pmf_cfg.required = false; /**< PMF not mandatory */
+#if CONFIG_APP_WIFI_FAST_RECONNECT
+    apply_cached_link();
+#endif
 
+    /* 5) Create event group + register event handlers */
+    wifi_get_event_group();
     ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL));
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL));
 
     /* 6) Start Wi-Fi + set config */
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
+    ESP_LOGI(TAG_WIFI, "Connecting to WiFi...");
+}
+
+void wifi_start_async(void)
+{
+    s_stopping = false;
+    wifi_start();
+}
+
+void wifi_stop(void)
+{
+    s_stopping = true;
+    if (s_retry_timer) {
+        esp_timer_stop(s_retry_timer);
+    }
+    esp_err_t err = esp_wifi_stop();
+    if (err != ESP_OK && err != ESP_ERR_WIFI_NOT_INIT) {
+        ESP_LOGW(TAG_WIFI, "esp_wifi_stop: %s", esp_err_to_name(err));
+    }
+    xEventGroupClearBits(wifi_get_event_group(), NET_WIFI_CONNECTED_BIT);
+}
+
+void wifi_init_sta(void)
+{
+    wifi_start();
 
     /* 7) Block until IP is acquired */
-    ESP_LOGI(TAG_WIFI, "Connecting to WiFi...");
-    ESP_ERROR_CHECK(xSemaphoreTake(s_ip_ready, portMAX_DELAY) == pdTRUE ? ESP_OK : ESP_FAIL);
+    xEventGroupWaitBits(s_net_events, NET_WIFI_CONNECTED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
     ESP_LOGI(TAG_WIFI, "WiFi connected, proceeding...");
 }
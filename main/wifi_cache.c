@@ -0,0 +1,82 @@
+/**
+ * @file wifi_cache.c
+ * @brief NVS-backed cache of the last good BSSID, channel and IP lease.
+ *
+ * @details
+ * A single versioned blob per device. It is rewritten only when a fresh DHCP
+ * lease arrives; connects that reuse the cached lease leave the flash alone.
+ */
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+
+#include "wifi_cache.h"
+
+static const char *TAG_CACHE = "WIFI_CACHE";
+
+esp_err_t wifi_cache_load(const char *ssid, wifi_cache_t *out)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(WIFI_CACHE_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    size_t len = sizeof(*out);
+    err = nvs_get_blob(nvs, WIFI_CACHE_NVS_KEY, out, &len);
+    nvs_close(nvs);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (len != sizeof(*out) || out->version != WIFI_CACHE_VERSION ||
+        strncmp(out->ssid, ssid, sizeof(out->ssid)) != 0) {
+        ESP_LOGI(TAG_CACHE, "Cached link is stale, ignoring");
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t wifi_cache_save(const wifi_cache_t *entry)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(WIFI_CACHE_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_blob(nvs, WIFI_CACHE_NVS_KEY, entry, sizeof(*entry));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG_CACHE, "Cached link: channel %u", entry->channel);
+    }
+    return err;
+}
+
+esp_err_t wifi_cache_clear(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(WIFI_CACHE_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_erase_key(nvs, WIFI_CACHE_NVS_KEY);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+        err = ESP_OK;
+    }
+    nvs_close(nvs);
+    return err;
+}
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""Decode a history_pack stream (GET /api/v1/history.bin) to CSV or JSON.
+
+The format is documented in main/include/history_pack.h. Blocks that fail
+their CRC are reported on stderr and skipped; decoding resumes at the next
+block header found after them.
+
+    history_decode.py history.bin > history.csv
+    history_decode.py --url http://clock.local/api/v1/history.bin --json
+    curl -s http://clock.local/api/v1/history.bin | history_decode.py -
+"""
+
+import argparse
+import csv
+import json
+import sys
+import urllib.request
+import zlib
+
+MAGIC = b"hp"
+VERSION = 1
+FIELDS = ("timestamp", "temperature_c", "humidity_pct", "pressure_hpa")
+
+
+class Malformed(Exception):
+    pass
+
+
+class Reader:
+    def __init__(self, data, pos):
+        self.data = data
+        self.pos = pos
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise Malformed("truncated")
+        b = self.data[self.pos]
+        self.pos += 1
+        return b
+
+    def varint(self):
+        value = 0
+        for shift in range(0, 35, 7):
+            b = self.byte()
+            value |= (b & 0x7F) << shift
+            if not b & 0x80:
+                return value
+        raise Malformed("varint too long")
+
+    def zigzag(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+
+def decode_block(data, pos):
+    """Decode the block at pos; return (samples, position after it)."""
+    r = Reader(data, pos)
+    if data[pos:pos + 2] != MAGIC or r.pos + 2 >= len(data) or data[pos + 2] != VERSION:
+        raise Malformed("no block header")
+    r.pos += 3
+    steps = [r.varint(), r.varint(), r.varint()]
+    if 0 in steps:
+        raise Malformed("zero step")
+    t = r.varint()
+    values = [r.zigzag(), r.varint(), r.varint()]
+    raw = [(t, *values)]
+
+    while True:
+        tag = r.varint()
+        if tag == 0:
+            break
+        count, mask = tag >> 3, tag & 7
+        n = count + (1 if mask else 0)
+        dt = r.zigzag()
+        nxt = list(values)
+        for c in range(3):
+            if mask & (1 << c):
+                nxt[c] += r.zigzag()
+        for i in range(1, n + 1):
+            ts = t + (2 * i * dt + n) // (2 * n)
+            raw.append((ts, *(values if i <= count else nxt)))
+        t += dt
+        values = nxt
+
+    end = r.pos
+    if end + 4 > len(data):
+        raise Malformed("truncated")
+    crc = int.from_bytes(data[end:end + 4], "little")
+    if crc != zlib.crc32(data[pos:end]):
+        raise Malformed("CRC mismatch")
+
+    samples = [
+        (ts, v[0] * steps[0] / 100, v[1] * steps[1] / 100, v[2] * steps[2] / 100)
+        for ts, *v in raw
+    ]
+    return samples, end + 4
+
+
+def decode(data):
+    """Decode a whole stream; return (samples, number of bad blocks)."""
+    samples, bad, pos = [], 0, 0
+    header = MAGIC + bytes([VERSION])
+    while pos < len(data):
+        try:
+            block, pos = decode_block(data, pos)
+            samples.extend(block)
+        except Malformed as e:
+            nxt = data.find(header, pos + 1)
+            print(f"history_decode: bad block at offset {pos}: {e}", file=sys.stderr)
+            bad += 1
+            if nxt < 0:
+                break
+            pos = nxt
+    return samples, bad
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument("file", nargs="?", help="packed stream, '-' for stdin")
+    src.add_argument("--url", help="fetch the stream from this URL")
+    ap.add_argument("--json", action="store_true", help="write JSON instead of CSV")
+    args = ap.parse_args()
+
+    if args.url:
+        with urllib.request.urlopen(args.url, timeout=60) as resp:
+            data = resp.read()
+    elif args.file == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.file, "rb") as f:
+            data = f.read()
+
+    samples, bad = decode(data)
+    if args.json:
+        json.dump({"fields": FIELDS, "samples": samples}, sys.stdout)
+        sys.stdout.write("\n")
+    else:
+        w = csv.writer(sys.stdout, lineterminator="\n")
+        w.writerow(FIELDS)
+        w.writerows(samples)
+    print(f"history_decode: {len(samples)} samples, {bad} bad block(s)", file=sys.stderr)
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
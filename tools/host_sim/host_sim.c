@@ -0,0 +1,940 @@
+/**
+ * @file host_sim.c
+ * @brief Host-side checks and micro-benchmarks for the render, formatting, snapshot and bus paths.
+ *
+ * @details
+ * The firmware sources run unchanged on top of mocks/ and the simulated bus
+ * (sim.h), single-threaded: the bus scheduler is never started, so every
+ * batch runs inline in the caller, as during boot on the target.
+ *
+ * Checks (always run; any failure makes the exit status 1):
+ *   - the panel's GDDRAM, rebuilt by the SSD1306 model from the bytes on the
+ *     wire, matches the text screen rendered independently from the font
+ *   - the wire cost of each reference frame stays within its budget
+ *   - recovery after a panel brown-out redraws the whole screen
+ *   - the graph screen stays whole and nothing wraps to the top of the panel
+ *     through the burn-in shift
+ *   - command merging, the two-sensor sample round and snapshot exchange
+ *     produce the expected transactions and values
+ *   - a synthetic week of samples packs into its byte budget with
+ *     history_pack.c and decodes back within one step and the timing jitter
+ *   - the cached local time matches localtime_r() across DST transitions
+ *
+ * Benchmarks (skipped with --check) report host ns/op, which only compares
+ * builds with each other, and the simulated bus cost per op, which is what
+ * the same work costs on the target's I2C bus.
+ *
+ * Usage: host_sim [--check] [-v] [--pack-out FILE]
+ *
+ * --pack-out writes the packed week for tools/history_decode.py.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_timer.h"
+
+#include "display.h"
+#include "display_font.h"
+#include "esp_rom_crc.h"
+#include "fixed_format.h"
+#include "graph_screen.h"
+#include "history_pack.h"
+#include "i2c_sched.h"
+#include "local_time.h"
+#include "nvs.h"
+#include "screen_layout.h"
+#include "sensor_history.h"
+#include "sensor_registry.h"
+#include "sensor_snapshot.h"
+
+#include "sim.h"
+
+#define BENCH_MIN_NS            20000000ull     /**< Grow the iteration count until a run takes this long */
+#define BENCH_MAX_ITERATIONS    (1u << 24)
+
+#define SNAPSHOT_NOTIFY_BIT     (1u << 3)
+
+#define PACK_WEEK_SAMPLES       241920          /**< 7 days at the 2.5 s sensor period */
+#define PACK_WEEK_BUDGET        (24u * 1024u)   /**< Packed bytes (16.1 KB measured); the flat 16 B log needs 3.8 MB */
+
+static int s_failures;
+
+#define CHECK(cond, ...) do {                                               \
+        if (!(cond)) {                                                      \
+            s_failures++;                                                   \
+            fprintf(stderr, "FAIL %s:%d: ", __func__, __LINE__);            \
+            fprintf(stderr, __VA_ARGS__);                                   \
+            fputc('\n', stderr);                                            \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief Largest wire cost of each reference frame, per panel height.
+ *
+ * Exact figures for the current tree: a larger value is a regression in
+ * the dirty-span or window logic of display.c, a smaller one is a win that
+ * should lower the budget in the same change.
+ */
+typedef struct {
+    const char *name;
+    uint32_t max_transactions;
+    uint32_t max_wire_bytes;
+} frame_budget_t;
+
+enum {
+    FRAME_FIRST,
+    FRAME_IDLE,
+    FRAME_SECOND,
+    FRAME_MINUTE,
+    FRAME_READINGS,
+    FRAME_COUNT,
+};
+
+#if DISPLAY_HEIGHT >= 64
+static const frame_budget_t s_budgets[FRAME_COUNT] = {
+    [FRAME_FIRST]    = { "first frame",       9, 1048 },
+    [FRAME_IDLE]     = { "unchanged",         0,    0 },
+    [FRAME_SECOND]   = { "seconds digit",     3,   22 },
+    [FRAME_MINUTE]   = { "minute rollover",   3,   70 },
+    [FRAME_READINGS] = { "three readings",    7,  116 },
+};
+#else
+static const frame_budget_t s_budgets[FRAME_COUNT] = {
+    [FRAME_FIRST]    = { "first frame",       5,  528 },
+    [FRAME_IDLE]     = { "unchanged",         0,    0 },
+    [FRAME_SECOND]   = { "seconds digit",     2,   15 },
+    [FRAME_MINUTE]   = { "minute rollover",   2,   39 },
+    [FRAME_READINGS] = { "three readings",    6,   85 },
+};
+#endif
+
+// ---------------------------------------------------------------- Bench rig
+
+static sim_ssd1306_t s_panel;
+static i2c_master_dev_handle_t s_panel_dev;
+
+static sim_bme280_t s_bme[2];
+static sim_bme280_sensor_t s_sensors[2];
+
+static display_field_t s_fields[TEXT_FIELD_COUNT];
+static char s_values[TEXT_FIELD_COUNT][DISPLAY_FIELD_MAX_CHARS + 1];    /**< What each field should show */
+
+static struct {
+    fixed_hold_t temperature_c100;
+    fixed_hold_t humidity_c100;
+    fixed_hold_t pressure_pa;
+} s_shown;
+
+static void set_field(text_field_t field, const char *value)
+{
+    snprintf(s_values[field], sizeof(s_values[field]), "%s", value);
+    display_field_set(&s_fields[field], value);
+}
+
+/**
+ * @brief The readings part of main.c's render_sensor(), fed from the sim sensor instead of the snapshot.
+ */
+static bool render_readings(int32_t temperature_c100, int32_t humidity_c100, int32_t pressure_pa)
+{
+    bool changed = fixed_quantize(&s_shown.temperature_c100, temperature_c100, 10, CONFIG_APP_DISPLAY_HYST_TEMP_C100);
+    changed |= fixed_quantize(&s_shown.humidity_c100, humidity_c100, 10, CONFIG_APP_DISPLAY_HYST_HUM_C100);
+    changed |= fixed_quantize(&s_shown.pressure_pa, pressure_pa, 1, CONFIG_APP_DISPLAY_HYST_PRES_PA);
+    if (!changed) {
+        return false;
+    }
+
+    char buf[12];
+    fixed_format(buf, sizeof(buf), s_shown.humidity_c100.shown, 2, 1);
+    set_field(TEXT_FIELD_HUMIDITY, buf);
+    fixed_format(buf, sizeof(buf), s_shown.temperature_c100.shown, 2, 1);
+    set_field(TEXT_FIELD_TEMPERATURE, buf);
+    fixed_format(buf, sizeof(buf), s_shown.pressure_pa.shown, 2, 2);
+    set_field(TEXT_FIELD_PRESSURE, buf);
+    return true;
+}
+
+static void init_screen(void)
+{
+    for (size_t i = 0; i < TEXT_FIELD_COUNT; ++i) {
+        display_field_init(&s_fields[i], &text_screen_layout[i]);
+        s_values[i][0] = '\0';
+    }
+    s_shown.temperature_c100.valid = false;
+    s_shown.humidity_c100.valid = false;
+    s_shown.pressure_pa.valid = false;
+}
+
+static void setup(void)
+{
+    sim_ssd1306_reset(&s_panel);
+    s_panel_dev = sim_bus_attach(SSD1306_I2C_ADDR_DEFAULT, SSD1306_SCL_SPEED_HZ, &sim_ssd1306_ops, &s_panel);
+    i2c_sched_add_device(s_panel_dev, SSD1306_I2C_ADDR_DEFAULT, "ssd1306");
+
+    // The SSD1306 driver's own init sequence: memory mode is display.c's, the rest is sent here
+    const uint8_t power_on[] = { 0x00, 0x8D, 0x14, 0xAF };
+    i2c_master_transmit(s_panel_dev, power_on, sizeof(power_on), 100);
+
+    const uint16_t addrs[2] = { BME280_I2C_ADDR_PRIM, BME280_I2C_ADDR_SEC };
+    for (size_t i = 0; i < 2; ++i) {
+        sim_bme280_reset(&s_bme[i]);
+        s_bme[i].temperature_c100 = 2150 + (int32_t)i * 40;
+        s_bme[i].humidity_c100 = 4520;
+        s_bme[i].pressure_pa = 101325;
+        s_sensors[i].dev = sim_bus_attach(addrs[i], BME280_SCL_SPEED_HZ, &sim_bme280_ops, &s_bme[i]);
+        i2c_sched_add_device(s_sensors[i].dev, addrs[i], "bme280");
+    }
+
+    esp_err_t err = display_init(s_panel_dev);
+    if (err != ESP_OK) {
+        fprintf(stderr, "display_init: %s\n", esp_err_to_name(err));
+        exit(1);
+    }
+    init_screen();
+}
+
+// ---------------------------------------------------------------- Panel checks
+
+/**
+ * @brief Rasterize the text screen from @ref s_values straight from the font, without display.c.
+ */
+static void expected_image(uint8_t img[SIM_GDDRAM_PAGES][SIM_GDDRAM_COLUMNS])
+{
+    memset(img, 0, SIM_GDDRAM_PAGES * SIM_GDDRAM_COLUMNS);
+
+    for (size_t f = 0; f < TEXT_FIELD_COUNT; ++f) {
+        const display_field_layout_t *l = &text_screen_layout[f];
+        if (l->value_chars == 0) continue;
+
+        // prefix, value padded to value_chars by the field's alignment, suffix
+        char line[2 * DISPLAY_FIELD_MAX_CHARS + 1];
+        size_t len = strlen(s_values[f]);
+        size_t pad = (len < l->value_chars) ? l->value_chars - len : 0;
+        size_t lead = (l->align == DISPLAY_ALIGN_RIGHT) ? pad : (l->align == DISPLAY_ALIGN_CENTER) ? pad / 2 : 0;
+        snprintf(line, sizeof(line), "%s%*s%-*.*s%s", l->prefix, (int)lead, "",
+                 (int)(l->value_chars - lead), (int)(l->value_chars - lead), s_values[f], l->suffix);
+
+        for (size_t c = 0; line[c]; ++c) {
+            const uint8_t *glyph = display_font_5x7[line[c] - DISPLAY_FONT_FIRST_CHAR];
+            for (unsigned col = 0; col < DISPLAY_FONT_GLYPH_COLUMNS; ++col) {
+                unsigned x = l->x + c * DISPLAY_FONT_CELL_WIDTH + 1 + col;     // 1 px left padding
+                for (unsigned row = 0; row < 8; ++row) {
+                    unsigned y = l->y + row;
+                    if (x < DISPLAY_WIDTH && y < DISPLAY_HEIGHT && (glyph[col] >> row) & 1u) {
+                        img[y / 8][x] |= (uint8_t)(1u << (y % 8));
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Compare the model's GDDRAM with the expected screen; pages below the panel must be blank.
+ */
+static void check_panel(const char *what)
+{
+    static uint8_t img[SIM_GDDRAM_PAGES][SIM_GDDRAM_COLUMNS];
+    expected_image(img);
+
+    unsigned wrong = 0;
+    for (unsigned page = 0; page < SIM_GDDRAM_PAGES; ++page) {
+        for (unsigned col = 0; col < SIM_GDDRAM_COLUMNS; ++col) {
+            wrong += s_panel.gddram[page][col] != img[page][col];
+        }
+    }
+    CHECK(wrong == 0, "%s: %u GDDRAM bytes differ from the expected screen", what, wrong);
+    CHECK(s_panel.protocol_errors == 0, "%s: %u SSD1306 protocol errors", what, (unsigned)s_panel.protocol_errors);
+    CHECK(s_panel.display_on, "%s: display off", what);
+}
+
+/**
+ * @brief Flush and check the wire cost against the budget of @p frame.
+ */
+static void flush_frame(int frame)
+{
+    const frame_budget_t *b = &s_budgets[frame];
+    sim_bus_reset_stats();
+    esp_err_t err = display_flush();
+    sim_bus_stats_t bus;
+    sim_bus_get_stats(&bus);
+
+    printf("  frame %-16s %3u tx %5u B %8.1f us\n", b->name, (unsigned)bus.transactions,
+           (unsigned)bus.wire_bytes, bus.bus_ns / 1000.0);
+    CHECK(err == ESP_OK, "%s: flush %s", b->name, esp_err_to_name(err));
+    CHECK(bus.transactions <= b->max_transactions, "%s: %u transactions, budget %u", b->name,
+          (unsigned)bus.transactions, (unsigned)b->max_transactions);
+    CHECK(bus.wire_bytes <= b->max_wire_bytes, "%s: %u wire bytes, budget %u", b->name,
+          (unsigned)bus.wire_bytes, (unsigned)b->max_wire_bytes);
+    check_panel(b->name);
+}
+
+static void check_frames(void)
+{
+    printf("render (%ux%u panel)\n", (unsigned)DISPLAY_WIDTH, (unsigned)DISPLAY_HEIGHT);
+
+    set_field(TEXT_FIELD_TIME, "12:34:58");
+    set_field(TEXT_FIELD_DATE, "2026-10-14");
+    render_readings(2150, 4520, 101325);
+    flush_frame(FRAME_FIRST);
+
+    flush_frame(FRAME_IDLE);
+
+    set_field(TEXT_FIELD_TIME, "12:34:59");
+    flush_frame(FRAME_SECOND);
+
+    set_field(TEXT_FIELD_TIME, "12:35:00");
+    flush_frame(FRAME_MINUTE);
+
+    render_readings(2162, 4480, 101298);
+    flush_frame(FRAME_READINGS);
+
+    // Below the displayed step and inside the hysteresis band: nothing to draw
+    CHECK(!render_readings(2163, 4482, 101298), "sub-step change reached the display");
+}
+
+static void check_recovery(void)
+{
+    printf("recovery\n");
+
+    // Brown-out: the panel loses its state and NACKs until it is back
+    sim_ssd1306_reset(&s_panel);
+    sim_bus_fail_next(s_panel_dev, I2C_SCHED_RETRIES);
+    set_field(TEXT_FIELD_TIME, "12:35:01");
+    CHECK(display_flush() == ESP_OK, "flush across the recovery failed");
+
+    i2c_sched_stats_t stats;
+    i2c_sched_get_stats(&stats);
+    CHECK(stats.recoveries == 1, "%u recoveries, expected 1", (unsigned)stats.recoveries);
+
+    // The next flush re-initializes the panel and redraws everything
+    sim_bus_reset_stats();
+    CHECK(display_flush() == ESP_OK, "resync flush failed");
+    sim_bus_stats_t bus;
+    sim_bus_get_stats(&bus);
+    printf("  resync + redraw      %3u tx %5u B %8.1f us\n", (unsigned)bus.transactions,
+           (unsigned)bus.wire_bytes, bus.bus_ns / 1000.0);
+    check_panel("after recovery");
+}
+
+/**
+ * @brief Draw the graph screen and step the burn-in shift through its range.
+ *
+ * On a 128x64 panel the rows that come in at the top are the bottom of the
+ * frame: they must lie below the last strip, and no lit pixel may reach them.
+ * Every pixel of the graph must stay on the panel.
+ */
+static void check_graph_shift(void)
+{
+    printf("graph shift (0 to %d rows)\n", CONFIG_APP_PANEL_SHIFT_ROWS);
+
+    display_clear();
+    sim_history_set_total(2 * SENSOR_HISTORY_LEN);
+    graph_screen_draw();
+    CHECK(display_flush() == ESP_OK, "graph flush failed");
+
+    const unsigned gddram_rows = SIM_GDDRAM_PAGES * 8;
+    const unsigned strips_end = 2 * GRAPH_STRIP_PITCH + GRAPH_STRIP_HEIGHT;
+    unsigned lit = 0;
+    for (unsigned y = 0; y < gddram_rows; ++y) {
+        for (unsigned x = 0; x < DISPLAY_WIDTH; ++x) {
+            lit += sim_ssd1306_pixel(&s_panel, x, y);
+        }
+    }
+    CHECK(lit > 0, "graph screen is blank");
+
+    for (uint8_t rows = 0; rows <= CONFIG_APP_PANEL_SHIFT_ROWS; ++rows) {
+        CHECK(display_set_row_shift(rows) == ESP_OK, "shift %u failed", rows);
+        unsigned shown = 0, wrapped = 0, strip_rows_wrapped = 0;
+        for (unsigned y = 0; y < DISPLAY_HEIGHT; ++y) {
+            unsigned row = (s_panel.start_line + y) % gddram_rows;
+            bool wraps = y < rows;
+            strip_rows_wrapped += wraps && row < strips_end;
+            for (unsigned x = 0; x < DISPLAY_WIDTH; ++x) {
+                bool on = sim_ssd1306_pixel(&s_panel, x, row);
+                shown += on;
+                wrapped += on && wraps;
+            }
+        }
+        CHECK(strip_rows_wrapped == 0, "shift %u: %u strip rows wrap to the top", rows, strip_rows_wrapped);
+        CHECK(wrapped == 0, "shift %u: %u lit pixels wrap to the top", rows, wrapped);
+        CHECK(shown == lit, "shift %u: %u of %u lit pixels on the panel", rows, shown, lit);
+    }
+
+    // Back to the text screen for the benchmarks
+    display_set_row_shift(0);
+    display_clear();
+    init_screen();
+    display_flush();
+}
+
+static void check_panel_commands(void)
+{
+    printf("panel commands\n");
+
+    CHECK(display_set_contrast(8) == ESP_OK && s_panel.contrast == 8, "contrast not applied");
+    sim_bus_reset_stats();
+    display_set_contrast(8);
+    sim_bus_stats_t bus;
+    sim_bus_get_stats(&bus);
+    CHECK(bus.transactions == 0, "unchanged contrast was sent again");
+
+    CHECK(display_set_row_shift(2) == ESP_OK && s_panel.start_line == 62, "start line %u", s_panel.start_line);
+    CHECK(display_set_row_shift(0) == ESP_OK && s_panel.start_line == 0, "start line %u", s_panel.start_line);
+
+    // Mergeable command writes to one device leave as one transaction
+    const uint8_t cmds[4][3] = { { 0x00, 0x81, 0x10 }, { 0x00, 0x81, 0x20 }, { 0x00, 0x81, 0x30 }, { 0x00, 0x81, 0x40 } };
+    i2c_sched_op_t ops[4];
+    for (size_t i = 0; i < 4; ++i) {
+        ops[i] = (i2c_sched_op_t){ .dev = s_panel_dev, .tx = cmds[i], .tx_len = 3, .flags = I2C_SCHED_OP_MERGEABLE };
+    }
+    sim_bus_reset_stats();
+    CHECK(i2c_sched_submit(ops, 4, I2C_SCHED_PRIO_NORMAL) == ESP_OK, "merge batch failed");
+    sim_bus_get_stats(&bus);
+    CHECK(bus.transactions == 1 && bus.wire_bytes == 10, "merge: %u tx, %u B (expected 1 tx, 10 B)",
+          (unsigned)bus.transactions, (unsigned)bus.wire_bytes);
+    CHECK(s_panel.contrast == 0x40, "merged commands ran out of order");
+    display_set_contrast(0x7F);
+}
+
+// ---------------------------------------------------------------- Sensor checks
+
+static void check_sensors(void)
+{
+    printf("sensor round (2 x BME280)\n");
+
+    for (size_t i = 0; i < 2; ++i) {
+        CHECK(sensor_registry_add(&sim_bme280_driver, &s_sensors[i], s_sensors[i].dev,
+                                  i ? "bme280@0x77" : "bme280@0x76", NULL) == ESP_OK, "add sensor %u", (unsigned)i);
+    }
+
+    uint32_t fresh = 0;
+    sim_bus_reset_stats();
+    CHECK(sensor_registry_sample(&fresh) == ESP_OK && fresh == 0x3, "sample: fresh 0x%X", (unsigned)fresh);
+    sim_bus_stats_t bus;
+    sim_bus_get_stats(&bus);
+    printf("  round                %3u tx %5u B %8.1f us\n", (unsigned)bus.transactions,
+           (unsigned)bus.wire_bytes, bus.bus_ns / 1000.0);
+    // Per sensor: trigger write (addr + 2) and one burst read (addr + reg + addr + 12)
+    CHECK(bus.transactions == 4 && bus.wire_bytes == 36, "round: %u tx, %u B (expected 4 tx, 36 B)",
+          (unsigned)bus.transactions, (unsigned)bus.wire_bytes);
+    for (size_t i = 0; i < 2; ++i) {
+        CHECK(s_sensors[i].temperature_c100 == s_bme[i].temperature_c100 &&
+              s_sensors[i].humidity_c100 == s_bme[i].humidity_c100 &&
+              s_sensors[i].pressure_pa == s_bme[i].pressure_pa, "sensor %u decoded wrong values", (unsigned)i);
+    }
+
+    // A conversion that overruns costs that sensor one more read, not the whole round
+    s_bme[1].measuring_reads = 1;
+    sim_bus_reset_stats();
+    CHECK(sensor_registry_sample(&fresh) == ESP_OK && fresh == 0x3, "slow sample: fresh 0x%X", (unsigned)fresh);
+    sim_bus_get_stats(&bus);
+    CHECK(bus.transactions == 5, "slow round: %u tx, expected 5", (unsigned)bus.transactions);
+    s_bme[1].measuring_reads = 0;
+}
+
+static void check_snapshot(void)
+{
+    printf("snapshot\n");
+
+    CHECK(sensor_snapshot_subscribe(xTaskGetCurrentTaskHandle(), SNAPSHOT_NOTIFY_BIT) == ESP_OK, "subscribe");
+    sim_rtos_take_notify();
+
+    const struct bme280_data in = { .temperature = 21.5, .pressure = 101325.0, .humidity = 45.2 };
+    uint32_t seq = sensor_snapshot_seq();
+    sensor_snapshot_publish(&in);
+
+    sensor_snapshot_t out;
+    CHECK(sensor_snapshot_read(&out), "no snapshot after publish");
+    CHECK(out.seq == seq + 1 && sensor_snapshot_seq() == seq + 1, "seq %u, expected %u",
+          (unsigned)out.seq, (unsigned)(seq + 1));
+    CHECK(memcmp(&out.data, &in, sizeof(in)) == 0, "snapshot data differs");
+    CHECK(sim_rtos_take_notify() == SNAPSHOT_NOTIFY_BIT, "subscriber not notified");
+}
+
+/**
+ * @brief fixed_format() against a plain integer reference; fixed_quantize() against its contract.
+ */
+static void check_formatting(void)
+{
+    printf("formatting\n");
+
+    unsigned wrong = 0;
+    for (int32_t v = -200000; v <= 200000; v += 7) {
+        char got[16];
+        char want[16];
+        fixed_format(got, sizeof(got), v, 2, 1);
+
+        int32_t mag = (v < 0) ? -v : v;
+        int32_t tenths = (mag + 5) / 10;     // half away from zero
+        snprintf(want, sizeof(want), "%s%d.%d", (v < 0 && tenths) ? "-" : "", (int)(tenths / 10), (int)(tenths % 10));
+        wrong += strcmp(got, want) != 0;
+    }
+    CHECK(wrong == 0, "fixed_format: %u mismatches against the reference", wrong);
+
+    char small[4];
+    CHECK(fixed_format(small, sizeof(small), -1234, 2, 1) == 0 && small[0] == '\0', "short buffer not rejected");
+
+    fixed_hold_t hold = { 0 };
+    CHECK(fixed_quantize(&hold, 2149, 10, 3) && hold.shown == 2150, "first value %d", (int)hold.shown);
+    CHECK(!fixed_quantize(&hold, 2157, 10, 3), "moved inside the hysteresis band");
+    CHECK(fixed_quantize(&hold, 2158, 10, 3) && hold.shown == 2160, "did not move past the band: %d", (int)hold.shown);
+}
+
+// ---------------------------------------------------------------- History pack
+
+static struct {
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+} s_pack_out;
+
+static sensor_sample_t *s_week;
+
+static esp_err_t pack_to_memory(const uint8_t *data, size_t len, void *ctx)
+{
+    if (s_pack_out.len + len > s_pack_out.cap) {
+        s_pack_out.cap = s_pack_out.cap ? s_pack_out.cap * 2 : 4096;
+        s_pack_out.buf = realloc(s_pack_out.buf, s_pack_out.cap);
+        if (!s_pack_out.buf) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    memcpy(&s_pack_out.buf[s_pack_out.len], data, len);
+    s_pack_out.len += len;
+    return ESP_OK;
+}
+
+/**
+ * @brief A week of indoor-like samples: diurnal temperature and humidity with
+ *        sensor noise, pressure as a slow random walk; timestamps floor(k * 2.5).
+ */
+static void make_week(void)
+{
+    s_week = malloc(PACK_WEEK_SAMPLES * sizeof(*s_week));
+    if (!s_week) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    uint32_t rng = 12345;
+    double pressure = 101300.0;
+    double drift = 0.0;
+    for (uint32_t k = 0; k < PACK_WEEK_SAMPLES; ++k) {
+        uint32_t ts = 1790000000u + k * 5u / 2u;
+        double day = sin(2.0 * M_PI * (double)(ts % 86400u) / 86400.0);
+        rng = rng * 1664525u + 1013904223u;
+        int32_t noise = (int32_t)(rng >> 29) - 4;                   // -4..3, several times the BME280 datasheet noise
+        if ((rng >> 20 & 0xFF) == 0) {
+            drift = ((double)(rng >> 8 & 0xFF) - 127.5) / 2000.0;   // new weather trend, up to 6 Pa per 100 s
+        }
+        pressure += drift;
+
+        s_week[k] = (sensor_sample_t){
+            .timestamp = ts,
+            .temperature_c100 = (int16_t)(2150 + lround(150.0 * day) + noise),
+            .humidity_c100 = (uint16_t)(4500 - lround(400.0 * day) + noise),
+            .pressure_pa = (uint32_t)(lround(pressure) + noise / 2),
+        };
+    }
+}
+
+static uint32_t get_varint(const uint8_t **p, const uint8_t *end)
+{
+    uint32_t v = 0;
+    for (unsigned shift = 0; *p < end && shift < 35; shift += 7) {
+        uint8_t b = *(*p)++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    return v;
+}
+
+static int32_t get_zigzag(const uint8_t **p, const uint8_t *end)
+{
+    uint32_t v = get_varint(p, end);
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+typedef struct {
+    size_t samples;
+    size_t off_by_more_than_step;   /**< Channel values further than one step from the original */
+    int32_t worst_time_s;
+    bool malformed;
+} pack_verdict_t;
+
+static void compare_sample(pack_verdict_t *r, uint32_t ts, const int32_t v[3], const int32_t step[3])
+{
+    if (r->samples >= PACK_WEEK_SAMPLES) {
+        r->malformed = true;
+        return;
+    }
+    const sensor_sample_t *want = &s_week[r->samples++];
+    int32_t dt = abs((int32_t)(ts - want->timestamp));
+    if (dt > r->worst_time_s) r->worst_time_s = dt;
+    r->off_by_more_than_step += abs(v[0] * step[0] - want->temperature_c100) > step[0];
+    r->off_by_more_than_step += abs(v[1] * step[1] - (int32_t)want->humidity_c100) > step[1];
+    r->off_by_more_than_step += abs(v[2] * step[2] - (int32_t)want->pressure_pa) > step[2];
+}
+
+/**
+ * @brief Decode a stream and compare it with s_week: a second reading of
+ *        the format as history_pack.h documents it, not of history_pack.c.
+ */
+static pack_verdict_t verify_pack(const uint8_t *buf, size_t len)
+{
+    pack_verdict_t r = { 0 };
+    const uint8_t *p = buf;
+    const uint8_t *end = buf + len;
+
+    while (p < end && !r.malformed) {
+        const uint8_t *block = p;
+        if (end - p < 3 || p[0] != 'h' || p[1] != 'p' || p[2] != HISTORY_PACK_VERSION) {
+            r.malformed = true;
+            break;
+        }
+        p += 3;
+        int32_t step[3];
+        for (int c = 0; c < 3; ++c) step[c] = (int32_t)get_varint(&p, end);
+        uint32_t t = get_varint(&p, end);
+        int32_t v[3];
+        v[0] = get_zigzag(&p, end);
+        v[1] = (int32_t)get_varint(&p, end);
+        v[2] = (int32_t)get_varint(&p, end);
+        compare_sample(&r, t, v, step);
+
+        uint32_t tag;
+        while ((tag = get_varint(&p, end)) != 0 && p < end) {
+            uint32_t count = tag >> 3;
+            uint32_t mask = tag & 7;
+            int64_t n = count + (mask ? 1 : 0);
+            int32_t dt = get_zigzag(&p, end);
+            int32_t next[3] = { v[0], v[1], v[2] };
+            for (int c = 0; c < 3; ++c) {
+                if (mask & (1u << c)) next[c] += get_zigzag(&p, end);
+            }
+            for (int64_t i = 1; i <= n; ++i) {
+                int64_t num = 2 * i * dt + n;
+                int64_t off = num >= 0 ? num / (2 * n) : -((-num + 2 * n - 1) / (2 * n));
+                compare_sample(&r, t + (uint32_t)off, i <= (int64_t)count ? v : next, step);
+            }
+            t += (uint32_t)dt;
+            memcpy(v, next, sizeof(v));
+        }
+
+        if (end - p < 4) {
+            r.malformed = true;
+            break;
+        }
+        uint32_t crc = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+        if (crc != esp_rom_crc32_le(0, block, (uint32_t)(p - block))) {
+            r.malformed = true;
+        }
+        p += 4;
+    }
+    return r;
+}
+
+static void check_history_pack(const char *out_path)
+{
+    printf("history pack (one week at 2.5 s)\n");
+
+    make_week();
+    history_pack_t pack;
+    history_pack_begin(&pack, pack_to_memory, NULL);
+    for (uint32_t k = 0; k < PACK_WEEK_SAMPLES; ++k) {
+        history_pack_add(&pack, &s_week[k]);
+    }
+    CHECK(history_pack_finish(&pack) == ESP_OK, "encoder error");
+    CHECK(pack.samples == PACK_WEEK_SAMPLES && pack.bytes == s_pack_out.len, "encoder counted %u samples, %u B",
+          (unsigned)pack.samples, (unsigned)pack.bytes);
+
+    size_t flat = (size_t)PACK_WEEK_SAMPLES * sizeof(sensor_sample_t);
+    printf("  %u samples          %7u B (%.2f B/sample, raw %u B, x%.0f)\n", PACK_WEEK_SAMPLES,
+           (unsigned)s_pack_out.len, (double)s_pack_out.len / PACK_WEEK_SAMPLES, (unsigned)flat,
+           (double)flat / (double)s_pack_out.len);
+    CHECK(s_pack_out.len <= PACK_WEEK_BUDGET, "week packs into %u B, budget %u B",
+          (unsigned)s_pack_out.len, PACK_WEEK_BUDGET);
+
+    pack_verdict_t r = verify_pack(s_pack_out.buf, s_pack_out.len);
+    CHECK(!r.malformed, "stream does not decode");
+    CHECK(r.samples == PACK_WEEK_SAMPLES, "decoded %u samples", (unsigned)r.samples);
+    CHECK(r.off_by_more_than_step == 0, "%u values more than one step off", (unsigned)r.off_by_more_than_step);
+    CHECK(r.worst_time_s <= HISTORY_PACK_JITTER_S, "timestamps up to %d s off", (int)r.worst_time_s);
+
+    // A damaged block fails its own CRC and nothing else
+    s_pack_out.buf[s_pack_out.len / 2] ^= 0x10;
+    r = verify_pack(s_pack_out.buf, s_pack_out.len);
+    CHECK(r.malformed, "corruption not detected");
+    s_pack_out.buf[s_pack_out.len / 2] ^= 0x10;
+
+    if (out_path) {
+        FILE *f = fopen(out_path, "wb");
+        CHECK(f && fwrite(s_pack_out.buf, 1, s_pack_out.len, f) == s_pack_out.len, "write %s", out_path);
+        if (f) fclose(f);
+    }
+}
+
+// ---------------------------------------------------------------- Local time
+
+#define LOCAL_TIME_START        1767225600      /**< 2026-01-01 00:00 UTC */
+#define LOCAL_TIME_SPAN_S       (2 * 365 * 86400)
+#define LOCAL_TIME_STEP_S       37              /**< Coprime with 60: every second of the minute gets hit */
+#define LOCAL_TIME_DENSE_S      (3 * 3600)      /**< Checked second by second around each transition */
+
+static bool same_tm(const struct tm *a, const struct tm *b)
+{
+    return a->tm_year == b->tm_year && a->tm_mon == b->tm_mon && a->tm_mday == b->tm_mday &&
+           a->tm_hour == b->tm_hour && a->tm_min == b->tm_min && a->tm_sec == b->tm_sec &&
+           a->tm_wday == b->tm_wday && a->tm_yday == b->tm_yday && a->tm_isdst == b->tm_isdst;
+}
+
+static unsigned check_local_second(local_time_cache_t *cache, time_t t)
+{
+    struct tm want;
+    localtime_r(&t, &want);
+    return !same_tm(local_time_get(cache, t), &want);
+}
+
+/**
+ * @brief local_time_get() against localtime_r() over two years in zones with
+ *        northern, southern and no DST, one cache throughout.
+ */
+static void check_local_time(void)
+{
+    printf("local time (2 years per zone)\n");
+
+    local_time_init();
+    CHECK(strcmp(getenv("TZ"), CONFIG_APP_TIMEZONE) == 0, "default zone not applied: %s", getenv("TZ"));
+    CHECK(local_time_set_tz("") == ESP_ERR_INVALID_ARG && local_time_set_tz("Europe/Paris") == ESP_ERR_INVALID_ARG,
+          "bad zone accepted");
+
+    static const char *const zones[] = {
+        "Europe/Bucharest", "America/New_York", "Australia/Sydney", "Asia/Kolkata", "<+0545>-5:45",
+    };
+    local_time_cache_t cache = { 0 };
+    for (size_t z = 0; z < sizeof(zones) / sizeof(zones[0]); ++z) {
+        CHECK(local_time_set_tz(zones[z]) == ESP_OK, "set %s", zones[z]);
+        char tz[LOCAL_TIME_TZ_MAX];
+        local_time_get_tz(tz, sizeof(tz));
+        const char *stored = sim_nvs_peek("tz");
+        CHECK(stored && strcmp(stored, tz) == 0 && strcmp(getenv("TZ"), tz) == 0, "%s not stored / applied", zones[z]);
+
+        local_time_stats_t before;
+        local_time_get_stats(&before);
+        unsigned wrong = 0;
+        unsigned transitions = 0;
+        struct tm prev = { 0 };
+        for (time_t t = LOCAL_TIME_START; t < LOCAL_TIME_START + LOCAL_TIME_SPAN_S; t += LOCAL_TIME_STEP_S) {
+            wrong += check_local_second(&cache, t);
+            if (t != LOCAL_TIME_START && cache.tm.tm_isdst != prev.tm_isdst) {
+                // Walk back over the transition one second at a time, so the clock also steps backwards
+                transitions++;
+                for (time_t u = t - LOCAL_TIME_DENSE_S; u < t + LOCAL_TIME_DENSE_S; ++u) {
+                    wrong += check_local_second(&cache, u);
+                }
+            }
+            prev = cache.tm;
+        }
+
+        local_time_stats_t after;
+        local_time_get_stats(&after);
+        unsigned conversions = after.conversions - before.conversions;
+        printf("  %-20s %u transitions, %5u conversions, %3u searches\n", zones[z], transitions, conversions,
+               (unsigned)(after.searches - before.searches));
+        CHECK(wrong == 0, "%s: %u seconds differ from localtime_r()", zones[z], wrong);
+        // One per day, the zone change, the yearly re-search without DST, and a few per dense window
+        CHECK(conversions <= LOCAL_TIME_SPAN_S / 86400 + 4 + 6 * transitions, "%s: %u full conversions",
+              zones[z], conversions);
+    }
+    CHECK(local_time_set_tz(CONFIG_APP_TIMEZONE) == ESP_OK, "restore zone");
+}
+
+// ---------------------------------------------------------------- Benchmarks
+
+static volatile uint32_t s_sink;
+static uint32_t s_iter;
+
+typedef void (*bench_op_t)(void);
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void run_bench(const char *name, bench_op_t op)
+{
+    uint32_t n = 1;
+    uint64_t elapsed;
+    sim_bus_stats_t bus;
+    for (;;) {
+        sim_bus_reset_stats();
+        uint64_t start = now_ns();
+        for (uint32_t i = 0; i < n; ++i) {
+            op();
+        }
+        elapsed = now_ns() - start;
+        sim_bus_get_stats(&bus);
+        if (elapsed >= BENCH_MIN_NS || n >= BENCH_MAX_ITERATIONS) break;
+        n *= 4;
+    }
+
+    printf("  %-22s %9.1f ns/op", name, (double)elapsed / n);
+    if (bus.transactions) {
+        printf("   bus %5.1f tx %7.1f B %8.1f us /op", (double)bus.transactions / n,
+               (double)bus.wire_bytes / n, bus.bus_ns / 1000.0 / n);
+    }
+    printf("\n");
+}
+
+static void bench_format(void)
+{
+    char buf[12];
+    int32_t v = (int32_t)(s_iter++ * 37u % 400000u) - 200000;
+    s_sink += fixed_format(buf, sizeof(buf), v, 2, 1);
+    s_sink += fixed_format(buf, sizeof(buf), v * 5, 2, 2);
+}
+
+static void bench_quantize(void)
+{
+    static fixed_hold_t hold;
+    int32_t noise = (int32_t)(s_iter++ * 2654435761u >> 28) - 8;    // +-8 around 21.50 °C
+    s_sink += fixed_quantize(&hold, 2150 + noise, 10, CONFIG_APP_DISPLAY_HYST_TEMP_C100);
+}
+
+/** Seconds tick: one field update and a flush, as the render task does every second */
+static void bench_tick(void)
+{
+    char buf[12];
+    unsigned s = s_iter++ % 86400u;
+    snprintf(buf, sizeof(buf), "%02u:%02u:%02u", s / 3600, s / 60 % 60, s % 60);
+    set_field(TEXT_FIELD_TIME, buf);
+    display_flush();
+}
+
+/** New sample: quantize, format and draw three readings, flush */
+static void bench_readings(void)
+{
+    uint32_t i = s_iter++;
+    render_readings(2150 + (int32_t)(i % 40), 4500 + (int32_t)(i % 30) * 3, 101300 + (int32_t)(i % 50));
+    display_flush();
+}
+
+/** Every field drawn again from blank slots (init_screen()); only the changed pixels reach the bus */
+static void bench_full_redraw(void)
+{
+    init_screen();
+    set_field(TEXT_FIELD_TIME, (s_iter++ & 1) ? "12:34:56" : "21:43:65");
+    set_field(TEXT_FIELD_DATE, "2026-10-14");
+    render_readings(2150, 4520, 101325);
+    display_flush();
+}
+
+static void bench_snapshot(void)
+{
+    struct bme280_data in = { .temperature = 21.5 + (s_iter++ & 7), .pressure = 101325.0, .humidity = 45.2 };
+    sensor_snapshot_publish(&in);
+    sensor_snapshot_t out;
+    s_sink += sensor_snapshot_read(&out);
+    sim_rtos_take_notify();
+}
+
+static void bench_sched_merge(void)
+{
+    static uint8_t cmds[4][3];
+    i2c_sched_op_t ops[4];
+    for (size_t i = 0; i < 4; ++i) {
+        cmds[i][0] = 0x00;
+        cmds[i][1] = 0x81;
+        cmds[i][2] = (uint8_t)(s_iter + i);
+        ops[i] = (i2c_sched_op_t){ .dev = s_panel_dev, .tx = cmds[i], .tx_len = 3, .flags = I2C_SCHED_OP_MERGEABLE };
+    }
+    s_iter++;
+    s_sink += (uint32_t)i2c_sched_submit(ops, 4, I2C_SCHED_PRIO_NORMAL);
+}
+
+static void bench_sensor_round(void)
+{
+    uint32_t fresh;
+    sensor_registry_sample(&fresh);
+    s_sink += fresh;
+}
+
+static local_time_cache_t s_bench_time;
+
+/** Clock update per second before local_time.c: full conversion and two strftime() */
+static void bench_localtime_strftime(void)
+{
+    char buf[16];
+    time_t t = LOCAL_TIME_START + s_iter++;
+    struct tm tm;
+    localtime_r(&t, &tm);
+    s_sink += strftime(buf, sizeof(buf), "%H:%M:%S", &tm);
+    s_sink += strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+}
+
+static void bench_local_time(void)
+{
+    s_sink += (uint32_t)local_time_get(&s_bench_time, LOCAL_TIME_START + s_iter++)->tm_sec;
+}
+
+static void run_benchmarks(void)
+{
+    printf("benchmarks (host time; bus figures are simulated target cost)\n");
+    run_bench("fixed_format x2", bench_format);
+    run_bench("fixed_quantize", bench_quantize);
+    run_bench("localtime_r+strftime x2", bench_localtime_strftime);
+    run_bench("local_time_get", bench_local_time);
+    run_bench("snapshot publish+read", bench_snapshot);
+    run_bench("sched merge 4 cmds", bench_sched_merge);
+    run_bench("sensor round 2x", bench_sensor_round);
+    run_bench("frame: second tick", bench_tick);
+    run_bench("frame: readings", bench_readings);
+    run_bench("frame: re-rasterize all", bench_full_redraw);
+}
+
+int main(int argc, char **argv)
+{
+    bool check_only = false;
+    const char *pack_out = NULL;
+    setvbuf(stdout, NULL, _IOLBF, 0);   // keep stdout and the stderr log lines in order
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--check") == 0) {
+            check_only = true;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            sim_verbose = true;
+        } else if (strcmp(argv[i], "--pack-out") == 0 && i + 1 < argc) {
+            pack_out = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--check] [-v] [--pack-out FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    setup();
+    check_formatting();
+    check_frames();
+    check_panel_commands();
+    check_recovery();
+    check_graph_shift();
+    check_snapshot();
+    check_sensors();
+    check_history_pack(pack_out);
+    check_local_time();
+
+    if (!check_only) {
+        run_benchmarks();
+    }
+
+    if (s_failures) {
+        printf("%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
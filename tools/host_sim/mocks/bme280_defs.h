@@ -0,0 +1,34 @@
+/**
+ * @file bme280_defs.h
+ * @brief The result struct of the Bosch driver, in its default (double) variant.
+ */
+#ifndef SIM_BME280_DEFS_H
+#define SIM_BME280_DEFS_H
+
+#include <stdint.h>
+
+#define BME280_I2C_ADDR_PRIM        0x76
+#define BME280_I2C_ADDR_SEC         0x77
+#define BME280_POWERMODE_FORCED     0x01
+
+#if !defined(BME280_64BIT_ENABLE) && !defined(BME280_32BIT_ENABLE) && !defined(BME280_DOUBLE_ENABLE)
+#define BME280_DOUBLE_ENABLE
+#endif
+
+struct bme280_data {
+#ifdef BME280_DOUBLE_ENABLE
+    double pressure;
+    double temperature;
+    double humidity;
+#else
+    uint32_t pressure;
+    int32_t temperature;
+    uint32_t humidity;
+#endif
+};
+
+struct bme280_dev {
+    void *intf_ptr;
+};
+
+#endif // SIM_BME280_DEFS_H
@@ -0,0 +1,17 @@
+/**
+ * @file config.h
+ * @brief The part of the ssd1306-oled component's config.h the simulated sources use.
+ */
+#ifndef SIM_CONFIG_H
+#define SIM_CONFIG_H
+
+#define WIDTH               128
+#define HEIGHT              64
+#define PIXELS_PER_PAGE     8
+#define I2C_TIMEOUT_MS      100
+
+typedef enum {
+    FORCED_PERIODIC_ONE_TIME,
+} measurement_choice_t;
+
+#endif // SIM_CONFIG_H
@@ -0,0 +1,9 @@
+#ifndef SIM_DRIVER_GPIO_H
+#define SIM_DRIVER_GPIO_H
+
+typedef enum {
+    GPIO_NUM_22 = 22,
+    GPIO_NUM_23 = 23,
+} gpio_num_t;
+
+#endif // SIM_DRIVER_GPIO_H
@@ -0,0 +1,30 @@
+/**
+ * @file i2c_master.h
+ * @brief The ESP-IDF I2C master calls the simulated sources make; sim_bus.c implements them.
+ */
+#ifndef SIM_DRIVER_I2C_MASTER_H
+#define SIM_DRIVER_I2C_MASTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+typedef struct i2c_master_bus_t *i2c_master_bus_handle_t;
+typedef struct i2c_master_dev_t *i2c_master_dev_handle_t;
+
+typedef enum {
+    I2C_NUM_0,
+    I2C_NUM_1,
+} i2c_port_num_t;
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t *write_buffer, size_t write_size,
+                              int xfer_timeout_ms);
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t dev, uint8_t *read_buffer, size_t read_size,
+                             int xfer_timeout_ms);
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t dev, const uint8_t *write_buffer, size_t write_size,
+                                      uint8_t *read_buffer, size_t read_size, int xfer_timeout_ms);
+esp_err_t i2c_master_bus_reset(i2c_master_bus_handle_t bus);
+
+#endif // SIM_DRIVER_I2C_MASTER_H
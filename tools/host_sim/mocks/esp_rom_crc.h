@@ -0,0 +1,22 @@
+#ifndef SIM_ESP_ROM_CRC_H
+#define SIM_ESP_ROM_CRC_H
+
+#include <stdint.h>
+
+/**
+ * @brief Bitwise CRC-32 (reflected, 0xEDB88320) with the ROM routine's chaining:
+ *        the inversion is applied on entry and exit, so results match zlib.crc32().
+ */
+static inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+#endif // SIM_ESP_ROM_CRC_H
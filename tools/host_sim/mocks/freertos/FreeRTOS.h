@@ -0,0 +1,35 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Single-threaded FreeRTOS stand-in: the simulator runs everything on the caller's thread.
+ */
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  1
+#define pdFAIL                  0
+#define portMAX_DELAY           0xFFFFFFFFu
+#define configTICK_RATE_HZ      CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS      (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define tskNO_AFFINITY          0x7FFFFFFF
+
+/** No other thread exists, so critical sections are empty */
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+#define portENTER_CRITICAL(mux)         ((void)(mux))
+#define portEXIT_CRITICAL(mux)          ((void)(mux))
+
+#endif // SIM_FREERTOS_H
@@ -0,0 +1,17 @@
+#ifndef SIM_I2C_BUS_H
+#define SIM_I2C_BUS_H
+
+#include <stdint.h>
+
+#include "driver/i2c_master.h"
+
+typedef struct {
+    i2c_master_bus_handle_t bus;
+} i2c_bus_t;
+
+/**
+ * @brief Address-only transaction; ESP_OK if a simulated device answers at @p addr.
+ */
+esp_err_t i2c_device_probe(const i2c_bus_t *bus, uint8_t addr, int timeout_ms);
+
+#endif // SIM_I2C_BUS_H
@@ -0,0 +1,61 @@
+/**
+ * @file mock_history.c
+ * @brief The part of sensor_history.h that graph_screen.c reads, over a synthetic ring.
+ *
+ * @details
+ * Sample n is a slow sine on each channel, so every strip of the graph spans
+ * its full height. sim_history_set_total() says how many have been appended;
+ * the newest SENSOR_HISTORY_LEN of them are "held".
+ */
+
+#include <math.h>
+
+#include "sensor_history.h"
+#include "sim.h"
+
+static uint32_t s_total;
+
+void sim_history_set_total(uint32_t total)
+{
+    s_total = total;
+}
+
+static sensor_sample_t sample(uint32_t n)
+{
+    double phase = n / 90.0;
+    return (sensor_sample_t){
+        .timestamp = 1760000000u + n * 5u / 2u,
+        .temperature_c100 = (int16_t)lrint(2150 + 300 * sin(phase)),
+        .humidity_c100 = (uint16_t)lrint(4500 + 800 * cos(phase)),
+        .pressure_pa = (uint32_t)lrint(101300 + 250 * sin(phase / 2)),
+    };
+}
+
+size_t sensor_history_count(void)
+{
+    return (s_total < SENSOR_HISTORY_LEN) ? s_total : SENSOR_HISTORY_LEN;
+}
+
+uint32_t sensor_history_total(void)
+{
+    return s_total;
+}
+
+bool sensor_history_mean(uint32_t end, size_t count, sensor_sample_t *out)
+{
+    if (count == 0 || end > s_total || s_total - end + count > sensor_history_count()) {
+        return false;
+    }
+    int64_t t = 0, h = 0, p = 0;
+    for (uint32_t n = end - (uint32_t)count; n < end; ++n) {
+        sensor_sample_t s = sample(n);
+        t += s.temperature_c100;
+        h += s.humidity_c100;
+        p += s.pressure_pa;
+    }
+    *out = sample(end - 1);
+    out->temperature_c100 = (int16_t)(t / (int64_t)count);
+    out->humidity_c100 = (uint16_t)(h / (int64_t)count);
+    out->pressure_pa = (uint32_t)(p / (int64_t)count);
+    return true;
+}
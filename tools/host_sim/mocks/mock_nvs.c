@@ -0,0 +1,72 @@
+/**
+ * @file mock_nvs.c
+ * @brief The in-memory NVS of mocks/nvs.h.
+ */
+
+#include <string.h>
+
+#include "nvs.h"
+
+#define SIM_NVS_KEYS        8
+#define SIM_NVS_KEY_MAX     16      /**< NVS_KEY_NAME_MAX_SIZE */
+#define SIM_NVS_VALUE_MAX   128
+
+static struct {
+    char key[SIM_NVS_KEY_MAX];
+    char value[SIM_NVS_VALUE_MAX];
+} s_entries[SIM_NVS_KEYS];
+
+static int find(const char *key)
+{
+    for (int i = 0; i < SIM_NVS_KEYS; ++i) {
+        if (s_entries[i].key[0] && strcmp(s_entries[i].key, key) == 0) return i;
+    }
+    return -1;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out)
+{
+    *out = 1;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out, size_t *len)
+{
+    int i = find(key);
+    if (i < 0) return ESP_ERR_NVS_NOT_FOUND;
+    size_t need = strlen(s_entries[i].value) + 1;
+    if (out) {
+        if (*len < need) return ESP_ERR_INVALID_SIZE;
+        memcpy(out, s_entries[i].value, need);
+    }
+    *len = need;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    if (strlen(key) >= SIM_NVS_KEY_MAX || strlen(value) >= SIM_NVS_VALUE_MAX) return ESP_ERR_INVALID_ARG;
+    int i = find(key);
+    for (int j = 0; i < 0 && j < SIM_NVS_KEYS; ++j) {
+        if (!s_entries[j].key[0]) i = j;
+    }
+    if (i < 0) return ESP_ERR_NO_MEM;
+    strcpy(s_entries[i].key, key);
+    strcpy(s_entries[i].value, value);
+    return ESP_OK;
+}
+
+const char *sim_nvs_peek(const char *key)
+{
+    int i = find(key);
+    return i < 0 ? NULL : s_entries[i].value;
+}
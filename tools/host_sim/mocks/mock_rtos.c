@@ -0,0 +1,151 @@
+/**
+ * @file mock_rtos.c
+ * @brief Host implementations of the FreeRTOS, esp_timer, esp_err and esp_log calls in mocks/.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "sim.h"
+
+static TickType_t s_ticks;
+static uint32_t s_notify_bits;
+static uint32_t s_notify_count[2];
+static int s_task;      /**< Its address is the one task handle */
+
+bool sim_verbose;
+
+void sim_log(char level, const char *tag, const char *fmt, ...)
+{
+    if (!sim_verbose && level != 'E' && level != 'W') {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%c (%s) ", level, tag);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                    return "ESP_OK";
+    case ESP_FAIL:                  return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE:  return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:       return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_NOT_FINISHED:      return "ESP_ERR_NOT_FINISHED";
+    default:                        return "UNKNOWN ERROR";
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *out, BaseType_t core)
+{
+    (void)fn; (void)name; (void)stack; (void)arg; (void)prio; (void)core;
+    if (out) {
+        *out = NULL;
+    }
+    return pdFAIL;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    s_ticks += ticks;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return s_ticks;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)&s_task;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    (void)task;
+    if (action == eSetBits) {
+        s_notify_bits |= value;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index)
+{
+    (void)task;
+    s_notify_count[index ? 1 : 0]++;
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return xTaskNotifyGiveIndexed(task, 0);
+}
+
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t wait)
+{
+    (void)wait;
+    uint32_t *count = &s_notify_count[index ? 1 : 0];
+    uint32_t value = *count;
+    if (value) {
+        *count = clear ? 0 : value - 1;
+    }
+    return value;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait)
+{
+    return ulTaskNotifyTakeIndexed(0, clear, wait);
+}
+
+uint32_t sim_rtos_take_notify(void)
+{
+    uint32_t bits = s_notify_bits;
+    s_notify_bits = 0;
+    return bits;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    (void)length; (void)item_size;
+    return NULL;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    (void)queue; (void)item; (void)wait;
+    return pdFAIL;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    (void)queue; (void)item; (void)wait;
+    return pdFALSE;
+}
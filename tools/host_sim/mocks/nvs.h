@@ -0,0 +1,30 @@
+#ifndef SIM_NVS_H
+#define SIM_NVS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define ESP_ERR_NVS_NOT_FOUND   0x1102
+
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+
+/**
+ * @brief In-memory NVS with string values only, lost at exit: what local_time.c uses.
+ *
+ * Namespaces are ignored; every handle sees the same keys.
+ */
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_commit(nvs_handle_t handle);
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out, size_t *len);
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value);
+
+/**
+ * @brief Value stored under @p key, or NULL.
+ */
+const char *sim_nvs_peek(const char *key);
+
+#endif // SIM_NVS_H
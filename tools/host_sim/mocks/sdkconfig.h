@@ -0,0 +1,42 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host stand-in for the generated sdkconfig.h: the options the simulated sources read.
+ *
+ * Values follow the repository's sdkconfig. The panel height comes from the
+ * SIM_PANEL_HEIGHT cache variable of tools/host_sim/CMakeLists.txt.
+ */
+#ifndef SIM_SDKCONFIG_H
+#define SIM_SDKCONFIG_H
+
+#ifndef SIM_PANEL_HEIGHT
+#define SIM_PANEL_HEIGHT 64
+#endif
+
+#define CONFIG_COMMON_I2C_SSD1306_HEIGHT        SIM_PANEL_HEIGHT
+#define CONFIG_COMMON_I2C_SSD1306_SCL_HZ        400000
+#define CONFIG_COMMON_I2C_BME280_SCL_HZ         400000
+#define CONFIG_COMMON_I2C_RETRIES               2
+#define CONFIG_COMMON_I2C_OFFLINE_BACKOFF_MS    1000
+#define CONFIG_COMMON_I2C_SCHED_TASK_PRIO       7
+#define CONFIG_COMMON_I2C_SCHED_TASK_CORE       1
+#define CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES 2
+#define CONFIG_FREERTOS_HZ                      100
+#define CONFIG_APP_DISPLAY_HYST_TEMP_C100       3
+#define CONFIG_APP_DISPLAY_HYST_HUM_C100        5
+#define CONFIG_APP_DISPLAY_HYST_PRES_PA         1
+#define CONFIG_APP_TIMEZONE                     "EET-2EEST,M3.5.0/3,M10.5.0/4"
+#define CONFIG_APP_PANEL_SHIFT                  1
+#if SIM_PANEL_HEIGHT == 32
+#define CONFIG_APP_PANEL_SHIFT_ROWS             1
+#else
+#define CONFIG_APP_PANEL_SHIFT_ROWS             2
+#endif
+#define CONFIG_APP_GRAPH_SCREEN                 1
+#define CONFIG_APP_GRAPH_SAMPLES_PER_COLUMN     12
+#define CONFIG_APP_HISTORY_SAMPLES              1440
+#define CONFIG_APP_HISTORY_PACK_BLOCK_SAMPLES   1024
+#define CONFIG_APP_HISTORY_PACK_TEMP_STEP_C100  10
+#define CONFIG_APP_HISTORY_PACK_HUM_STEP_C100   10
+#define CONFIG_APP_HISTORY_PACK_PRES_STEP_PA    10
+
+#endif // SIM_SDKCONFIG_H
@@ -0,0 +1,26 @@
+#ifndef SIM_COMPAT_H
+#define SIM_COMPAT_H
+
+/**
+ * @file sim_compat.h
+ * @brief Force-included into every host_sim source: libc functions newlib has and older glibc lacks.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+static inline size_t sim_strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#define strlcpy sim_strlcpy
+#endif
+
+#endif // SIM_COMPAT_H
@@ -0,0 +1,16 @@
+/**
+ * @file ssd1306.h
+ * @brief Empty stand-in: the simulator drives the panel through display.c only.
+ */
+#ifndef SIM_SSD1306_H
+#define SIM_SSD1306_H
+
+#include "i2c_bus.h"
+
+#define SSD1306_I2C_ADDR_DEFAULT    0x3C
+
+typedef struct {
+    int unused;
+} ssd1306_t;
+
+#endif // SIM_SSD1306_H
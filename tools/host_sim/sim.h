@@ -0,0 +1,138 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+
+#include "sensor_registry.h"
+
+/**
+ * @file sim.h
+ * @brief Simulated I2C bus, SSD1306 and BME280 for the host build (tools/host_sim).
+ *
+ * @details
+ * The mocked i2c_master_* calls route each transaction to the device model
+ * attached at that handle and account for what it would cost on the wire:
+ * the address byte, the payload, a repeated start with a second address byte
+ * for write-then-read, and 9 SCL periods per byte at the device's clock.
+ */
+
+extern bool sim_verbose;    /**< Print info/debug logs as well (host_sim -v) */
+
+/**
+ * @brief What one device does with the bytes of a transaction whose address it acknowledged.
+ */
+typedef struct {
+    esp_err_t (*write)(void *model, const uint8_t *data, size_t len);
+    esp_err_t (*read)(void *model, uint8_t *data, size_t len);
+} sim_device_ops_t;
+
+/**
+ * @brief Traffic as it would appear on the wire, address bytes included.
+ */
+typedef struct {
+    uint32_t transactions;      /**< START ... STOP sequences, probes included */
+    uint32_t wire_bytes;        /**< Address and payload bytes, each followed by an ACK bit */
+    uint64_t bus_ns;            /**< SCL time at each device's clock, START/STOP included */
+    uint32_t nacks;             /**< Transactions a device did not acknowledge */
+    uint32_t resets;            /**< i2c_master_bus_reset() clock-outs */
+} sim_bus_stats_t;
+
+/**
+ * @brief Put a device model on the bus.
+ *
+ * @return The handle to hand to the code under test, as i2c_master_bus_add_device() would.
+ */
+i2c_master_dev_handle_t sim_bus_attach(uint16_t addr, uint32_t scl_hz, const sim_device_ops_t *ops, void *model);
+
+/**
+ * @brief Let the next @p count transactions to @p dev fail with an address NACK.
+ */
+void sim_bus_fail_next(i2c_master_dev_handle_t dev, unsigned count);
+
+void sim_bus_get_stats(sim_bus_stats_t *out);
+void sim_bus_reset_stats(void);
+
+#define SIM_GDDRAM_PAGES    8
+#define SIM_GDDRAM_COLUMNS  128
+
+/**
+ * @brief SSD1306 controller state: GDDRAM and the addressing registers display.c uses.
+ */
+typedef struct {
+    uint8_t gddram[SIM_GDDRAM_PAGES][SIM_GDDRAM_COLUMNS];
+    uint8_t mode;               /**< 0x20 argument: 0 horizontal, 1 vertical, 2 page */
+    uint8_t col_start, col_end, page_start, page_end;
+    uint8_t col, page;          /**< GDDRAM pointer */
+    uint8_t contrast;
+    uint8_t start_line;
+    bool display_on;
+    uint32_t data_bytes;        /**< GDDRAM bytes written */
+    uint32_t protocol_errors;   /**< Unknown control bytes or commands cut short */
+} sim_ssd1306_t;
+
+extern const sim_device_ops_t sim_ssd1306_ops;
+
+/**
+ * @brief Power-on state; GDDRAM is filled with a pattern, as real panels come up with noise.
+ */
+void sim_ssd1306_reset(sim_ssd1306_t *panel);
+
+static inline bool sim_ssd1306_pixel(const sim_ssd1306_t *panel, unsigned x, unsigned y)
+{
+    return (panel->gddram[y / 8][x] >> (y % 8)) & 1u;
+}
+
+#define SIM_BME280_CHIP_ID      0x60
+
+/**
+ * @brief BME280 register file, reporting fixed readings.
+ *
+ * @details
+ * A ctrl_meas write with forced mode runs one conversion at once; normal mode
+ * converts on every data read. The data registers carry the readings in a
+ * simulator encoding (sim_bme280_driver decodes it) rather than Bosch raw
+ * values, since the compensation code lives in the external driver.
+ */
+typedef struct {
+    uint8_t regs[256];
+    uint8_t ptr;                /**< Register pointer, auto-incremented on reads */
+    int32_t temperature_c100;
+    uint32_t humidity_c100;
+    uint32_t pressure_pa;
+    unsigned measuring_reads;   /**< Status reads that still show "measuring" after each trigger */
+    unsigned busy_left;
+    uint32_t conversions;
+} sim_bme280_t;
+
+extern const sim_device_ops_t sim_bme280_ops;
+
+void sim_bme280_reset(sim_bme280_t *sensor);
+
+/**
+ * @brief sensor_registry.h driver for a simulated BME280, with the same bus traffic as bme280_sensor.c.
+ *
+ * One ctrl_meas write per trigger, one 12-byte burst from the status register per collect.
+ */
+typedef struct {
+    i2c_master_dev_handle_t dev;
+    uint8_t trigger_cmd[2];
+    uint8_t read_reg;
+    uint8_t raw[12];
+    int32_t temperature_c100;
+    uint32_t humidity_c100;
+    uint32_t pressure_pa;
+} sim_bme280_sensor_t;
+
+extern const sensor_driver_t sim_bme280_driver;
+
+/**
+ * @brief Number of samples appended to the synthetic history of mocks/mock_history.c.
+ */
+void sim_history_set_total(uint32_t total);
+
+#endif // SIM_H
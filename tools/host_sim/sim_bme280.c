@@ -0,0 +1,170 @@
+/**
+ * @file sim_bme280.c
+ * @brief BME280 register model and the matching sensor_registry.h driver.
+ *
+ * @details
+ * The model answers the accesses bme280_sensor.c makes per sample: a
+ * ctrl_meas write to start a forced conversion and a burst read from the
+ * status register through hum_lsb. Writes follow the BME280 protocol
+ * (register address, then value, repeated); a lone address byte only moves
+ * the register pointer for the next read.
+ *
+ * Data register encoding (simulator only):
+ *   - press (20 bit): pressure in Pa
+ *   - temp (20 bit): temperature in 0.01 °C + @ref SIM_TEMP_OFFSET
+ *   - hum (16 bit): humidity in 0.01 %RH
+ */
+
+#include <string.h>
+
+#include "esp_check.h"
+
+#include "sim.h"
+
+static const char *TAG_SIM_BME = "SIM_BME280";
+
+#define REG_CHIP_ID         0xD0
+#define REG_STATUS          0xF3
+#define REG_CTRL_MEAS       0xF4
+#define REG_DATA            0xF7
+#define STATUS_MEASURING    0x08
+#define MODE_MASK           0x03
+#define MODE_FORCED         0x01
+#define MODE_NORMAL         0x03
+#define BURST_LEN           12      /**< status through hum_lsb, as BME280_SENSOR_BURST_LEN */
+#define DATA_OFFSET         (REG_DATA - REG_STATUS)
+#define SIM_TEMP_OFFSET     100000  /**< Keeps the 20-bit temperature field positive */
+
+static void put20(uint8_t *r, uint32_t v)
+{
+    r[0] = (uint8_t)(v >> 12);
+    r[1] = (uint8_t)(v >> 4);
+    r[2] = (uint8_t)(v << 4);
+}
+
+static uint32_t get20(const uint8_t *r)
+{
+    return ((uint32_t)r[0] << 12) | ((uint32_t)r[1] << 4) | (r[2] >> 4);
+}
+
+static void convert(sim_bme280_t *s)
+{
+    uint8_t *d = &s->regs[REG_DATA];
+    put20(&d[0], s->pressure_pa);
+    put20(&d[3], (uint32_t)(s->temperature_c100 + SIM_TEMP_OFFSET));
+    d[6] = (uint8_t)(s->humidity_c100 >> 8);
+    d[7] = (uint8_t)s->humidity_c100;
+    s->conversions++;
+}
+
+static esp_err_t bme280_write(void *model, const uint8_t *data, size_t len)
+{
+    sim_bme280_t *s = model;
+    if (len == 1) {
+        s->ptr = data[0];
+        return ESP_OK;
+    }
+
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        uint8_t reg = data[i];
+        s->regs[reg] = data[i + 1];
+        if (reg == REG_CTRL_MEAS && (data[i + 1] & MODE_MASK) && (data[i + 1] & MODE_MASK) != MODE_NORMAL) {
+            convert(s);
+            s->busy_left = s->measuring_reads;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t bme280_read(void *model, uint8_t *data, size_t len)
+{
+    sim_bme280_t *s = model;
+    if ((s->regs[REG_CTRL_MEAS] & MODE_MASK) == MODE_NORMAL && s->ptr <= REG_DATA && s->ptr + len > REG_DATA) {
+        convert(s);
+    }
+
+    s->regs[REG_STATUS] = s->busy_left ? STATUS_MEASURING : 0;
+    if (s->busy_left && s->ptr <= REG_STATUS && s->ptr + len > REG_STATUS) {
+        s->busy_left--;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        data[i] = s->regs[(uint8_t)(s->ptr + i)];
+    }
+    return ESP_OK;
+}
+
+const sim_device_ops_t sim_bme280_ops = {
+    .write = bme280_write,
+    .read = bme280_read,
+};
+
+void sim_bme280_reset(sim_bme280_t *sensor)
+{
+    memset(sensor->regs, 0, sizeof(sensor->regs));
+    sensor->regs[REG_CHIP_ID] = SIM_BME280_CHIP_ID;
+    sensor->regs[REG_DATA + 3] = 0x80;  // temp_msb reset value: no conversion yet
+    sensor->ptr = 0;
+    sensor->busy_left = 0;
+    sensor->conversions = 0;
+}
+
+// ---- Registry driver, op for op like bme280_sensor.c in forced mode
+
+static esp_err_t sim_sensor_init(void *ctx)
+{
+    sim_bme280_sensor_t *s = ctx;
+    uint8_t reg = REG_CHIP_ID;
+    uint8_t id = 0;
+    ESP_RETURN_ON_ERROR(i2c_master_transmit_receive(s->dev, &reg, 1, &id, 1, 100), TAG_SIM_BME, "chip id");
+    ESP_RETURN_ON_FALSE(id == SIM_BME280_CHIP_ID, ESP_ERR_NOT_FOUND, TAG_SIM_BME, "chip id 0x%02X", id);
+
+    s->trigger_cmd[0] = REG_CTRL_MEAS;
+    s->trigger_cmd[1] = (uint8_t)((1 << 5) | (1 << 2) | MODE_FORCED);  // osr_t x1, osr_p x1
+    s->read_reg = REG_STATUS;
+    return ESP_OK;
+}
+
+static size_t sim_sensor_trigger(void *ctx, i2c_sched_op_t *ops, size_t max, uint32_t *wait_us)
+{
+    sim_bme280_sensor_t *s = ctx;
+    if (max < 1) return 0;
+
+    ops[0] = (i2c_sched_op_t){ .dev = s->dev, .tx = s->trigger_cmd, .tx_len = sizeof(s->trigger_cmd) };
+    *wait_us = 9300;    // osr x1 for t, p and h: datasheet maximum
+    return 1;
+}
+
+static size_t sim_sensor_collect_ops(void *ctx, i2c_sched_op_t *ops, size_t max)
+{
+    sim_bme280_sensor_t *s = ctx;
+    if (max < 1) return 0;
+
+    ops[0] = (i2c_sched_op_t){
+        .dev = s->dev, .tx = &s->read_reg, .tx_len = 1, .rx = s->raw, .rx_len = BURST_LEN,
+    };
+    return 1;
+}
+
+static esp_err_t sim_sensor_collect(void *ctx)
+{
+    sim_bme280_sensor_t *s = ctx;
+    if (s->raw[0] & STATUS_MEASURING) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+
+    const uint8_t *d = &s->raw[DATA_OFFSET];
+    if (get20(&d[3]) == 0x80000) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    s->pressure_pa = get20(&d[0]);
+    s->temperature_c100 = (int32_t)get20(&d[3]) - SIM_TEMP_OFFSET;
+    s->humidity_c100 = ((uint32_t)d[6] << 8) | d[7];
+    return ESP_OK;
+}
+
+const sensor_driver_t sim_bme280_driver = {
+    .init = sim_sensor_init,
+    .trigger = sim_sensor_trigger,
+    .collect_ops = sim_sensor_collect_ops,
+    .collect = sim_sensor_collect,
+};
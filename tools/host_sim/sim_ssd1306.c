@@ -0,0 +1,173 @@
+/**
+ * @file sim_ssd1306.c
+ * @brief SSD1306 model: command parser and GDDRAM with the controller's pointer arithmetic.
+ *
+ * @details
+ * Every write starts with a control byte: 0x00 for a command stream, 0x40
+ * for GDDRAM data. Commands must be complete within one transaction, as the
+ * controller drops a half-received command at STOP; one that is cut short
+ * counts as a protocol error, so a bad merge in the bus scheduler shows up.
+ */
+
+#include <string.h>
+
+#include "sim.h"
+
+#define CTRL_CMD_STREAM     0x00
+#define CTRL_DATA_STREAM    0x40
+
+#define MODE_HORIZONTAL     0
+#define MODE_VERTICAL       1
+#define MODE_PAGE           2
+
+/**
+ * @brief Argument bytes following command @p cmd.
+ */
+static size_t command_args(uint8_t cmd)
+{
+    switch (cmd) {
+    case 0x20:  // memory mode
+    case 0x81:  // contrast
+    case 0x8D:  // charge pump
+    case 0xA8:  // multiplex ratio
+    case 0xD3:  // display offset
+    case 0xD5:  // clock divide
+    case 0xD9:  // pre-charge
+    case 0xDA:  // COM pins
+    case 0xDB:  // VCOMH
+        return 1;
+    case 0x21:  // column range
+    case 0x22:  // page range
+    case 0xA3:  // vertical scroll area
+        return 2;
+    case 0x29:  // vertical + horizontal scroll
+    case 0x2A:
+        return 5;
+    case 0x26:  // horizontal scroll
+    case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+static void run_command(sim_ssd1306_t *p, const uint8_t *cmd)
+{
+    switch (cmd[0]) {
+    case 0x20:
+        p->mode = cmd[1] & 0x03;
+        break;
+    case 0x21:
+        p->col_start = cmd[1] & 0x7F;
+        p->col_end = cmd[2] & 0x7F;
+        p->col = p->col_start;
+        break;
+    case 0x22:
+        p->page_start = cmd[1] & 0x07;
+        p->page_end = cmd[2] & 0x07;
+        p->page = p->page_start;
+        break;
+    case 0x81:
+        p->contrast = cmd[1];
+        break;
+    case 0xAE:
+    case 0xAF:
+        p->display_on = cmd[0] & 1;
+        break;
+    default:
+        if (cmd[0] >= 0x40 && cmd[0] <= 0x7F) {
+            p->start_line = cmd[0] & 0x3F;
+        } else if (p->mode == MODE_PAGE && cmd[0] >= 0xB0 && cmd[0] <= 0xB7) {
+            p->page = cmd[0] & 0x07;
+        } else if (p->mode == MODE_PAGE && cmd[0] <= 0x0F) {
+            p->col = (uint8_t)((p->col & 0xF0) | cmd[0]);
+        } else if (p->mode == MODE_PAGE && cmd[0] >= 0x10 && cmd[0] <= 0x17) {
+            p->col = (uint8_t)(((cmd[0] & 0x07) << 4) | (p->col & 0x0F));
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Store one data byte and advance the pointer as the selected addressing mode does.
+ */
+static void write_data(sim_ssd1306_t *p, uint8_t byte)
+{
+    p->gddram[p->page][p->col] = byte;
+    p->data_bytes++;
+
+    switch (p->mode) {
+    case MODE_HORIZONTAL:
+        if (p->col < p->col_end) {
+            p->col++;
+        } else {
+            p->col = p->col_start;
+            p->page = (p->page < p->page_end) ? p->page + 1 : p->page_start;
+        }
+        break;
+    case MODE_VERTICAL:
+        if (p->page < p->page_end) {
+            p->page++;
+        } else {
+            p->page = p->page_start;
+            p->col = (p->col < p->col_end) ? p->col + 1 : p->col_start;
+        }
+        break;
+    default:
+        p->col = (p->col + 1) % SIM_GDDRAM_COLUMNS;
+        break;
+    }
+}
+
+static esp_err_t ssd1306_write(void *model, const uint8_t *data, size_t len)
+{
+    sim_ssd1306_t *p = model;
+    if (len == 0) {
+        return ESP_OK;
+    }
+
+    if (data[0] == CTRL_DATA_STREAM) {
+        for (size_t i = 1; i < len; ++i) {
+            write_data(p, data[i]);
+        }
+        return ESP_OK;
+    }
+    if (data[0] != CTRL_CMD_STREAM) {
+        p->protocol_errors++;
+        return ESP_OK;
+    }
+
+    for (size_t i = 1; i < len;) {
+        size_t need = 1 + command_args(data[i]);
+        if (i + need > len) {
+            p->protocol_errors++;
+            break;
+        }
+        run_command(p, &data[i]);
+        i += need;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ssd1306_read(void *model, uint8_t *data, size_t len)
+{
+    (void)model;
+    memset(data, 0, len);   // status byte reads are not used by the firmware
+    return ESP_OK;
+}
+
+const sim_device_ops_t sim_ssd1306_ops = {
+    .write = ssd1306_write,
+    .read = ssd1306_read,
+};
+
+void sim_ssd1306_reset(sim_ssd1306_t *panel)
+{
+    *panel = (sim_ssd1306_t){
+        .mode = MODE_PAGE,
+        .col_end = SIM_GDDRAM_COLUMNS - 1,
+        .page_end = SIM_GDDRAM_PAGES - 1,
+        .contrast = 0x7F,
+    };
+    memset(panel->gddram, 0xA5, sizeof(panel->gddram));
+}